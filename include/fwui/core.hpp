@@ -1,15 +1,19 @@
 #pragma once
 
 #include <algorithm>
+#include <functional>
 #include <map>
 #include <memory>
 #include <set>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include <fmt/core.h>
 #include <nlohmann/json.hpp>
 
+#include "style_block.hpp"
+
 namespace fwui {
 
 class Node;
@@ -29,9 +33,17 @@ public:
     Element SetTag(const std::string& tag);
 
     // --- Text content (for leaf nodes) ---
-    const std::string& TextContent() const;
+    // A copy, so shared text is never materialized inside a node other
+    // threads may be rendering; read it in place through TextView().
+    std::string TextContent() const;
     Element SetTextContent(const std::string& content);
 
+    // Text backed by an immutable buffer owned elsewhere (e.g. FileCache) —
+    // shared between nodes instead of copied. `text` must stay valid for as
+    // long as `owner` is alive. Renderers read it through TextView().
+    Element SetSharedText(std::shared_ptr<const void> owner, std::string_view text);
+    std::string_view TextView() const;
+
     // --- Attributes ---
     Element SetAttribute(const std::string& key, const std::string& value);
     Element RemoveAttribute(const std::string& key);
@@ -56,9 +68,14 @@ public:
     Element RemoveStyle(const std::string& property);
     std::string GetStyle(const std::string& property) const;
     Element SetStyleString(const std::string& full_style);
-    std::string StyleString() const;
+    const std::string& StyleString() const;
     const std::map<std::string, std::string>& Styles() const;
 
+    // Interned style block shared with every node that has the same styles
+    // (nullptr when the node has none).
+    const StyleBlockPtr& SharedStyles() const;
+    Element SetSharedStyles(StyleBlockPtr styles);
+
     // --- Children ---
     Element AppendChild(Element child);
     Element PrependChild(Element child);
@@ -70,6 +87,23 @@ public:
     // --- Parent ---
     std::weak_ptr<Node> Parent() const;
 
+    // --- Deferred content ---
+    // Deferred nodes (lazy()) produce their content at render time instead of
+    // holding children. Renderers call ForEachDeferred() only on a cache miss,
+    // so a cached ancestor never runs the deferred work.
+    virtual bool IsDeferred() const { return false; }
+    virtual void ForEachDeferred(const std::function<void(const Element&)>& visit) const {}
+    // Streamed nodes (for_each_row()) are deferred nodes whose rows are
+    // produced, rendered and dropped one at a time. Neither they nor their
+    // ancestors are cached.
+    virtual bool IsStreamed() const { return false; }
+    // Slot nodes (slot()) are deferred nodes whose content comes from a task;
+    // HtmlRenderer::RenderStream() sends it after the rest of the page.
+    virtual bool IsSlot() const { return false; }
+    // Raw sink nodes (raw_sink()) are deferred nodes that write raw HTML
+    // straight into HtmlRenderer's output buffer.
+    virtual bool IsRawSink() const { return false; }
+
     // --- Render cache ---
     const std::string& HtmlCache() const;
     void SetHtmlCache(std::string html) const;
@@ -84,14 +118,19 @@ public:
     Element ClearAttributes();
 
     // --- Deep copy ---
-    Element Clone() const;
+    virtual Element Clone() const;
+    // This node alone, sharing its children (their Parent() stays the
+    // original) and carrying its render cache over. Changing the copy leaves
+    // the original alone; its children are still shared. Deferred nodes are
+    // cloned deeply.
+    Element ShallowClone() const;
 
     // --- Raw HTML ---
     bool IsRaw() const;
     Element SetRaw(bool raw);
 
     // --- Utilities ---
-    static std::string EscapeHTML(const std::string& text);
+    static std::string EscapeHTML(std::string_view text);
 
     // --- Serialization ---
     nlohmann::json ToJSON() const;
@@ -99,12 +138,14 @@ public:
 
 protected:
     std::string tag_;
-    std::string text_content_;
-    bool        is_raw_ = false;
-
-    Attrs                              attributes_;
-    std::map<std::string, std::string> styles_;
-    std::vector<std::string>           classes_;
+    std::string                 text_content_;  // unused while text_owner_ is set
+    std::shared_ptr<const void> text_owner_;
+    std::string_view            text_view_;
+    bool                        is_raw_ = false;
+
+    Attrs                    attributes_;
+    StyleBlockPtr            styles_;
+    std::vector<std::string> classes_;
 
     Elements            children_;
     std::weak_ptr<Node> parent_;
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+namespace fwui {
+
+// Read-only stack of JSON layers, lowest priority first:
+//
+//   DataContext(global).With(page).With(runtime)
+//
+// Layers are shared, never copied. Lookups resolve from the top layer down
+// with merge-patch semantics: a higher layer wins, `null` deletes, a
+// non-object shadows everything below it.
+class DataContext {
+public:
+    using Layer = std::shared_ptr<const nlohmann::json>;
+
+    DataContext() = default;
+    explicit DataContext(Layer base);
+
+    // New context with `layer` on top; shares the layers below
+    DataContext With(Layer layer) const;
+    DataContext With(nlohmann::json layer) const;
+
+    // Value at `key` / `pointer`, or nullptr. Objects come from the highest
+    // layer that has them and are not merged with lower ones (see Flatten()).
+    const nlohmann::json* Find(std::string_view key) const;
+    const nlohmann::json* Find(const nlohmann::json::json_pointer& pointer) const;
+    bool Contains(std::string_view key) const { return Find(key) != nullptr; }
+
+    // All layers as one object (merge_patch of each layer over the ones
+    // below). Returns a layer as is, without copying, when it is the only
+    // non-empty one.
+    Layer Flatten() const;
+
+    size_t Depth() const { return layers_.size(); }
+
+private:
+    std::vector<Layer> layers_;
+};
+
+// JSON file parsed on first use and re-parsed only when its mtime or size
+// change. Thread-safe; every call costs one stat().
+//
+// Files of at least `compact_bytes` (0 = never) are parsed through a SAX
+// handler that sizes every array and string exactly, so a large file held
+// in memory carries no spare vector capacity.
+class JsonFile {
+public:
+    explicit JsonFile(std::filesystem::path path, size_t compact_bytes = 0);
+
+    // nullptr if the file is missing or not valid JSON
+    DataContext::Layer Get();
+    // Whether a parsed value is held
+    bool Loaded() const;
+
+    const std::filesystem::path& Path() const { return path_; }
+
+private:
+    std::filesystem::path           path_;
+    size_t                          compact_bytes_ = 0;
+    mutable std::mutex              mutex_;
+    DataContext::Layer              value_;
+    bool                            loaded_ = false;
+    std::filesystem::file_time_type mtime_{};
+    uintmax_t                       size_ = 0;
+};
+
+// JSON files by name, parsed on first access.
+//
+// Registering a source records its path only; Get() parses the file the
+// first time it is asked for, and again after it changes (JsonFile).
+// Thread-safe.
+class DataSources {
+public:
+    struct Options {
+        // Files this large or larger are parsed compactly (see JsonFile)
+        size_t compact_bytes = 4 * 1024 * 1024;
+        Options() = default;
+    };
+
+    DataSources();
+    explicit DataSources(Options opts);
+
+    // Replaces a source with the same name
+    void Add(const std::string& name, std::filesystem::path file);
+    void Remove(const std::string& name);
+    // Register every *.json in `dir` by file stem and drop sources of files
+    // that are gone from it. Lists the directory, parses nothing.
+    void Scan(const std::filesystem::path& dir);
+
+    bool Has(const std::string& name) const;
+    // nullptr for unknown names and missing or invalid files
+    DataContext::Layer Get(const std::string& name) const;
+
+    // Sorted
+    std::vector<std::string> Names() const;
+    // Sources holding a parsed value
+    size_t Loaded() const;
+
+private:
+    Options                                          opts_;
+    mutable std::shared_mutex                        mutex_;
+    std::map<std::string, std::shared_ptr<JsonFile>> files_;
+};
+
+} // namespace fwui
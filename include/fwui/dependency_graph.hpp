@@ -0,0 +1,48 @@
+#pragma once
+
+#include <map>
+#include <set>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+namespace fwui {
+
+// Which pages were built from which files.
+//
+// A page depends on files and directories; depending on a directory means
+// depending on everything below it (used when the exact files are not
+// known). Paths are compared absolute and lexically normalized, so
+// "data/../data/site.json" and "/srv/site/data/site.json" are the same
+// file. Safe to query from one thread while another updates it.
+class DependencyGraph {
+public:
+    // Replace the dependencies of `page`
+    void Set(const std::string& page, const std::vector<std::string>& files);
+    void Remove(const std::string& page);
+    void Clear();
+
+    // Pages that depend on any of `files` or on a directory containing one
+    // (sorted, unique)
+    std::vector<std::string> Affected(const std::vector<std::string>& files) const;
+
+    // Normalized dependencies of `page` (sorted); empty for unknown pages
+    std::vector<std::string> Dependencies(const std::string& page) const;
+    // Pages that depend on exactly `file` (sorted)
+    std::vector<std::string> Dependents(const std::string& file) const;
+
+    std::vector<std::string> Pages() const;
+    size_t Size() const;
+
+    // Absolute, lexically normal, without a trailing separator
+    static std::string Normalize(const std::string& path);
+
+private:
+    mutable std::shared_mutex                    mutex_;
+    std::map<std::string, std::set<std::string>> files_;  // page -> files
+    std::map<std::string, std::set<std::string>> pages_;  // file -> pages
+
+    void remove_locked(const std::string& page);
+};
+
+} // namespace fwui
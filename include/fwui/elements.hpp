@@ -1,8 +1,13 @@
 #pragma once
 
 #include "core.hpp"
+#include "task.hpp"
 
 #include <filesystem>
+#include <functional>
+#include <iosfwd>
+#include <ranges>
+#include <type_traits>
 
 namespace fwui {
 
@@ -122,6 +127,106 @@ Element hr();
 // --- Raw HTML ---
 Element raw(const std::string& html);
 
+// Writes raw HTML to the stream it is given
+using RawWriter = std::function<void(std::ostream& out)>;
+
+// Raw HTML produced at render time: HtmlRenderer hands `write` a stream
+// over its own output buffer, so the HTML is never held in a string or a
+// node. `write` runs on every render and the result is never cached.
+Element raw_sink(RawWriter write);
+
+class RawSinkNode final : public Node {
+public:
+    explicit RawSinkNode(RawWriter write);
+
+    bool IsDeferred() const override { return true; }
+    bool IsRawSink() const override { return true; }
+    // For consumers other than HtmlRenderer: the output as a raw() node
+    void ForEachDeferred(const std::function<void(const Element&)>& visit) const override;
+    Element Clone() const override;
+
+    void Write(std::ostream& out) const;
+
+private:
+    RawWriter write_;
+};
+
+// --- Deferred content ---
+
+// Subtree built at render time, and only if the renderer needs it (no cached
+// ancestor). Renders as its result, without a wrapper tag.
+Element lazy(std::function<Element()> thunk);
+
+// Memoized by dependency key: the first render runs the thunk, later lazy()
+// nodes with the same key reuse that subtree and its HTML cache without
+// running it. Put whatever the content depends on into the key.
+Element lazy(const std::string& key, std::function<Element()> thunk);
+
+// Drop memoized lazy() results
+void invalidate_lazy(const std::string& key);
+void clear_lazy();
+
+// --- Streamed rows ---
+
+// Returns the next row, or nullptr once the source is exhausted
+using RowGenerator = std::function<Element()>;
+
+// Rows pulled from a generator while rendering: each row is rendered and
+// released before the next one is produced, so memory stays flat however
+// many rows there are. `open` is called once per render and must return a
+// fresh generator. Renders exactly like the rows passed eagerly:
+//   tbody({for_each_row(open)}) == tbody(rows)
+Element for_each_row(std::function<RowGenerator()> open);
+
+// Rows mapped from a multi-pass range. Lvalue ranges are referenced (keep
+// them alive while the element is rendered), rvalues are moved in. Rows for
+// which row_fn returns nullptr are skipped.
+template <std::ranges::forward_range Source, typename RowFn>
+    requires std::is_invocable_r_v<Element, RowFn&, std::ranges::range_reference_t<Source>>
+Element for_each_row(Source&& source, RowFn row_fn) {
+    using View = std::views::all_t<Source>;
+    auto view = std::make_shared<View>(std::views::all(std::forward<Source>(source)));
+    return for_each_row([view, row_fn = std::move(row_fn)]() -> RowGenerator {
+        return [view, row_fn, it = std::ranges::begin(*view)]() mutable -> Element {
+            while (it != std::ranges::end(*view)) {
+                Element row = row_fn(*it);
+                ++it;
+                if (row) return row;
+            }
+            return nullptr;
+        };
+    });
+}
+
+// --- Out-of-order slots ---
+
+// Starts the task producing a slot's content
+using SlotOpener = std::function<Task<Element>()>;
+
+// Content produced by a task. Render() and RenderTo() wait for it in place;
+// HtmlRenderer::RenderStream() sends the page with `fallback` in its place
+// and streams the content once the task completes. `open` is called once
+// per render.
+Element slot(SlotOpener open, Element fallback = nullptr);
+
+class SlotNode final : public Node {
+public:
+    SlotNode(SlotOpener open, Element fallback);
+
+    bool IsDeferred() const override { return true; }
+    bool IsSlot() const override { return true; }
+    // Waits for the task (see SyncWait())
+    void ForEachDeferred(const std::function<void(const Element&)>& visit) const override;
+    Element Clone() const override;
+
+    const SlotOpener& Opener() const { return open_; }
+    const Element& Fallback() const { return fallback_; }
+
+private:
+    SlotOpener open_;
+    Element    fallback_;
+};
+
 // --- Document structure ---
 Element html_elem(Elements children, const Attrs& attrs = {});
 Element head_elem(Elements children);
@@ -147,13 +252,16 @@ Element stylesheet(const std::string& href);
 // <link rel="stylesheet" href="..."> with extra attrs (media, crossorigin, etc.)
 Element stylesheet(const std::string& href, const Attrs& attrs);
 
+// File contents come from FileCache::Global(): read once, validated by
+// mtime/size, and shared by every node that inlines the same file.
+
 // <style>...contents of file...</style>  (inline CSS from file path)
 Element style_file(const std::filesystem::path& path);
 
 // <script>...contents of file...</script>  (inline JS from file path)
 Element script_file(const std::filesystem::path& path);
 
-// Reads file and returns raw() — for loading HTML fragments from disk
+// Raw HTML fragment loaded from disk (like raw())
 Element html_file(const std::filesystem::path& path);
 
 // Google Fonts shortcut: <link href="https://fonts.googleapis.com/css2?family=..." rel="stylesheet">
@@ -18,6 +18,18 @@ struct PageData {
     }
 };
 
+/// Template page compiled by `fwui-embed --precompile`.
+/// Load with TemplateProgram::Deserialize(Bytes()).
+struct TemplateData {
+    std::string_view route;
+    const uint8_t* data;
+    size_t size;
+
+    std::string_view Bytes() const {
+        return {reinterpret_cast<const char*>(data), size};
+    }
+};
+
 /// Find an embedded page by route. Returns nullptr if not found.
 /// Defined in generated code (embedded_pages.cpp).
 const PageData* FindPage(std::string_view route);
@@ -28,4 +40,10 @@ size_t PageCount();
 /// All embedded pages.
 std::span<const PageData> AllPages();
 
+/// Find precompiled template bytecode by route. Returns nullptr if not found.
+const TemplateData* FindTemplate(std::string_view route);
+
+/// All precompiled templates (empty without --precompile).
+std::span<const TemplateData> AllTemplates();
+
 } // namespace fwui::embedded
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace fwui {
+
+// Immutable file contents. Small files are read into memory, large ones are
+// memory-mapped (POSIX). Shared by every node that inlines the file.
+class FileContent {
+public:
+    virtual ~FileContent() = default;
+    virtual std::string_view View() const = 0;
+    virtual bool Mapped() const { return false; }
+};
+
+using FileContentPtr = std::shared_ptr<const FileContent>;
+
+// Process-wide cache behind style_file(), script_file() and html_file().
+//
+// Entries are validated by mtime + size. With stat_interval > 0 a hit inside
+// the interval does no syscalls at all; with stat_interval = max() entries are
+// trusted until Invalidate() (wire it to a FileWatcher) — repeated page builds
+// then do zero file I/O.
+class FileCache {
+public:
+    struct Options {
+        // Minimum time between stat() calls for the same file
+        std::chrono::milliseconds stat_interval{0};
+        // Files at least this large are mmap()ed instead of read (0 = never).
+        // Replace mapped files atomically (write + rename); truncating one in
+        // place while it is served is undefined.
+        size_t mmap_threshold = 1 << 20;
+        Options() = default;
+    };
+
+    struct Stats {
+        size_t hits   = 0;
+        size_t misses = 0;       // first load or reload after a change
+        size_t stat_calls = 0;   // stat() calls made for validation
+        size_t bytes  = 0;       // bytes currently cached
+        size_t files  = 0;
+    };
+
+    static FileCache& Global();
+
+    FileCache() = default;
+    explicit FileCache(Options opts);
+
+    void Configure(Options opts);
+
+    // Returns nullptr if the file cannot be read.
+    FileContentPtr Get(const std::filesystem::path& path);
+
+    void Invalidate(const std::filesystem::path& path);
+    void Clear();
+
+    Stats GetStats() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Entry {
+        FileContentPtr                  content;
+        std::filesystem::file_time_type mtime;
+        uintmax_t                       size = 0;
+        Clock::time_point               checked;
+    };
+
+    mutable std::mutex                     mutex_;
+    Options                                opts_;
+    std::unordered_map<std::string, Entry> entries_;
+    Stats                                  stats_;
+
+    static std::string key_for(const std::filesystem::path& path);
+    static FileContentPtr load(const std::filesystem::path& path, uintmax_t size,
+                               size_t mmap_threshold);
+};
+
+} // namespace fwui
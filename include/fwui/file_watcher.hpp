@@ -2,42 +2,136 @@
 
 #include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <filesystem>
 #include <functional>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <set>
 #include <string>
 #include <thread>
 #include <vector>
 
 namespace fwui {
 
+class Executor;
+
+// Reports files under `directories` that were created, modified or deleted.
+//
+// On Linux the inotify backend watches every directory of the trees
+// (directories created or removed later included) and reports a file once
+// its writer closes it, moves it in or deletes it. When the kernel queue
+// overflows it rescans; when the watch limit is reached it switches to
+// polling. Polling rescans every `interval` and compares modification
+// times.
+//
+// Changes are held until the trees are quiet for `debounce`, merged per
+// path and reported as one batch, so an editor save or a git checkout
+// triggers one callback rather than one per write.
 class FileWatcher {
 public:
+    enum class Backend {
+        Auto,     // inotify where available, else polling
+        Inotify,  // falls back to polling if inotify cannot be used
+        Polling,
+    };
+
+    enum class Change { Created, Modified, Deleted };
+
+    struct Event {
+        std::string path;
+        Change      change;
+    };
+
     struct Config {
         std::vector<std::string> directories;
         std::vector<std::string> extensions = {".html", ".json", ".css", ".js"};
-        std::chrono::milliseconds interval{500};
+        std::chrono::milliseconds interval{500};  // polling period
+        Backend backend = Backend::Auto;
+        // Report once nothing changed for this long; 0 = on detection
+        std::chrono::milliseconds debounce{50};
+        // ... or this long after the first change of a batch, whichever
+        // comes first, so a steady stream of writes is still reported
+        std::chrono::milliseconds max_delay{1000};
+        // Run callbacks here, one batch at a time, so a slow handler does
+        // not hold up detection; batches waiting for it are merged.
+        // nullptr = the watcher's thread. Must outlive Stop().
+        Executor* executor = nullptr;
     };
 
     explicit FileWatcher(Config config);
     ~FileWatcher();
 
+    // Paths of a batch, sorted. Set callbacks before Start().
     using ChangeCallback = std::function<void(const std::vector<std::string>&)>;
     void OnChange(ChangeCallback cb);
+    // The same batch with what happened to each path, net of the burst:
+    // created then modified is Created, created then deleted is dropped,
+    // deleted then created again is Modified.
+    using EventCallback = std::function<void(const std::vector<Event>&)>;
+    void OnEvents(EventCallback cb);
 
     void Start();
+    // Reports the changes still waiting out `debounce`, then returns once
+    // the callbacks are done. Called from a callback, it returns without
+    // waiting for that one. Do not destroy the watcher from its callback.
     void Stop();
     bool Running() const { return running_.load(); }
+    // Inotify or Polling while running
+    Backend ActiveBackend() const { return active_.load(); }
 
 private:
+    struct Inotify;
+    using Batch = std::map<std::string, Change>;
+    using Clock = std::chrono::steady_clock;
+
     Config config_;
     ChangeCallback callback_;
+    EventCallback event_callback_;
     std::atomic<bool> running_{false};
+    std::atomic<Backend> active_{Backend::Polling};
     std::thread watch_thread_;
     std::map<std::string, std::filesystem::file_time_type> mtimes_;
+    std::unique_ptr<Inotify> inotify_;  // between Start() and Stop()
+
+    // Watcher thread: changes waiting for the trees to settle
+    Batch pending_;
+    Clock::time_point first_change_;
+    Clock::time_point last_change_;
+
+    // Batches handed to config_.executor
+    std::mutex delivery_mutex_;
+    std::condition_variable delivered_;
+    Batch undelivered_;
+    bool delivering_ = false;
+    std::thread::id delivery_thread_;  // running Drain()
 
+    bool Matches(const std::filesystem::path& path) const;
     std::vector<std::string> ScanFiles() const;
-    std::vector<std::string> DetectChanges();
+    std::vector<Event> DetectChanges();
+
+    void Queue(const std::vector<Event>& events);
+    // When pending_ is due; Clock::time_point::max() if empty
+    Clock::time_point Deadline() const;
+    void FlushDue();
+    void Deliver(Batch batch);
+    void Drain();
+    void Dispatch(const Batch& batch);
+
+    void RunPolling();
+    bool StartInotify();
+    // Returns when stopped, or early after falling back to polling
+    void RunInotify();
+    // Watch `dir` and its subdirectories, adding the files found to
+    // `found`. False when the watch limit is reached.
+    bool WatchTree(const std::string& dir, std::set<std::string>& found);
+    // Forget the watches at or under `dir`; its known files go to `gone`
+    void UnwatchTree(const std::string& dir, std::set<std::string>& gone);
+    // Update mtimes_ for event paths; returns the ones to report
+    std::vector<Event> Resolve(const std::set<std::string>& paths);
+    // Watch everything again and diff against mtimes_ (queue overflow)
+    std::vector<Event> Rescan();
 };
 
 } // namespace fwui
@@ -1,11 +1,20 @@
 #pragma once
 
 #include "core.hpp"
+#include "style_block.hpp"
 #include "elements.hpp"
+#include "file_cache.hpp"
 #include "decorators.hpp"
 #include "renderer.hpp"
+#include "svg_sprite.hpp"
+#include "route_trie.hpp"
+#include "page_cache.hpp"
+#include "task.hpp"
 #include "registry.hpp"
+#include "data_context.hpp"
+#include "dependency_graph.hpp"
 #include "template_engine.hpp"
+#include "template_vm.hpp"
 #include "template_page_loader.hpp"
 #include "file_watcher.hpp"
 #include "hot_reload.hpp"
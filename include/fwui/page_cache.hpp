@@ -0,0 +1,100 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+namespace fwui {
+
+using PageHtml = std::shared_ptr<const std::string>;
+
+// Rendered-HTML cache behind Registry::RenderPage(), keyed by request route
+// and a fingerprint of the page data.
+//
+// Entries expire after `ttl` and are evicted least-recently-used once the
+// cache holds more than `max_bytes`. Concurrent misses on the same key run
+// the render once; the other callers wait for its result.
+class PageCache {
+public:
+    struct Options {
+        std::chrono::milliseconds ttl{std::chrono::minutes(5)};  // 0 = never expire
+        size_t max_bytes = 64 * 1024 * 1024;
+        Options() = default;
+    };
+
+    struct Stats {
+        size_t hits      = 0;
+        size_t misses    = 0;  // renders run
+        size_t coalesced = 0;  // misses that waited for another caller's render
+        size_t evictions = 0;  // dropped for the byte budget or TTL
+        size_t bytes     = 0;
+        size_t entries   = 0;
+    };
+
+    PageCache();
+    explicit PageCache(Options opts);
+
+    // Stable 64-bit hash of the JSON (objects serialize in key order)
+    static uint64_t Fingerprint(const nlohmann::json& data);
+
+    // Bumped by every invalidation. Read it before resolving the page so a
+    // render that straddles an invalidation is not cached.
+    uint64_t Epoch() const;
+
+    // Cached HTML for (route, fingerprint), or the result of `render`.
+    // `epoch` is Epoch() as read before the page was resolved, `pattern` the
+    // registered route that serves it, `tags` its invalidation tags.
+    // Exceptions from `render` reach every waiter and nothing is cached.
+    PageHtml GetOrRender(const std::string& route, uint64_t fingerprint, uint64_t epoch,
+                         const std::string& pattern, const std::vector<std::string>& tags,
+                         const std::function<std::string()>& render);
+
+    // Drop every data variant of a request route, or of everything served
+    // by a registered pattern
+    void Invalidate(const std::string& route);
+    void InvalidatePrefix(const std::string& prefix);
+    void InvalidateTag(const std::string& tag);
+    void Clear();
+
+    Stats GetStats() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+    using Key   = std::pair<std::string, uint64_t>;  // (route, fingerprint)
+
+    struct Entry {
+        std::shared_future<PageHtml>   html;
+        bool                           ready = false;
+        uint64_t                       id    = 0;  // identifies the render that owns it
+        std::string                    pattern;
+        std::vector<std::string>       tags;
+        Clock::time_point              expires;
+        size_t                         bytes = 0;
+        std::list<const Key*>::iterator lru;  // valid once ready
+    };
+    using Entries = std::map<Key, Entry>;
+
+    mutable std::mutex     mutex_;
+    Options                opts_;
+    Entries                entries_;   // sorted by route: prefix ranges are contiguous
+    std::list<const Key*>  lru_;       // front = most recently used, ready entries only
+    uint64_t               epoch_ = 0;
+    uint64_t               next_id_ = 0;
+    Stats                  stats_;
+
+    Entries::iterator erase(Entries::iterator it);
+    void evict_over_budget();
+};
+
+} // namespace fwui
@@ -1,13 +1,22 @@
 #pragma once
 
 #include "core.hpp"
+#include "page_cache.hpp"
+#include "route_trie.hpp"
+#include "task.hpp"
 
+#include <array>
+#include <atomic>
+#include <cstdint>
 #include <functional>
-#include <map>
+#include <memory>
+#include <mutex>
 #include <optional>
-#include <shared_mutex>
 #include <stdexcept>
 #include <string>
+#include <type_traits>
+#include <typeinfo>
+#include <unordered_map>
 #include <vector>
 
 #include <nlohmann/json.hpp>
@@ -17,34 +26,346 @@ namespace fwui {
 using ComponentFactory = std::function<Element(const nlohmann::json& data)>;
 using PageFactory      = std::function<Element(const nlohmann::json& data)>;
 
+// Coroutine factories. `data` is taken by value: the coroutine outlives the call.
+using AsyncComponentFactory = std::function<Task<Element>(nlohmann::json data)>;
+using AsyncPageFactory      = std::function<Task<Element>(nlohmann::json data)>;
+
+template <typename Props>
+using TypedComponentFactory = std::function<Element(const Props& props)>;
+
+// Props that nlohmann can convert both ways, e.g. structs described with
+// NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(Card, title, body)
+template <typename T>
+concept JsonProps = requires(nlohmann::json& j, const T& in, T& out) {
+    nlohmann::adl_serializer<T>::to_json(j, in);
+    nlohmann::adl_serializer<T>::from_json(j, out);
+};
+
+// Lookups are lock-free: the registry is an immutable snapshot behind an
+// atomic shared_ptr. Readers load it once and call the factory straight out
+// of it; writers copy the snapshot, modify the copy and publish it.
 class Registry {
 public:
+    Registry();
+
+    // How CreateComponent() reuses factory results
+    enum class Memo {
+        None,    // run the factory on every call
+        // One shared, pre-rendered subtree per distinct data value: later
+        // calls return it (and its HTML cache) without running the factory.
+        // Each call gets its own copy of the root (Node::ShallowClone());
+        // its children are shared, so treat them as read-only.
+        ByData,
+    };
+
+    // Counted for memoized components only
+    struct ComponentStats {
+        size_t hits    = 0;
+        size_t misses  = 0;  // factory runs
+        size_t entries = 0;  // memoized results held
+    };
+
     // --- Component registration ---
     void RegisterComponent(const std::string& name, ComponentFactory factory);
+    // Re-registering a component drops its memoized results
+    void RegisterComponent(const std::string& name, ComponentFactory factory, Memo memo);
     void UnregisterComponent(const std::string& name);
     bool HasComponent(const std::string& name) const;
 
+    // Typed component: RegisterComponent<Card>("card", fn). CreateComponent<Card>()
+    // hands the struct to `factory` as is. JSON callers (templates) still
+    // work when Props is JsonProps: the data is converted with get<Props>().
+    template <typename Props>
+    void RegisterComponent(const std::string& name, TypedComponentFactory<Props> factory) {
+        auto entry = make_typed_component<Props>(name, std::move(factory));
+        update([&](Snapshot& s) { s.components.Set(name, std::move(entry)); });
+    }
+
+    // Throws std::runtime_error for unknown components
+    ComponentStats GetComponentStats(const std::string& name) const;
+
     // --- Component invocation ---
     Element CreateComponent(const std::string& name,
                             const nlohmann::json& data = {}) const;
 
+    // CreateComponent<Card>("card", card). The props type is checked at run
+    // time against the registration: a typed component needs exactly Props,
+    // a JSON component accepts JsonProps, converted to JSON. Anything else
+    // throws std::runtime_error.
+    template <typename Props>
+    Element CreateComponent(const std::string& name,
+                            const std::type_identity_t<Props>& props) const {
+        auto snapshot = load();
+        const auto& entry = find_component(*snapshot, name);
+        if (entry.props_type && *entry.props_type == typeid(Props)) return entry.typed(&props);
+        if constexpr (JsonProps<Props>) {
+            if (!entry.props_type) return entry.Create(nlohmann::json(props));
+        }
+        throw std::runtime_error(props_mismatch(name, entry, typeid(Props)));
+    }
+
+    // Coroutine component: CreateComponent() runs it to completion on the
+    // calling thread (see SyncWait()), CreateComponentAsync() awaits it
+    void RegisterComponentAsync(const std::string& name, AsyncComponentFactory factory);
+
+    // Awaitable CreateComponent(). Independent components resolve
+    // concurrently when awaited together through WhenAll().
+    Task<Element> CreateComponentAsync(std::string name, nlohmann::json data = {}) const;
+
+    // slot() around CreateComponentAsync(): HtmlRenderer::RenderStream()
+    // sends the page with `fallback` first and this component when ready
+    Element SlotComponent(const std::string& name, const nlohmann::json& data = {},
+                          Element fallback = nullptr) const;
+
+    // Deferred CreateComponent(): the factory runs at render time, and only
+    // if no cached ancestor already covers the component (see lazy()).
+    Element LazyComponent(const std::string& name,
+                          const nlohmann::json& data = {}) const;
+
     // --- Page registration ---
+    // `route` may be a pattern (`/projects/:id`, `/docs/*path`, see
+    // RouteTrie). Throws std::runtime_error for malformed or conflicting
+    // patterns.
     void RegisterPage(const std::string& route, PageFactory factory);
+    // `cache_tags` label the page's cached output for PageCache::InvalidateTag()
+    void RegisterPage(const std::string& route, PageFactory factory,
+                      std::vector<std::string> cache_tags);
+    // Coroutine page; CreatePage() and RenderPage() wait for it
+    void RegisterPageAsync(const std::string& route, AsyncPageFactory factory,
+                           std::vector<std::string> cache_tags = {});
     void UnregisterPage(const std::string& route);
+    // True if CreatePage(route) finds a page: `route` is registered as is
+    // (a pattern given verbatim included) or matches a pattern
     bool HasPage(const std::string& route) const;
 
     // --- Page invocation ---
+    // Exact routes win; otherwise the first matching pattern is used and its
+    // captured parameters are set as string fields on (a copy of) `data`.
     Element CreatePage(const std::string& route,
                        const nlohmann::json& data = {}) const;
 
-    // --- Introspection ---
+    // Awaitable CreatePage(); synchronous factories run inline
+    Task<Element> CreatePageAsync(std::string route, nlohmann::json data = {}) const;
+
+    // HTML of CreatePage(route, data), served from the page cache when it is
+    // enabled. Re-registering or unregistering a route invalidates it.
+    PageHtml RenderPage(const std::string& route,
+                        const nlohmann::json& data = {}) const;
+
+    // --- Page output cache (opt-in) ---
+    void EnablePageCache(PageCache::Options opts = {});
+    void DisablePageCache();
+    // nullptr while disabled
+    std::shared_ptr<PageCache> GetPageCache() const;
+
+    // --- Bulk changes ---
+    class Transaction;
+
+    // --- Introspection (sorted) ---
     std::vector<std::string> ComponentNames() const;
+    // Routes without parameters: the pages that can be rendered as they are
     std::vector<std::string> PageRoutes() const;
+    // Registered patterns (`/projects/:id`)
+    std::vector<std::string> PagePatterns() const;
+    // Number of snapshots published so far; every write bumps it once
+    uint64_t Version() const;
+
+private:
+    struct ComponentEntry {
+        ComponentFactory factory;
+        Memo             memo = Memo::None;
+
+        // Typed registrations: the Props type and its factory, taking a
+        // `const Props*`. `factory` then converts JSON data to Props.
+        const std::type_info*              props_type = nullptr;
+        std::function<Element(const void*)> typed;
+
+        // Coroutine registrations; `factory` then waits for it
+        AsyncComponentFactory async_factory;
+
+        // Memo::ByData results by canonical data dump; cleared when full
+        static constexpr size_t kMaxMemoEntries = 1024;
+        mutable std::mutex                               memo_mutex;
+        mutable std::unordered_map<std::string, Element> memo_results;
+        mutable std::atomic<size_t>                      hits{0};
+        mutable std::atomic<size_t>                      misses{0};
+
+        Element Create(const nlohmann::json& data) const;
+    };
+
+    struct PageEntry {
+        PageFactory              factory;
+        std::vector<std::string> cache_tags;
+        AsyncPageFactory         async_factory;  // coroutine pages only
+    };
+
+    // Hash map split into fixed shards behind shared pointers. Copying it
+    // copies the shard pointers; Set()/Erase() then clone only the shard
+    // they touch, so a write costs O(size / kShards), not O(size).
+    // Only unpublished copies are written to (see update()).
+    template <typename Entry>
+    class ShardedMap {
+    public:
+        using EntryPtr = std::shared_ptr<const Entry>;
+
+        const Entry* Find(const std::string& key) const {
+            const auto& shard = shards_[shard_of(key)];
+            if (!shard) return nullptr;
+            auto it = shard->find(key);
+            return it == shard->end() ? nullptr : it->second.get();
+        }
+
+        void Set(const std::string& key, EntryPtr entry) {
+            if (writable(shard_of(key)).insert_or_assign(key, std::move(entry)).second) size_++;
+        }
+
+        bool Erase(const std::string& key) {
+            auto& shard = shards_[shard_of(key)];
+            if (!shard || !shard->contains(key)) return false;
+            writable(shard_of(key)).erase(key);
+            size_--;
+            return true;
+        }
+
+        template <typename Fn>
+        void ForEach(Fn&& fn) const {
+            for (const auto& shard : shards_) {
+                if (!shard) continue;
+                for (const auto& [key, entry] : *shard) fn(key, *entry);
+            }
+        }
+
+        size_t Size() const { return size_; }
+
+    private:
+        static constexpr size_t kShards = 64;
+        using Shard = std::unordered_map<std::string, EntryPtr>;
+
+        std::array<std::shared_ptr<Shard>, kShards> shards_;
+        size_t                                     size_ = 0;
+
+        static size_t shard_of(const std::string& key) {
+            return std::hash<std::string>{}(key) % kShards;
+        }
+
+        // Shards shared with another map (a published snapshot) are cloned
+        // before the first write; one this map already cloned is edited in
+        // place, so a batch of writes copies each shard at most once.
+        Shard& writable(size_t index) {
+            auto& shard = shards_[index];
+            if (!shard) shard = std::make_shared<Shard>();
+            else if (shard.use_count() > 1) shard = std::make_shared<Shard>(*shard);
+            return *shard;
+        }
+    };
+
+    struct Snapshot {
+        ShardedMap<ComponentEntry>       components;
+        ShardedMap<PageEntry>            pages;
+        // Patterns among `pages` (nullptr if none)
+        std::shared_ptr<const RouteTrie> patterns;
+        std::shared_ptr<PageCache>       page_cache;
+        uint64_t                         version = 0;
+    };
+    using SnapshotPtr = std::shared_ptr<const Snapshot>;
+
+#ifdef __cpp_lib_atomic_shared_ptr
+    std::atomic<SnapshotPtr> snapshot_;
+#else
+    SnapshotPtr snapshot_;  // accessed through std::atomic_load/atomic_store
+#endif
+    std::mutex write_mutex_;  // serializes writers only
+
+    SnapshotPtr load() const;
+    // Copy the current snapshot, apply `edit`, publish the result
+    void update(const std::function<void(Snapshot&)>& edit);
+    static void update_patterns(Snapshot& s, const std::string& route, bool add);
+    static std::shared_ptr<const ComponentEntry> make_component(ComponentFactory factory,
+                                                                Memo memo);
+    static std::shared_ptr<const PageEntry> make_async_page(AsyncPageFactory factory,
+                                                            std::vector<std::string> cache_tags);
+    template <typename Props>
+    static std::shared_ptr<const ComponentEntry> make_typed_component(
+            const std::string& name, TypedComponentFactory<Props> factory) {
+        auto entry = std::make_shared<ComponentEntry>();
+        entry->props_type = &typeid(Props);
+        if constexpr (JsonProps<Props>) {
+            entry->factory = [name, factory](const nlohmann::json& data) {
+                auto props = [&] {
+                    try {
+                        return data.get<Props>();
+                    } catch (const nlohmann::json::exception& e) {
+                        throw std::runtime_error("Invalid props for component " + name + ": " + e.what());
+                    }
+                }();
+                return factory(props);
+            };
+        } else {
+            entry->factory = [name](const nlohmann::json&) -> Element {
+                throw std::runtime_error("Component " + name + " takes typed props, not JSON");
+            };
+        }
+        entry->typed = [factory = std::move(factory)](const void* props) {
+            return factory(*static_cast<const Props*>(props));
+        };
+        return entry;
+    }
+    // Throws std::runtime_error for unknown components
+    static const ComponentEntry& find_component(const Snapshot& s, const std::string& name);
+    static std::string props_mismatch(const std::string& name, const ComponentEntry& entry,
+                                      const std::type_info& got);
+    static void set_page(Snapshot& s, const std::string& route,
+                         std::shared_ptr<const PageEntry> entry);
+    static void erase_page(Snapshot& s, const std::string& route);
+    void invalidate_page(const std::string& route) const;
+
+    // Exact route first, then patterns; `params` receives the captures
+    static const PageEntry* find_page(const Snapshot& s, const std::string& route,
+                                      const std::string*& pattern, RouteParams& params);
+    static nlohmann::json with_params(const nlohmann::json& data, RouteParams& params);
+};
+
+// Stages registrations and publishes them in one snapshot swap: readers see
+// either none of the operations or all of them, and Commit() takes the
+// writer lock once. Operations apply in the order they were staged, so
+// unregistering a route and registering it again replaces it without a gap.
+//
+//   Registry::Transaction tx(registry);
+//   for (auto& route : old_routes) tx.UnregisterPage(route);
+//   for (auto& [route, factory] : pages) tx.RegisterPage(route, factory);
+//   tx.Commit();
+//
+// A transaction that is never committed changes nothing.
+class Registry::Transaction {
+public:
+    explicit Transaction(Registry& registry);
+
+    void RegisterComponent(const std::string& name, ComponentFactory factory,
+                           Memo memo = Memo::None);
+    template <typename Props>
+    void RegisterComponent(const std::string& name, TypedComponentFactory<Props> factory) {
+        ops_.push_back([name, entry = make_typed_component<Props>(name, std::move(factory))](
+                           Snapshot& s) { s.components.Set(name, entry); });
+    }
+    void UnregisterComponent(const std::string& name);
+    void RegisterPage(const std::string& route, PageFactory factory,
+                      std::vector<std::string> cache_tags = {});
+    void RegisterPageAsync(const std::string& route, AsyncPageFactory factory,
+                           std::vector<std::string> cache_tags = {});
+    void UnregisterPage(const std::string& route);
+
+    // Publishes the staged operations and clears them. If one of them throws
+    // (a malformed or conflicting pattern) nothing is published and the
+    // transaction keeps its operations.
+    void Commit();
+
+    // Operations staged since the last Commit()
+    size_t Size() const { return ops_.size(); }
 
 private:
-    mutable std::shared_mutex               mutex_;
-    std::map<std::string, ComponentFactory> components_;
-    std::map<std::string, PageFactory>      pages_;
+    Registry&                                   registry_;
+    std::vector<std::function<void(Snapshot&)>> ops_;
+    std::vector<std::string>                    routes_;  // pages to invalidate
 };
 
 } // namespace fwui
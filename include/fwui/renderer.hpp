@@ -3,10 +3,14 @@
 #include "core.hpp"
 
 #include <fmt/format.h>
+#include <iosfwd>
 #include <string>
+#include <unordered_map>
 
 namespace fwui {
 
+class Executor;
+
 // --- Base renderer interface ---
 class Renderer {
 public:
@@ -30,9 +34,34 @@ public:
 
     static std::string RenderToString(const Element& root);
 
+    // Writes the HTML to `out`. Rows of for_each_row() nodes are flushed in
+    // chunks as they are produced, so a large list never sits in memory whole.
+    void RenderTo(const Element& root, std::ostream& out) const;
+
+    // Out-of-order streaming for pages with slot()s. Sends and flushes the
+    // page up to </body> with each slot's fallback in a placeholder, then
+    // each slot's HTML as its task completes (a <template> and a swap
+    // script call), then the closing tags. Slots run concurrently on
+    // `executor` (default Executor::Default()); slots inside lazy() content
+    // or inside other slots render in place. A failed slot keeps its
+    // fallback, and the first exception is rethrown once the page is done.
+    void RenderStream(const Element& root, std::ostream& out) const;
+    void RenderStream(const Element& root, std::ostream& out, Executor& executor) const;
+
 private:
+    // Per-call state threaded through render_node()
+    struct RenderState {
+        std::ostream* sink      = nullptr;  // RenderTo() target, flushed between rows
+        int           streaming = 0;        // depth inside for_each_row(): don't cache
+        // RenderStream(): placeholder number of each slot sent later
+        const std::unordered_map<const Node*, size_t>* slots = nullptr;
+    };
+
     Options opts_;
-    void render_node(const Element& node, fmt::memory_buffer& buf, int depth) const;
+    // Returns false if the subtree contains streamed content and must not be
+    // cached by its ancestors.
+    bool render_node(const Element& node, fmt::memory_buffer& buf, int depth,
+                     RenderState& state) const;
     void format_opening_tag(const Element& node, fmt::memory_buffer& buf) const;
 };
 
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace fwui {
+
+// Captured `:name` / `*name` values, in pattern order
+using RouteParams = std::vector<std::pair<std::string, std::string>>;
+
+// Trie of route patterns, one edge per path segment.
+//
+//   /projects/:id         `:id` captures one non-empty segment
+//   /docs/*path           `*path` captures the rest (one or more segments)
+//
+// At every segment a literal edge wins over `:param`, which wins over
+// `*wildcard`; a failed literal branch backtracks. Matching costs
+// O(path length) plus that backtracking.
+//
+// Nodes are immutable and shared: copying a trie is O(1), and Insert() /
+// Erase() copy only the nodes on the pattern's path, so a modified copy can
+// be published while readers keep matching against the old one.
+class RouteTrie {
+public:
+    // True if `route` has a `:param` or `*wildcard` segment
+    static bool IsPattern(std::string_view route);
+
+    // Throws std::runtime_error for malformed patterns (empty parameter
+    // name, wildcard not in the last segment) and for patterns that differ
+    // from an existing one only in parameter names.
+    void Insert(const std::string& pattern);
+    bool Erase(const std::string& pattern);
+
+    // Returns the matched pattern (owned by the trie) and fills `params`,
+    // or nullptr if nothing matches.
+    const std::string* Match(std::string_view path, RouteParams& params) const;
+
+    size_t Size() const { return size_; }
+
+private:
+    struct Node;
+    using NodePtr = std::shared_ptr<const Node>;
+
+    NodePtr root_;
+    size_t  size_ = 0;
+
+    static NodePtr insert(const Node* node, const std::vector<std::string_view>& segments,
+                          size_t index, const std::string& pattern,
+                          std::vector<std::string>& names, bool& added);
+    static NodePtr erase(const Node* node, const std::vector<std::string_view>& segments,
+                         size_t index, const std::string& pattern, bool& removed);
+    static bool match(const Node& node, const std::vector<std::string_view>& segments,
+                      size_t index, const char* end,
+                      std::vector<std::string_view>& values, const Node*& found);
+};
+
+} // namespace fwui
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace fwui {
+
+using StyleMap = std::map<std::string, std::string>;
+
+class StyleBlock;
+using StyleBlockPtr = std::shared_ptr<const StyleBlock>;
+
+// Immutable, interned set of inline styles (flyweight).
+//
+// Nodes with identical styles share one block, and with it the pre-rendered
+// `style="..."` text. A block is never modified: With()/Without() return
+// another interned block, so "mutating" a node only swaps its pointer.
+// Blocks leave the pool when the last node referencing them goes away.
+class StyleBlock {
+public:
+    // Returns the pooled block for `styles` (nullptr for an empty map).
+    static StyleBlockPtr Intern(StyleMap styles);
+
+    // Transition source for nodes without styles. Never handed out to nodes.
+    static const StyleBlock& Empty();
+
+    // Number of live blocks in the pool.
+    static size_t PoolSize();
+
+    // --- Copy-on-write transitions (memoized per block) ---
+    StyleBlockPtr With(const std::string& property, const std::string& value) const;
+    StyleBlockPtr Without(const std::string& property) const;
+
+    const StyleMap& Styles() const { return styles_; }
+    size_t Hash() const { return hash_; }
+
+    // "color: red; font-weight: bold;" — cached once per block
+    const std::string& Css() const { return css_; }
+
+    // ` style="..."` with HTML escaping applied, ready to append to a tag
+    const std::string& Attribute() const { return attribute_; }
+
+    StyleBlock(const StyleBlock&) = delete;
+    StyleBlock& operator=(const StyleBlock&) = delete;
+
+private:
+    StyleBlock(StyleMap styles, size_t hash);
+
+    StyleMap    styles_;
+    size_t      hash_;
+    std::string css_;
+    std::string attribute_;
+
+    // "property\0value" -> result of With(); "\0property" -> Without()
+    mutable std::mutex transitions_mutex_;
+    mutable std::unordered_map<std::string, std::weak_ptr<const StyleBlock>> transitions_;
+
+    StyleBlockPtr FindTransition(const std::string& key) const;
+    StyleBlockPtr StoreTransition(std::string key, StyleMap next) const;
+    static void Release(const StyleBlock* block);
+};
+
+} // namespace fwui
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "core.hpp"
+
+#include <cstddef>
+#include <string>
+
+namespace fwui {
+
+// Tree pass that deduplicates repeated svg() payloads.
+//
+// Every payload that occurs often enough to pay for itself is hoisted once
+// into a hidden sprite `<svg><symbol id="...">payload</symbol></svg>` at the
+// top of <body> (or of the root), and each occurrence keeps its own <svg>
+// attributes but renders `<use href="#..."/>` instead of the markup.
+//
+// Changes the root in place: apply it to a tree you own, right before
+// rendering. Nodes below the root may be shared with other trees (memoized
+// components, cached subtrees); the ones it would change are copied first.
+// Deferred and streamed content (lazy(), for_each_row()) is not visited.
+class SvgSpritePass {
+public:
+    struct Options {
+        size_t      min_occurrences = 2;
+        size_t      min_bytes       = 64;   // smaller payloads stay inline
+        std::string id_prefix       = "fwui-svg-";
+        Options() = default;
+    };
+
+    struct Report {
+        size_t svgs         = 0;  // svg() payloads seen
+        size_t symbols      = 0;  // distinct payloads hoisted
+        size_t replaced     = 0;  // occurrences now rendered as <use>
+        size_t bytes_before = 0;  // markup of the replaced occurrences
+        size_t bytes_after  = 0;  // sprite + <use> markup replacing it
+
+        ptrdiff_t BytesSaved() const {
+            return static_cast<ptrdiff_t>(bytes_before) - static_cast<ptrdiff_t>(bytes_after);
+        }
+    };
+
+    SvgSpritePass();
+    explicit SvgSpritePass(Options opts);
+
+    Report Apply(const Element& root) const;
+
+private:
+    Options opts_;
+};
+
+} // namespace fwui
@@ -0,0 +1,235 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace fwui {
+
+// Fixed pool of worker threads that resumes coroutines.
+//
+//   co_await executor.Schedule();   // continue on a worker thread
+//
+// Work is meant to wait on local I/O (files, caches, services), so the
+// default pool is sized for overlap, not for cores.
+class Executor {
+public:
+    // 0 threads = max(4, hardware_concurrency())
+    explicit Executor(size_t threads = 0);
+    // Runs the queued coroutines to completion, then joins the workers
+    ~Executor();
+
+    Executor(const Executor&) = delete;
+    Executor& operator=(const Executor&) = delete;
+
+    void Post(std::coroutine_handle<> handle);
+
+    auto Schedule() {
+        struct Awaiter {
+            Executor& executor;
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> handle) { executor.Post(handle); }
+            void await_resume() const noexcept {}
+        };
+        return Awaiter{*this};
+    }
+
+    size_t Size() const { return workers_.size(); }
+
+    // Shared pool used by WhenAll() and Registry, created on first use
+    static Executor& Default();
+
+private:
+    std::mutex                          mutex_;
+    std::condition_variable             ready_;
+    std::deque<std::coroutine_handle<>> queue_;
+    std::vector<std::thread>            workers_;
+    bool                                stopping_ = false;
+
+    void run();
+};
+
+// Lazily started coroutine producing a T. The body runs when the task is
+// co_awaited (or passed to WhenAll() / SyncWait()); exceptions propagate to
+// the awaiter. Move-only; awaiting consumes it.
+template <typename T>
+class [[nodiscard]] Task {
+    static_assert(!std::is_void_v<T>, "Task<T> needs a result type");
+
+public:
+    struct promise_type {
+        std::optional<T>        value;
+        std::exception_ptr      error;
+        std::coroutine_handle<> continuation = std::noop_coroutine();
+
+        Task get_return_object() {
+            return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+
+        // Hand control straight to the awaiter (symmetric transfer)
+        auto final_suspend() noexcept {
+            struct Final {
+                bool await_ready() const noexcept { return false; }
+                std::coroutine_handle<> await_suspend(
+                        std::coroutine_handle<promise_type> self) noexcept {
+                    return self.promise().continuation;
+                }
+                void await_resume() const noexcept {}
+            };
+            return Final{};
+        }
+
+        template <typename U>
+        void return_value(U&& result) { value.emplace(std::forward<U>(result)); }
+        void unhandled_exception() { error = std::current_exception(); }
+    };
+
+    Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (handle_) handle_.destroy();
+            handle_ = std::exchange(other.handle_, nullptr);
+        }
+        return *this;
+    }
+    ~Task() {
+        if (handle_) handle_.destroy();
+    }
+
+    auto operator co_await() && noexcept {
+        struct Awaiter {
+            std::coroutine_handle<promise_type> handle;
+            bool await_ready() const noexcept { return handle.done(); }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter) noexcept {
+                handle.promise().continuation = awaiter;
+                return handle;
+            }
+            T await_resume() {
+                auto& promise = handle.promise();
+                if (promise.error) std::rethrow_exception(promise.error);
+                return std::move(*promise.value);
+            }
+        };
+        return Awaiter{handle_};
+    }
+
+private:
+    explicit Task(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+namespace detail {
+
+// Eagerly started, self-destroying coroutine for fire-and-forget drivers
+struct Detached {
+    struct promise_type {
+        Detached get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+};
+
+template <typename T>
+struct WhenAllState {
+    explicit WhenAllState(size_t n) : pending(n + 1), results(n) {}
+
+    std::atomic<size_t>           pending;  // tasks + the starting coroutine
+    std::vector<std::optional<T>> results;
+    std::exception_ptr            error;    // first failure
+    std::mutex                    error_mutex;
+    std::coroutine_handle<>       parent;
+
+    // The last one to finish (a task or the starter) resumes the parent
+    bool arrive() { return pending.fetch_sub(1, std::memory_order_acq_rel) == 1; }
+};
+
+template <typename T>
+Detached when_all_run(Task<T> task, WhenAllState<T>& state, size_t index, Executor& executor) {
+    co_await executor.Schedule();
+    try {
+        state.results[index].emplace(co_await std::move(task));
+    } catch (...) {
+        std::lock_guard lock(state.error_mutex);
+        if (!state.error) state.error = std::current_exception();
+    }
+    if (state.arrive()) state.parent.resume();
+}
+
+template <typename T>
+Detached sync_wait_run(Task<T> task, std::promise<T> result) {
+    try {
+        result.set_value(co_await std::move(task));
+    } catch (...) {
+        result.set_exception(std::current_exception());
+    }
+}
+
+} // namespace detail
+
+// Runs every task concurrently on `executor` and completes with their
+// results in order once all have finished. If any task throws, the first
+// exception is rethrown after all have finished.
+template <typename T>
+Task<std::vector<T>> WhenAll(std::vector<Task<T>> tasks, Executor& executor = Executor::Default()) {
+    detail::WhenAllState<T> state(tasks.size());
+
+    struct Start {
+        std::vector<Task<T>>&    tasks;
+        detail::WhenAllState<T>& state;
+        Executor&                executor;
+
+        bool await_ready() const noexcept { return tasks.empty(); }
+        bool await_suspend(std::coroutine_handle<> parent) {
+            state.parent = parent;
+            for (size_t i = 0; i < tasks.size(); ++i) {
+                detail::when_all_run(std::move(tasks[i]), state, i, executor);
+            }
+            // Stay suspended unless every task already finished
+            return !state.arrive();
+        }
+        void await_resume() const noexcept {}
+    };
+    co_await Start{tasks, state, executor};
+
+    if (state.error) std::rethrow_exception(state.error);
+    std::vector<T> results;
+    results.reserve(state.results.size());
+    for (auto& result : state.results) results.push_back(std::move(*result));
+    co_return results;
+}
+
+template <typename T, typename... Rest>
+    requires (std::is_same_v<Task<T>, Rest> && ...)
+Task<std::vector<T>> WhenAll(Task<T> first, Rest... rest) {
+    std::vector<Task<T>> tasks;
+    tasks.reserve(1 + sizeof...(rest));
+    tasks.push_back(std::move(first));
+    (tasks.push_back(std::move(rest)), ...);
+    return WhenAll(std::move(tasks));
+}
+
+// Blocks the calling thread until `task` completes. Do not call it from an
+// executor thread: the task may need that thread to make progress.
+template <typename T>
+T SyncWait(Task<T> task) {
+    std::promise<T> result;
+    auto future = result.get_future();
+    detail::sync_wait_run(std::move(task), std::move(result));
+    return future.get();
+}
+
+} // namespace fwui
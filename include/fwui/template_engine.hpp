@@ -1,22 +1,113 @@
 #pragma once
 
+#include <cstddef>
+#include <functional>
+#include <iosfwd>
+#include <memory>
 #include <string>
+#include <unordered_map>
+#include <vector>
 #include <nlohmann/json.hpp>
 
 namespace fwui {
 
+class Registry;
+
+// Inja templates, parsed once and cached.
+//
+// Each instance owns its environment, template directory, callbacks and
+// compiled-template cache, and may render from many threads at once.
+// Only lookups and parses take the cache lock; renders run outside it, so
+// a slow output stream holds up no one and a callback may render through
+// the same engine. String templates are cached by content, files by path
+// and validated by modification time and size on every render (a stat, no
+// read). `{% include %}` paths resolve against the template directory.
+//
+// The static functions are a thin wrapper over a process-wide default
+// instance.
 class TemplateEngine {
 public:
+    struct CacheStats {
+        size_t hits    = 0;
+        size_t misses  = 0;  // templates parsed
+        size_t entries = 0;
+    };
+
+    using Arguments = std::vector<const nlohmann::json*>;
+    using Callback  = std::function<nlohmann::json(Arguments& args)>;
+    using Functions = std::unordered_map<std::string, Callback>;
+
+    explicit TemplateEngine(std::string template_dir = "");
+    ~TemplateEngine();
+
+    TemplateEngine(const TemplateEngine&) = delete;
+    TemplateEngine& operator=(const TemplateEngine&) = delete;
+
+    std::string RenderString(const std::string& template_str, const nlohmann::json& data) const;
+    // Relative paths are resolved against the template directory. Only the
+    // file itself is checked for changes: the partials it includes are
+    // parsed once and go stale until Evict() or EvictAll().
+    std::string RenderPath(const std::string& template_path, const nlohmann::json& data) const;
+
+    // Same, written straight to `out` without building a string. Output
+    // already written stays there if rendering throws.
+    void RenderStringTo(std::ostream& out, const std::string& template_str,
+                        const nlohmann::json& data) const;
+    void RenderPathTo(std::ostream& out, const std::string& template_path,
+                      const nlohmann::json& data) const;
+
+    // Parse `template_path` into the cache without rendering. Throws like
+    // RenderPath(). Files are read concurrently; parsing is serialized.
+    void Preload(const std::string& template_path) const;
+
+    // `{{ name(a, b) }}` with `num_args` arguments (-1 = any); replaces a
+    // callback with the same name and arity. Drops compiled templates, which
+    // bind callbacks when parsed.
+    void AddCallback(const std::string& name, int num_args, Callback callback);
+    // `{{ component("navbar") }}`, `{{ component("card", data) }}`: HTML of
+    // registry.CreateComponent(name, data). Memo::ByData components come
+    // from the registry's memo and their HTML cache, so shared chrome is
+    // built and rendered once, not once per page. `registry` must outlive
+    // the engine or the next BindComponents().
+    void BindComponents(const Registry& registry);
+    // Snapshot of the callbacks by name, for TemplateProgram
+    std::shared_ptr<const Functions> Callbacks() const;
+
+    const std::string& Directory() const;
+
+    // --- Compiled template cache ---
+    // Drop the compiled `path`. Included partials live in the shared
+    // environment, so evicting a file inside the template directory
+    // drops everything.
+    void Evict(const std::string& path);
+    void EvictAll();
+    CacheStats Stats() const;
+
+    // --- Default instance ---
+    static std::shared_ptr<TemplateEngine> Default();
+
     static std::string Render(const std::string& template_str,
                               const nlohmann::json& data);
 
     static std::string RenderFile(const std::string& template_path,
                                   const nlohmann::json& data);
 
+    static void RenderTo(std::ostream& out, const std::string& template_str,
+                         const nlohmann::json& data);
+    static void RenderFileTo(std::ostream& out, const std::string& template_path,
+                             const nlohmann::json& data);
+
+    // Replaces the default instance (with its callbacks and cache); renders
+    // already running finish on the old one
     static void SetTemplateDirectory(const std::string& dir);
 
+    static void Invalidate(const std::string& path);
+    static void Clear();
+    static CacheStats GetCacheStats();
+
 private:
-    static std::string template_dir_;
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
 };
 
 } // namespace fwui
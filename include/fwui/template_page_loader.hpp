@@ -1,10 +1,13 @@
 #pragma once
 
+#include "data_context.hpp"
+#include "dependency_graph.hpp"
 #include "registry.hpp"
 #include "template_engine.hpp"
 
 #include <filesystem>
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -12,32 +15,117 @@
 
 namespace fwui {
 
+class Executor;
+
 struct TemplatePageConfig {
     std::string pages_dir     = "pages";
     std::string data_dir      = "data";
     std::string templates_dir = "templates";
+    // Engine that renders the pages; nullptr = a new one for templates_dir
+    std::shared_ptr<TemplateEngine> engine = nullptr;
+    // Render with the native bytecode VM (template_vm.hpp), with the
+    // engine's callbacks. Pages it cannot compile fall back to the engine.
+    bool bytecode = false;
+    // Parse every engine-rendered page into the engine's cache at load, so
+    // the first requests find warm templates
+    bool preload = false;
+    // Pool for page discovery, compilation and preloading; nullptr =
+    // Executor::Default(). Load from a thread outside this pool.
+    Executor* executor = nullptr;
 };
 
 class TemplatePageLoader {
 public:
     explicit TemplatePageLoader(TemplatePageConfig config = {});
+    ~TemplatePageLoader();
+
+    /// Where the last LoadPages() or ReloadPages() spent its time
+    struct LoadTimings {
+        double discover_ms = 0;  // walking pages_dir
+        double data_ms     = 0;  // listing data_dir
+        double compile_ms  = 0;  // VM programs and page dependencies
+        double preload_ms  = 0;  // config.preload: engine parses
+        double register_ms = 0;  // staging and committing the routes
+        double total_ms    = 0;
+        size_t pages       = 0;  // pages (re)registered
+        size_t threads     = 0;  // executor workers
+    };
 
     /// Scan pages_dir for *.html files, register each in registry.
+    /// Directories are walked and pages compiled in parallel on the
+    /// executor. Binds the engine's component() to registry (see BindComponents()).
     /// Returns list of routes registered.
     std::vector<std::string> LoadPages(Registry& registry);
 
-    /// Unregister old template routes, re-scan and re-register.
+    /// Unregister old template routes, re-scan and re-register, with
+    /// freshly parsed templates. Both happen in one Registry::Transaction, so concurrent requests
+    /// never see a route missing mid-reload.
     /// Returns list of new/changed routes.
     std::vector<std::string> ReloadPages(Registry& registry);
 
-    /// Load all JSON files from data_dir into a merged object.
+    /// Incremental reload for the paths a FileWatcher reported. Pages added,
+    /// modified or deleted under pages_dir (files or whole directories) and
+    /// pages that depend on a changed partial or data file (Dependencies())
+    /// are registered again or unregistered in one transaction; only
+    /// changed data files are parsed again. Returns the affected routes.
+    std::vector<std::string> ReloadPages(Registry& registry,
+                                         const std::vector<std::string>& changed);
+
+    struct PageFile {
+        std::string route;
+        std::string path;  // absolute
+    };
+
+    /// Template pages under pages_dir with their routes, sorted by path.
+    /// Each directory is listed by its own task on the executor.
+    std::vector<PageFile> ScanPages() const;
+
+    const LoadTimings& Timings() const { return timings_; }
+
+    /// Routes → files they were built from: the page, the templates it
+    /// includes and the data files it reads. Rebuilt by LoadPages() and
+    /// ReloadPages().
+    const DependencyGraph& Dependencies() const { return deps_; }
+
+    /// Drop what depends on the changed `files`: compiled templates, global
+    /// data (for data_dir/*.json) and, if enabled, the affected routes in
+    /// registry's PageCache. Returns the affected routes, e.g. the SSG
+    /// outputs to rebuild. New and deleted pages need ReloadPages().
+    std::vector<std::string> Invalidate(Registry& registry, const std::vector<std::string>& files);
+
+    /// Load all JSON files from data_dir into a merged object, eagerly.
+    /// Pages do not use it: each reads only the files it needs, from Data().
     nlohmann::json LoadGlobalData() const;
 
+    /// data_dir/*.json by file stem, parsed on first use. Shared with the
+    /// pages, so page factories can read the same cached files.
+    const std::shared_ptr<DataSources>& Data() const { return sources_; }
+
     const TemplatePageConfig& Config() const { return config_; }
+    const std::shared_ptr<TemplateEngine>& Engine() const { return engine_; }
 
 private:
+    struct GlobalData;
+    class PageData;
+    struct PreparedPage;
+
     TemplatePageConfig config_;
-    std::vector<std::string> registered_routes_;
+    std::shared_ptr<TemplateEngine> engine_;
+    std::shared_ptr<DataSources> sources_;
+    std::shared_ptr<GlobalData> global_;
+    std::map<std::string, std::string> pages_;  // normalized page file -> route
+    DependencyGraph deps_;
+    LoadTimings timings_;
+
+    Executor& executor() const;
+    // Stage a RegisterPage() per template; returns page file -> route
+    std::map<std::string, std::string> stage_pages(Registry::Transaction& tx);
+    // Compile and preload `pages` in parallel, then stage them in order
+    void stage(Registry::Transaction& tx, const std::vector<PageFile>& pages);
+    PreparedPage prepare_page(const PageFile& page) const;
+    void stage_page(Registry::Transaction& tx, PreparedPage page);
+    // Drop compiled templates and global data built from `files`
+    void evict(const std::vector<std::string>& files);
 
     static std::string path_to_route(const std::filesystem::path& rel_path);
 };
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "template_engine.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fmt/format.h>
+#include <nlohmann/json.hpp>
+
+namespace fwui {
+
+// Inja templates compiled to bytecode for a small native VM.
+//
+// Covers the subset FWUI pages use: {{ expressions }}, if / else if / else,
+// for (with loop.index, loop.index1, loop.is_first, loop.is_last,
+// loop.parent), set, include, raw, comments, whitespace control ({%- -%}),
+// operators, function calls and `x | f(args)` filters. Output matches
+// TemplateEngine for the same template and data.
+//
+// Compilation inlines includes, splits the source into static byte chunks
+// and resolves every variable once: a loop variable becomes a frame slot, a
+// data path a pre-split key list. Rendering runs the bytecode straight into
+// the output buffer. Programs are plain data and can be serialized, e.g. to
+// ship precompiled templates with fwui-embed.
+class TemplateProgram {
+public:
+    struct Options {
+        // Base directory for {% include %} and relative CompileFile() paths
+        std::string template_dir;
+        // HTML-escape {{ }} output (inja: off). `safe(x)` / `x | safe` opts out.
+        bool autoescape = false;
+        Options() = default;
+    };
+
+    enum class Op : uint8_t {
+        Text,         // a: chunk
+        Print,        // x: 1 = HTML-escape
+        PushConst,    // a: constant
+        PushData,     // a: path; x: 1 = missing is not an error
+        PushLocal,    // a: path (first key is the loop variable); y: loop depth; x: 1 = soft, 2 = key
+        PushSet,      // a: path (first key is the set variable); y: set slot; x: 1 = soft
+        PushLoop,     // a: loop field; y: loop depth
+        MakeArray,    // y: items
+        MakeObject,   // y: key/value pairs
+        Call,         // a: builtin; y: arguments
+        CallUser,     // a: constant holding the name; y: arguments
+        Not, Neg,
+        Add, Sub, Mul, Div, Mod, Pow,
+        Eq, Ne, Lt, Le, Gt, Ge, In,
+        AndJump,      // a: target; leaves false and jumps if the top is falsy, else pops
+        OrJump,       // a: target; leaves true and jumps if the top is truthy, else pops
+        ToBool,
+        Jump,         // a: target
+        JumpIfFalse,  // a: target; pops
+        ForBegin,     // a: exit target; y: loop depth; pops the iterable
+        ForNext,      // a: body target; y: loop depth
+        Set,          // y: set slot; pops
+    };
+
+    struct Instruction {
+        Op       op = Op::Text;
+        uint8_t  x  = 0;
+        uint16_t y  = 0;
+        uint32_t a  = 0;
+    };
+
+    TemplateProgram() = default;
+
+    // Throws std::runtime_error naming the line for syntax errors, missing
+    // includes and constructs outside the supported subset
+    static TemplateProgram Compile(std::string_view source);
+    static TemplateProgram Compile(std::string_view source, const Options& opts);
+    static TemplateProgram CompileFile(const std::string& path);
+    static TemplateProgram CompileFile(const std::string& path, const Options& opts);
+
+    // Throws std::runtime_error for missing variables and bad operands, as
+    // inja does. `functions` serve calls that are not built in.
+    void RenderTo(fmt::memory_buffer& buf, const nlohmann::json& data,
+                  const TemplateEngine::Functions* functions = nullptr) const;
+    // Writes in chunks while rendering
+    void RenderTo(std::ostream& out, const nlohmann::json& data,
+                  const TemplateEngine::Functions* functions = nullptr) const;
+    std::string Render(const nlohmann::json& data,
+                       const TemplateEngine::Functions* functions = nullptr) const;
+
+    // Compact binary form. Deserialize() checks every operand, so a
+    // truncated or corrupted blob throws instead of misbehaving.
+    std::string Serialize() const;
+    static TemplateProgram Deserialize(std::string_view bytes);
+
+    // Resolved paths of the files inlined by {% include %}
+    const std::vector<std::string>& Includes() const { return includes_; }
+    // Top-level data names the program reads, sorted: `site` for
+    // {{ site.name }} or exists("site.name"). nullopt when exists() gets a
+    // name computed at render time.
+    std::optional<std::vector<std::string>> DataNames() const;
+    const std::vector<Instruction>& Code() const { return code_; }
+    bool Empty() const { return code_.empty(); }
+
+private:
+    struct Chunk {
+        uint32_t offset = 0;
+        uint32_t size   = 0;
+    };
+
+    std::vector<Instruction>              code_;
+    std::string                           text_;       // static chunks, back to back
+    std::vector<Chunk>                    chunks_;
+    std::vector<std::vector<std::string>> paths_;      // dotted names, split
+    std::vector<nlohmann::json>           constants_;
+    std::vector<std::string>              includes_;
+    uint16_t                              set_slots_ = 0;
+    uint16_t                              max_depth_ = 0;  // deepest loop nesting
+
+    friend class TemplateCompiler;
+
+    void verify() const;
+    void run(fmt::memory_buffer& buf, std::ostream* sink, const nlohmann::json& data,
+             const TemplateEngine::Functions* functions) const;
+};
+
+} // namespace fwui
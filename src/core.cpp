@@ -34,14 +34,30 @@ Element Node::SetTag(const std::string& tag) {
 
 // --- Text content ---
 
-const std::string& Node::TextContent() const { return text_content_; }
+std::string Node::TextContent() const {
+    return std::string(TextView());
+}
 
 Element Node::SetTextContent(const std::string& content) {
     InvalidateCache();
+    text_owner_.reset();
+    text_view_ = {};
     text_content_ = content;
     return shared_from_this();
 }
 
+Element Node::SetSharedText(std::shared_ptr<const void> owner, std::string_view text) {
+    InvalidateCache();
+    text_content_.clear();
+    text_owner_ = std::move(owner);
+    text_view_ = text;
+    return shared_from_this();
+}
+
+std::string_view Node::TextView() const {
+    return text_owner_ ? text_view_ : std::string_view(text_content_);
+}
+
 // --- Attributes ---
 
 Element Node::SetAttribute(const std::string& key, const std::string& value) {
@@ -126,26 +142,34 @@ const std::vector<std::string>& Node::Classes() const { return classes_; }
 
 // --- Inline styles ---
 
+static const std::string kNoStyle;
+static const StyleMap    kNoStyles;
+
 Element Node::SetStyle(const std::string& property, const std::string& value) {
     InvalidateCache();
-    styles_[property] = value;
+    styles_ = (styles_ ? *styles_ : StyleBlock::Empty()).With(property, value);
     return shared_from_this();
 }
 
 Element Node::RemoveStyle(const std::string& property) {
     InvalidateCache();
-    styles_.erase(property);
+    if (styles_ && styles_->Styles().contains(property)) {
+        styles_ = styles_->Without(property);
+    }
     return shared_from_this();
 }
 
 std::string Node::GetStyle(const std::string& property) const {
-    auto it = styles_.find(property);
-    return it != styles_.end() ? it->second : "";
+    if (!styles_) return "";
+    const auto& styles = styles_->Styles();
+    auto it = styles.find(property);
+    return it != styles.end() ? it->second : "";
 }
 
 Element Node::SetStyleString(const std::string& full_style) {
     InvalidateCache();
     // Merge, not replace — so chaining SetStyle() calls accumulates properties
+    StyleMap merged = styles_ ? styles_->Styles() : StyleMap{};
     std::istringstream iss(full_style);
     std::string pair;
     while (std::getline(iss, pair, ';')) {
@@ -165,22 +189,28 @@ Element Node::SetStyleString(const std::string& full_style) {
         trim(val);
 
         if (!key.empty() && !val.empty()) {
-            styles_[key] = val;
+            merged[key] = val;
         }
     }
+    styles_ = StyleBlock::Intern(std::move(merged));
     return shared_from_this();
 }
 
-std::string Node::StyleString() const {
-    std::string result;
-    for (const auto& [prop, val] : styles_) {
-        if (!result.empty()) result += ' ';
-        result += prop + ": " + val + ";";
-    }
-    return result;
+const std::string& Node::StyleString() const {
+    return styles_ ? styles_->Css() : kNoStyle;
+}
+
+const std::map<std::string, std::string>& Node::Styles() const {
+    return styles_ ? styles_->Styles() : kNoStyles;
 }
 
-const std::map<std::string, std::string>& Node::Styles() const { return styles_; }
+const StyleBlockPtr& Node::SharedStyles() const { return styles_; }
+
+Element Node::SetSharedStyles(StyleBlockPtr styles) {
+    InvalidateCache();
+    styles_ = std::move(styles);
+    return shared_from_this();
+}
 
 // --- Children ---
 
@@ -260,7 +290,7 @@ bool Node::IsSelfClosing() const {
 
 Element Node::ClearStyles() {
     InvalidateCache();
-    styles_.clear();
+    styles_.reset();
     return shared_from_this();
 }
 
@@ -281,9 +311,11 @@ Element Node::ClearAttributes() {
 Element Node::Clone() const {
     auto copy = std::make_shared<Node>(tag_);
     copy->text_content_ = text_content_;
+    copy->text_owner_ = text_owner_;
+    copy->text_view_ = text_view_;
     copy->is_raw_ = is_raw_;
     copy->attributes_ = attributes_;
-    copy->styles_ = styles_;
+    copy->styles_ = styles_;  // shared, immutable
     copy->classes_ = classes_;
     for (const auto& child : children_) {
         if (child) copy->AppendChild(child->Clone());
@@ -291,6 +323,21 @@ Element Node::Clone() const {
     return copy;
 }
 
+Element Node::ShallowClone() const {
+    if (IsDeferred()) return Clone();
+    auto copy = std::make_shared<Node>(tag_);
+    copy->text_content_ = text_content_;
+    copy->text_owner_ = text_owner_;
+    copy->text_view_ = text_view_;
+    copy->is_raw_ = is_raw_;
+    copy->attributes_ = attributes_;
+    copy->styles_ = styles_;
+    copy->classes_ = classes_;
+    copy->children_ = children_;  // not reparented
+    copy->html_cache_ = html_cache_;
+    return copy;
+}
+
 // --- Raw HTML ---
 
 bool Node::IsRaw() const { return is_raw_; }
@@ -303,7 +350,7 @@ Element Node::SetRaw(bool raw) {
 
 // --- EscapeHTML ---
 
-std::string Node::EscapeHTML(const std::string& text) {
+std::string Node::EscapeHTML(std::string_view text) {
     size_t extra = 0;
     for (char c : text) {
         switch (c) {
@@ -313,7 +360,7 @@ std::string Node::EscapeHTML(const std::string& text) {
             case '\'': extra += 4; break;
         }
     }
-    if (extra == 0) return text;
+    if (extra == 0) return std::string(text);
 
     std::string out;
     out.reserve(text.size() + extra);
@@ -336,11 +383,11 @@ nlohmann::json Node::ToJSON() const {
     nlohmann::json j;
 
     if (!tag_.empty())          j["tag"]  = tag_;
-    if (!text_content_.empty()) j["text"] = text_content_;
+    if (auto text = TextView(); !text.empty()) j["text"] = text;
     if (is_raw_)                j["raw"]  = true;
 
     if (!attributes_.empty()) j["attrs"]   = attributes_;
-    if (!styles_.empty())     j["styles"]  = styles_;
+    if (styles_)              j["styles"]  = styles_->Styles();
     if (!classes_.empty())    j["classes"] = classes_;
 
     if (!children_.empty()) {
@@ -351,6 +398,14 @@ nlohmann::json Node::ToJSON() const {
         }
     }
 
+    if (IsDeferred()) {
+        auto& arr = j["children"];
+        arr = nlohmann::json::array();
+        ForEachDeferred([&](const Element& child) {
+            if (child) arr.push_back(child->ToJSON());
+        });
+    }
+
     return j;
 }
 
@@ -0,0 +1,316 @@
+#include "fwui/data_context.hpp"
+
+#include <charconv>
+#include <fstream>
+#include <string>
+#include <system_error>
+
+namespace fs = std::filesystem;
+
+namespace fwui {
+
+namespace {
+
+enum class Lookup { Found, Missing, Shadowed };
+
+// Walks `tokens` through one layer. Missing means a lower layer may still
+// have the value; Shadowed means this layer hides it (null or a non-object
+// on the way).
+Lookup resolve(const nlohmann::json& layer, const std::vector<std::string>& tokens,
+               bool is_base, const nlohmann::json*& out) {
+    const nlohmann::json* value = &layer;
+    bool in_array = false;  // arrays replace, so their contents come from this layer only
+    for (const auto& token : tokens) {
+        if (value->is_object()) {
+            auto it = value->find(token);
+            if (it == value->end()) return in_array ? Lookup::Shadowed : Lookup::Missing;
+            value = &*it;
+        } else if (value->is_array()) {
+            size_t index = 0;
+            auto [end, ec] = std::from_chars(token.data(), token.data() + token.size(), index);
+            if (ec != std::errc{} || end != token.data() + token.size() || index >= value->size()) {
+                return Lookup::Shadowed;
+            }
+            value = &(*value)[index];
+            in_array = true;
+        } else {
+            return Lookup::Shadowed;
+        }
+    }
+    // In a patch layer null means "deleted"
+    if (value->is_null() && !is_base && !in_array) return Lookup::Shadowed;
+    out = value;
+    return Lookup::Found;
+}
+
+std::vector<std::string> split_pointer(const nlohmann::json::json_pointer& pointer) {
+    std::vector<std::string> tokens;
+    auto text = pointer.to_string();
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t next = text.find('/', pos + 1);
+        if (next == std::string::npos) next = text.size();
+        std::string token = text.substr(pos + 1, next - pos - 1);
+        // Unescape ~1 → '/' before ~0 → '~'
+        for (size_t i = 0; (i = token.find("~1", i)) != std::string::npos; ++i) token.replace(i, 2, "/");
+        for (size_t i = 0; (i = token.find("~0", i)) != std::string::npos; ++i) token.replace(i, 2, "~");
+        tokens.push_back(std::move(token));
+        pos = next;
+    }
+    return tokens;
+}
+
+// SAX handler building the same DOM as json::parse(), with every array and
+// string shrunk to its size as soon as it is complete
+class CompactBuilder {
+public:
+    using json = nlohmann::json;
+
+    explicit CompactBuilder(json& root) : root_(root) {}
+
+    bool null()                                          { add(nullptr); return true; }
+    bool boolean(bool value)                             { add(value); return true; }
+    bool number_integer(json::number_integer_t value)    { add(value); return true; }
+    bool number_unsigned(json::number_unsigned_t value)  { add(value); return true; }
+    bool number_float(json::number_float_t value, const json::string_t&) { add(value); return true; }
+    bool string(json::string_t& value) {
+        value.shrink_to_fit();
+        add(std::move(value));
+        return true;
+    }
+    bool binary(json::binary_t& value) { add(json::binary(std::move(value))); return true; }
+
+    bool start_object(size_t) { open_.push_back(add(json::object())); return true; }
+    bool key(json::string_t& key) {
+        member_ = &(*open_.back())[key];
+        return true;
+    }
+    bool end_object() { open_.pop_back(); return true; }
+
+    bool start_array(size_t) { open_.push_back(add(json::array())); return true; }
+    bool end_array() {
+        open_.back()->get_ref<json::array_t&>().shrink_to_fit();
+        open_.pop_back();
+        return true;
+    }
+
+    bool parse_error(size_t, const std::string&, const json::exception&) { return false; }
+
+private:
+    json&              root_;
+    std::vector<json*> open_;             // containers being filled
+    json*              member_ = nullptr; // object member named by the last key()
+
+    template <typename Value>
+    json* add(Value&& value) {
+        if (open_.empty()) {
+            root_ = json(std::forward<Value>(value));
+            return &root_;
+        }
+        if (open_.back()->is_array()) {
+            auto& array = open_.back()->get_ref<json::array_t&>();
+            array.emplace_back(std::forward<Value>(value));
+            return &array.back();
+        }
+        *member_ = json(std::forward<Value>(value));
+        return member_;
+    }
+};
+
+bool is_empty_layer(const DataContext::Layer& layer) {
+    return !layer || layer->is_null() || (layer->is_object() && layer->empty());
+}
+
+const DataContext::Layer& empty_object() {
+    static const DataContext::Layer empty =
+        std::make_shared<const nlohmann::json>(nlohmann::json::object());
+    return empty;
+}
+
+const nlohmann::json* find_tokens(const std::vector<DataContext::Layer>& layers,
+                                  const std::vector<std::string>& tokens) {
+    for (size_t i = layers.size(); i-- > 0;) {
+        const auto& layer = layers[i];
+        if (!layer || layer->is_null()) continue;
+        const nlohmann::json* out = nullptr;
+        switch (resolve(*layer, tokens, i == 0, out)) {
+            case Lookup::Found:    return out;
+            case Lookup::Shadowed: return nullptr;
+            case Lookup::Missing:  break;
+        }
+    }
+    return nullptr;
+}
+
+} // namespace
+
+// --- DataContext ---
+
+DataContext::DataContext(Layer base) {
+    if (base) layers_.push_back(std::move(base));
+}
+
+DataContext DataContext::With(Layer layer) const {
+    DataContext next = *this;
+    if (layer) next.layers_.push_back(std::move(layer));
+    return next;
+}
+
+DataContext DataContext::With(nlohmann::json layer) const {
+    return With(std::make_shared<const nlohmann::json>(std::move(layer)));
+}
+
+const nlohmann::json* DataContext::Find(std::string_view key) const {
+    return find_tokens(layers_, {std::string(key)});
+}
+
+const nlohmann::json* DataContext::Find(const nlohmann::json::json_pointer& pointer) const {
+    return find_tokens(layers_, split_pointer(pointer));
+}
+
+DataContext::Layer DataContext::Flatten() const {
+    // Start at the highest layer that replaces everything below it
+    size_t first = 0;
+    for (size_t i = layers_.size(); i-- > 0;) {
+        if (!is_empty_layer(layers_[i]) && !layers_[i]->is_object()) {
+            first = i;
+            break;
+        }
+    }
+
+    const Layer* only = nullptr;
+    size_t non_empty = 0;
+    for (size_t i = first; i < layers_.size(); ++i) {
+        if (is_empty_layer(layers_[i])) continue;
+        only = &layers_[i];
+        non_empty++;
+    }
+    if (non_empty == 0) return empty_object();
+    if (non_empty == 1) return *only;
+
+    nlohmann::json merged;
+    bool started = false;
+    for (size_t i = first; i < layers_.size(); ++i) {
+        if (is_empty_layer(layers_[i])) continue;
+        if (!started) {
+            merged = *layers_[i];
+            started = true;
+        } else {
+            merged.merge_patch(*layers_[i]);
+        }
+    }
+    return std::make_shared<const nlohmann::json>(std::move(merged));
+}
+
+// --- JsonFile ---
+
+JsonFile::JsonFile(fs::path path, size_t compact_bytes)
+    : path_(std::move(path)), compact_bytes_(compact_bytes) {}
+
+bool JsonFile::Loaded() const {
+    std::lock_guard lock(mutex_);
+    return loaded_ && value_;
+}
+
+DataContext::Layer JsonFile::Get() {
+    std::error_code ec;
+    auto mtime = fs::last_write_time(path_, ec);
+    uintmax_t size = ec ? 0 : fs::file_size(path_, ec);
+
+    std::lock_guard lock(mutex_);
+    if (ec) {
+        loaded_ = false;
+        value_.reset();
+        return nullptr;
+    }
+    if (loaded_ && mtime == mtime_ && size == size_) return value_;
+
+    std::ifstream f(path_);
+    if (compact_bytes_ > 0 && size >= compact_bytes_) {
+        nlohmann::json parsed;
+        CompactBuilder builder(parsed);
+        value_ = nlohmann::json::sax_parse(f, &builder)
+                     ? std::make_shared<const nlohmann::json>(std::move(parsed))
+                     : nullptr;
+    } else {
+        auto parsed = nlohmann::json::parse(f, nullptr, false);
+        value_ = parsed.is_discarded() ? nullptr
+                                       : std::make_shared<const nlohmann::json>(std::move(parsed));
+    }
+    loaded_ = true;
+    mtime_  = mtime;
+    size_   = size;
+    return value_;
+}
+
+// --- DataSources ---
+
+DataSources::DataSources() : DataSources(Options{}) {}
+
+DataSources::DataSources(Options opts) : opts_(opts) {}
+
+void DataSources::Add(const std::string& name, fs::path file) {
+    auto source = std::make_shared<JsonFile>(std::move(file), opts_.compact_bytes);
+    std::unique_lock lock(mutex_);
+    files_[name] = std::move(source);
+}
+
+void DataSources::Remove(const std::string& name) {
+    std::unique_lock lock(mutex_);
+    files_.erase(name);
+}
+
+void DataSources::Scan(const fs::path& dir) {
+    std::map<std::string, fs::path> found;
+    std::error_code ec;
+    for (auto& entry : fs::directory_iterator(dir, ec)) {
+        if (!entry.is_regular_file() || entry.path().extension() != ".json") continue;
+        found.emplace(entry.path().stem().string(), entry.path());
+    }
+
+    std::unique_lock lock(mutex_);
+    std::erase_if(files_, [&](const auto& source) {
+        auto it = found.find(source.first);
+        return it == found.end() ? source.second->Path().parent_path() == dir : false;
+    });
+    for (auto& [name, path] : found) {
+        auto it = files_.find(name);
+        // Keep parsed sources whose file is unchanged
+        if (it != files_.end() && it->second->Path() == path) continue;
+        files_[name] = std::make_shared<JsonFile>(std::move(path), opts_.compact_bytes);
+    }
+}
+
+bool DataSources::Has(const std::string& name) const {
+    std::shared_lock lock(mutex_);
+    return files_.contains(name);
+}
+
+DataContext::Layer DataSources::Get(const std::string& name) const {
+    std::shared_ptr<JsonFile> file;
+    {
+        std::shared_lock lock(mutex_);
+        auto it = files_.find(name);
+        if (it == files_.end()) return nullptr;
+        file = it->second;
+    }
+    // Parsed outside the lock: other sources stay available meanwhile
+    return file->Get();
+}
+
+std::vector<std::string> DataSources::Names() const {
+    std::shared_lock lock(mutex_);
+    std::vector<std::string> names;
+    names.reserve(files_.size());
+    for (const auto& [name, file] : files_) names.push_back(name);
+    return names;
+}
+
+size_t DataSources::Loaded() const {
+    std::shared_lock lock(mutex_);
+    size_t loaded = 0;
+    for (const auto& [name, file] : files_) loaded += file->Loaded();
+    return loaded;
+}
+
+} // namespace fwui
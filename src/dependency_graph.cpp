@@ -0,0 +1,96 @@
+#include "fwui/dependency_graph.hpp"
+
+#include <filesystem>
+#include <mutex>
+#include <system_error>
+
+namespace fs = std::filesystem;
+
+namespace fwui {
+
+std::string DependencyGraph::Normalize(const std::string& path) {
+    std::error_code ec;
+    auto abs = fs::absolute(path, ec);
+    auto normal = (ec ? fs::path(path) : abs).lexically_normal();
+    // "dir/" -> "dir", so directories match the parents of their files
+    if (!normal.has_filename() && normal.has_relative_path()) normal = normal.parent_path();
+    return normal.string();
+}
+
+void DependencyGraph::Set(const std::string& page, const std::vector<std::string>& files) {
+    std::set<std::string> normalized;
+    for (const auto& file : files) normalized.insert(Normalize(file));
+
+    std::unique_lock lock(mutex_);
+    remove_locked(page);
+    for (const auto& file : normalized) pages_[file].insert(page);
+    files_[page] = std::move(normalized);
+}
+
+void DependencyGraph::Remove(const std::string& page) {
+    std::unique_lock lock(mutex_);
+    remove_locked(page);
+}
+
+void DependencyGraph::Clear() {
+    std::unique_lock lock(mutex_);
+    files_.clear();
+    pages_.clear();
+}
+
+void DependencyGraph::remove_locked(const std::string& page) {
+    auto it = files_.find(page);
+    if (it == files_.end()) return;
+    for (const auto& file : it->second) {
+        auto dependents = pages_.find(file);
+        if (dependents == pages_.end()) continue;
+        dependents->second.erase(page);
+        if (dependents->second.empty()) pages_.erase(dependents);
+    }
+    files_.erase(it);
+}
+
+std::vector<std::string> DependencyGraph::Affected(const std::vector<std::string>& files) const {
+    std::set<std::string> affected;
+
+    std::shared_lock lock(mutex_);
+    for (const auto& file : files) {
+        // The file itself, then every directory above it
+        for (auto path = fs::path(Normalize(file)); ; path = path.parent_path()) {
+            if (auto it = pages_.find(path.string()); it != pages_.end()) {
+                affected.insert(it->second.begin(), it->second.end());
+            }
+            if (!path.has_relative_path()) break;
+        }
+    }
+    return {affected.begin(), affected.end()};
+}
+
+std::vector<std::string> DependencyGraph::Dependencies(const std::string& page) const {
+    std::shared_lock lock(mutex_);
+    auto it = files_.find(page);
+    if (it == files_.end()) return {};
+    return {it->second.begin(), it->second.end()};
+}
+
+std::vector<std::string> DependencyGraph::Dependents(const std::string& file) const {
+    std::shared_lock lock(mutex_);
+    auto it = pages_.find(Normalize(file));
+    if (it == pages_.end()) return {};
+    return {it->second.begin(), it->second.end()};
+}
+
+std::vector<std::string> DependencyGraph::Pages() const {
+    std::shared_lock lock(mutex_);
+    std::vector<std::string> pages;
+    pages.reserve(files_.size());
+    for (const auto& [page, files] : files_) pages.push_back(page);
+    return pages;
+}
+
+size_t DependencyGraph::Size() const {
+    std::shared_lock lock(mutex_);
+    return files_.size();
+}
+
+} // namespace fwui
@@ -1,7 +1,10 @@
 #include "fwui/elements.hpp"
+#include "fwui/file_cache.hpp"
+#include "fwui/renderer.hpp"
 
 #include <algorithm>
-#include <fstream>
+#include <mutex>
+#include <sstream>
 
 namespace fwui {
 
@@ -425,6 +428,153 @@ Element raw(const std::string& html) {
     return node;
 }
 
+RawSinkNode::RawSinkNode(RawWriter write) : Node(""), write_(std::move(write)) {}
+
+void RawSinkNode::ForEachDeferred(const std::function<void(const Element&)>& visit) const {
+    std::ostringstream out;
+    Write(out);
+    visit(raw(std::move(out).str()));
+}
+
+Element RawSinkNode::Clone() const {
+    return std::make_shared<RawSinkNode>(write_);
+}
+
+void RawSinkNode::Write(std::ostream& out) const {
+    if (write_) write_(out);
+}
+
+Element raw_sink(RawWriter write) {
+    return std::make_shared<RawSinkNode>(std::move(write));
+}
+
+// --- Deferred content ---
+
+namespace {
+
+struct LazyMemo {
+    std::mutex                     mutex;
+    std::map<std::string, Element> results;
+};
+
+LazyMemo& lazy_memo() {
+    static LazyMemo memo;
+    return memo;
+}
+
+class LazyNode final : public Node {
+public:
+    LazyNode(std::string key, std::function<Element()> thunk)
+        : Node(""), key_(std::move(key)), thunk_(std::move(thunk)) {}
+
+    bool IsDeferred() const override { return true; }
+
+    void ForEachDeferred(const std::function<void(const Element&)>& visit) const override {
+        if (!resolved_) resolved_ = resolve();
+        if (resolved_) visit(resolved_);
+    }
+
+    Element Clone() const override {
+        return std::make_shared<LazyNode>(key_, thunk_);
+    }
+
+private:
+    std::string              key_;
+    std::function<Element()> thunk_;
+    mutable Element          resolved_;
+
+    Element resolve() const {
+        if (key_.empty()) return thunk_ ? thunk_() : nullptr;
+
+        auto& memo = lazy_memo();
+        {
+            std::lock_guard lock(memo.mutex);
+            if (auto it = memo.results.find(key_); it != memo.results.end())
+                return it->second;
+        }
+        auto result = thunk_ ? thunk_() : nullptr;
+        // Render once before publishing: concurrent renders of the shared
+        // subtree then only read its cache
+        if (result) HtmlRenderer::RenderToString(result);
+
+        std::lock_guard lock(memo.mutex);
+        return memo.results.try_emplace(key_, std::move(result)).first->second;
+    }
+};
+
+} // namespace
+
+Element lazy(std::function<Element()> thunk) {
+    return std::make_shared<LazyNode>("", std::move(thunk));
+}
+
+Element lazy(const std::string& key, std::function<Element()> thunk) {
+    return std::make_shared<LazyNode>(key, std::move(thunk));
+}
+
+void invalidate_lazy(const std::string& key) {
+    auto& memo = lazy_memo();
+    std::lock_guard lock(memo.mutex);
+    memo.results.erase(key);
+}
+
+void clear_lazy() {
+    auto& memo = lazy_memo();
+    std::lock_guard lock(memo.mutex);
+    memo.results.clear();
+}
+
+// --- Streamed rows ---
+
+namespace {
+
+class StreamNode final : public Node {
+public:
+    explicit StreamNode(std::function<RowGenerator()> open)
+        : Node(""), open_(std::move(open)) {}
+
+    bool IsDeferred() const override { return true; }
+    bool IsStreamed() const override { return true; }
+
+    void ForEachDeferred(const std::function<void(const Element&)>& visit) const override {
+        if (!open_) return;
+        auto next = open_();
+        if (!next) return;
+        while (auto row = next()) visit(row);
+    }
+
+    Element Clone() const override {
+        return std::make_shared<StreamNode>(open_);
+    }
+
+private:
+    std::function<RowGenerator()> open_;
+};
+
+} // namespace
+
+Element for_each_row(std::function<RowGenerator()> open) {
+    return std::make_shared<StreamNode>(std::move(open));
+}
+
+// --- Out-of-order slots ---
+
+SlotNode::SlotNode(SlotOpener open, Element fallback)
+    : Node(""), open_(std::move(open)), fallback_(std::move(fallback)) {}
+
+void SlotNode::ForEachDeferred(const std::function<void(const Element&)>& visit) const {
+    if (!open_) return;
+    if (auto content = SyncWait(open_())) visit(content);
+}
+
+Element SlotNode::Clone() const {
+    return std::make_shared<SlotNode>(open_, fallback_ ? fallback_->Clone() : nullptr);
+}
+
+Element slot(SlotOpener open, Element fallback) {
+    return std::make_shared<SlotNode>(std::move(open), std::move(fallback));
+}
+
 // --- Document structure ---
 
 Element html_elem(Elements children, const Attrs& attrs) {
@@ -493,10 +643,16 @@ Element document(const std::string& title,
 
 // --- File-based helpers ---
 
-static std::string read_file_contents(const std::filesystem::path& path) {
-    std::ifstream f(path);
-    if (!f) return "";
-    return {std::istreambuf_iterator<char>(f), {}};
+// Node whose raw text is the cached file buffer itself (no per-node copy)
+static Element make_file_node(const std::string& tag,
+                              const std::filesystem::path& path) {
+    auto node = std::make_shared<Node>(tag);
+    if (auto content = FileCache::Global().Get(path)) {
+        auto view = content->View();
+        node->SetSharedText(std::move(content), view);
+    }
+    node->SetRaw(true);
+    return node;
 }
 
 Element stylesheet(const std::string& href) {
@@ -512,15 +668,15 @@ Element stylesheet(const std::string& href, const Attrs& attrs) {
 }
 
 Element style_file(const std::filesystem::path& path) {
-    return style_elem(read_file_contents(path));
+    return make_file_node("style", path);
 }
 
 Element script_file(const std::filesystem::path& path) {
-    return script_inline(read_file_contents(path));
+    return make_file_node("script", path);
 }
 
 Element html_file(const std::filesystem::path& path) {
-    return raw(read_file_contents(path));
+    return make_file_node("", path);
 }
 
 Element google_font(const std::string& family) {
@@ -8,6 +8,7 @@
 //     --templates <dir>    Shared templates directory (default: templates/)
 //     --minify             Minify HTML (default: true)
 //     --no-minify          Pretty-print HTML
+//     --precompile         Also embed template pages as VM bytecode
 //     --help, -h           Show usage
 
 #include <fwui/fwui.hpp>
@@ -31,6 +32,7 @@ struct Config {
     std::string data_dir     = "data";
     std::string templates_dir = "templates";
     bool minify = true;
+    bool precompile = false;
 };
 
 static void print_usage() {
@@ -47,6 +49,7 @@ static void print_usage() {
         "  --templates <dir>    Shared templates directory (default: templates/)\n"
         "  --minify             Minify HTML (default)\n"
         "  --no-minify          Pretty-print HTML\n"
+        "  --precompile         Also embed template pages as VM bytecode\n"
         "  --help, -h           Show this message\n";
 }
 
@@ -69,6 +72,8 @@ static Config parse_args(int argc, char* argv[]) {
             cfg.minify = true;
         } else if (arg == "--no-minify") {
             cfg.minify = false;
+        } else if (arg == "--precompile") {
+            cfg.precompile = true;
         } else {
             std::cerr << "Unknown option: " << arg << "\n";
             print_usage();
@@ -112,7 +117,11 @@ int main(int argc, char* argv[]) {
     Registry registry;
 
     // Template pages
-    TemplatePageLoader loader({cfg.pages_dir, cfg.data_dir, cfg.templates_dir});
+    TemplatePageLoader loader({
+        .pages_dir     = cfg.pages_dir,
+        .data_dir      = cfg.data_dir,
+        .templates_dir = cfg.templates_dir,
+    });
     auto tpl_routes = loader.LoadPages(registry);
 
     // C++ pages (if no template pages found, use built-in SSG pages)
@@ -148,6 +157,28 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
+    // Template bytecode for rendering with runtime data
+    struct CompiledTemplate {
+        std::string route;
+        std::string bytes;
+        std::string var_name;
+    };
+    std::vector<CompiledTemplate> templates;
+
+    if (cfg.precompile) {
+        TemplateProgram::Options tpl_opts;
+        tpl_opts.template_dir = cfg.templates_dir;
+        for (const auto& [route, path] : loader.ScanPages()) {
+            try {
+                auto bytes = TemplateProgram::CompileFile(path, tpl_opts).Serialize();
+                templates.push_back({route, std::move(bytes), "tpl_" + sanitize_identifier(route)});
+            } catch (const std::exception& e) {
+                std::cerr << "Error: " << e.what() << "\n";
+                return 1;
+            }
+        }
+    }
+
     // Generate output files
     fs::create_directories(cfg.output_dir);
 
@@ -205,6 +236,34 @@ int main(int argc, char* argv[]) {
           << "    return all_pages;\n"
           << "}\n\n";
 
+        // Template table
+        for (const auto& t : templates) {
+            write_byte_array(f, t.var_name, t.bytes);
+        }
+        if (templates.empty()) {
+            f << "std::span<const TemplateData> AllTemplates() {\n"
+              << "    return {};\n"
+              << "}\n\n";
+        } else {
+            f << "static constexpr TemplateData all_templates[] = {\n";
+            for (const auto& t : templates) {
+                f << "    { \"" << t.route << "\", " << t.var_name
+                  << ", sizeof(" << t.var_name << ") },\n";
+            }
+            f << "};\n\n";
+
+            f << "std::span<const TemplateData> AllTemplates() {\n"
+              << "    return all_templates;\n"
+              << "}\n\n";
+        }
+
+        f << "const TemplateData* FindTemplate(std::string_view route) {\n"
+          << "    for (const auto& t : AllTemplates()) {\n"
+          << "        if (t.route == route) return &t;\n"
+          << "    }\n"
+          << "    return nullptr;\n"
+          << "}\n\n";
+
         f << "} // namespace fwui::embedded\n";
     }
 
@@ -218,6 +277,9 @@ int main(int argc, char* argv[]) {
     for (const auto& p : pages) {
         std::cout << "  " << p.route << " (" << p.html.size() << " bytes)\n";
     }
+    for (const auto& t : templates) {
+        std::cout << "  " << t.route << " (bytecode, " << t.bytes.size() << " bytes)\n";
+    }
     std::cout << "\nTotal: " << pages.size() << " pages, "
               << total_bytes << " bytes\n";
 
@@ -0,0 +1,159 @@
+#include "fwui/file_cache.hpp"
+
+#include <fstream>
+#include <system_error>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define FWUI_HAS_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace fwui {
+
+// --- Content buffers ---
+
+namespace {
+
+class StringContent final : public FileContent {
+public:
+    explicit StringContent(std::string data) : data_(std::move(data)) {}
+    std::string_view View() const override { return data_; }
+
+private:
+    std::string data_;
+};
+
+#ifdef FWUI_HAS_MMAP
+class MappedContent final : public FileContent {
+public:
+    MappedContent(void* addr, size_t size) : addr_(addr), size_(size) {}
+    ~MappedContent() override { ::munmap(addr_, size_); }
+    std::string_view View() const override {
+        return {static_cast<const char*>(addr_), size_};
+    }
+    bool Mapped() const override { return true; }
+
+private:
+    void*  addr_;
+    size_t size_;
+};
+
+FileContentPtr map_file(const fs::path& path, size_t size) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return nullptr;
+    void* addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) return nullptr;
+    return std::make_shared<MappedContent>(addr, size);
+}
+#endif
+
+} // namespace
+
+// --- FileCache ---
+
+FileCache& FileCache::Global() {
+    static FileCache cache;
+    return cache;
+}
+
+FileCache::FileCache(Options opts) : opts_(std::move(opts)) {}
+
+void FileCache::Configure(Options opts) {
+    std::lock_guard lock(mutex_);
+    opts_ = std::move(opts);
+}
+
+std::string FileCache::key_for(const fs::path& path) {
+    return path.lexically_normal().generic_string();
+}
+
+FileContentPtr FileCache::load(const fs::path& path, uintmax_t size,
+                               size_t mmap_threshold) {
+#ifdef FWUI_HAS_MMAP
+    if (mmap_threshold > 0 && size >= mmap_threshold) {
+        if (auto mapped = map_file(path, static_cast<size_t>(size))) return mapped;
+    }
+#endif
+    std::ifstream f(path, std::ios::binary);
+    if (!f) return nullptr;
+    std::string data;
+    data.reserve(static_cast<size_t>(size));
+    data.assign(std::istreambuf_iterator<char>(f), {});
+    return std::make_shared<StringContent>(std::move(data));
+}
+
+FileContentPtr FileCache::Get(const fs::path& path) {
+    auto key = key_for(path);
+    auto now = Clock::now();
+
+    std::unique_lock lock(mutex_);
+    auto it = entries_.find(key);
+    if (it != entries_.end() && now - it->second.checked < opts_.stat_interval) {
+        stats_.hits++;
+        return it->second.content;
+    }
+    stats_.stat_calls++;
+    auto mmap_threshold = opts_.mmap_threshold;
+    lock.unlock();
+
+    // Validate (or discover) with a single stat(), outside the lock
+    std::error_code ec;
+    fs::directory_entry entry(path, ec);
+    auto mtime = ec ? fs::file_time_type{} : entry.last_write_time(ec);
+    auto size  = ec ? 0 : entry.file_size(ec);
+
+    if (!ec) {
+        lock.lock();
+        it = entries_.find(key);
+        if (it != entries_.end() && it->second.mtime == mtime && it->second.size == size) {
+            it->second.checked = now;
+            stats_.hits++;
+            return it->second.content;
+        }
+        lock.unlock();
+    }
+
+    // Concurrent misses on the same file just race to publish identical content
+    auto content = ec ? nullptr : load(path, size, mmap_threshold);
+
+    lock.lock();
+    it = entries_.find(key);
+    if (it != entries_.end()) {
+        stats_.bytes -= it->second.content->View().size();
+        entries_.erase(it);
+    }
+    if (!content) return nullptr;
+
+    stats_.misses++;
+    stats_.bytes += content->View().size();
+    entries_.emplace(std::move(key), Entry{content, mtime, size, now});
+    return content;
+}
+
+void FileCache::Invalidate(const fs::path& path) {
+    std::lock_guard lock(mutex_);
+    auto it = entries_.find(key_for(path));
+    if (it == entries_.end()) return;
+    stats_.bytes -= it->second.content->View().size();
+    entries_.erase(it);
+}
+
+void FileCache::Clear() {
+    std::lock_guard lock(mutex_);
+    entries_.clear();
+    stats_.bytes = 0;
+}
+
+FileCache::Stats FileCache::GetStats() const {
+    std::lock_guard lock(mutex_);
+    auto s = stats_;
+    s.files = entries_.size();
+    return s;
+}
+
+} // namespace fwui
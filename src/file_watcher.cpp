@@ -1,11 +1,136 @@
 #include "fwui/file_watcher.hpp"
+#include "fwui/task.hpp"
 
+#include <algorithm>
+#include <iostream>
+#include <optional>
+#include <system_error>
+#include <unordered_map>
 #include <unordered_set>
+#include <utility>
+
+#ifdef __linux__
+#define FWUI_HAS_INOTIFY 1
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
 
 namespace fs = std::filesystem;
 
 namespace fwui {
 
+namespace {
+
+using Change = FileWatcher::Change;
+
+// Folds `next` into what already happened to the path in this batch;
+// nullopt when the changes cancel out
+std::optional<Change> merge(Change before, Change next) {
+    if (before == Change::Created) {
+        if (next == Change::Deleted) return std::nullopt;  // never existed for the callback
+        return Change::Created;
+    }
+    if (before == Change::Deleted && next != Change::Deleted) return Change::Modified;  // replaced
+    return next;
+}
+
+void merge_into(std::map<std::string, Change>& batch, const std::string& path, Change change) {
+    auto [it, inserted] = batch.try_emplace(path, change);
+    if (inserted) return;
+    if (auto merged = merge(it->second, change)) {
+        it->second = *merged;
+    } else {
+        batch.erase(it);
+    }
+}
+
+detail::Detached run_on(Executor& executor, std::function<void()> fn) {
+    co_await executor.Schedule();
+    fn();
+}
+
+} // namespace
+
+#ifdef FWUI_HAS_INOTIFY
+
+namespace {
+
+// `path` is `dir` or below it
+bool is_under(const std::string& path, const std::string& dir) {
+    if (path.compare(0, dir.size(), dir) != 0) return false;
+    return path.size() == dir.size() || dir.back() == '/' || path[dir.size()] == '/';
+}
+
+// Files are reported once written and closed, not on every write(), so a
+// callback does not see them half-written. Directories are tracked through
+// their parent; DELETE_SELF / MOVE_SELF matter for the roots.
+constexpr uint32_t kWatchMask = IN_CLOSE_WRITE | IN_ATTRIB | IN_CREATE | IN_DELETE |
+                                IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF |
+                                IN_ONLYDIR;
+
+} // namespace
+
+struct FileWatcher::Inotify {
+    int fd   = -1;  // inotify instance; closed on fallback to polling
+    int wake = -1;  // eventfd that Stop() signals
+    bool exhausted = false;                     // hit max_user_watches
+    std::unordered_map<int, std::string> dirs;  // watch descriptor -> directory
+    std::map<std::string, int>           wds;   // directory -> watch descriptor
+
+    ~Inotify() {
+        Close();
+        if (wake >= 0) ::close(wake);
+    }
+
+    void Close() {
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+        dirs.clear();
+        wds.clear();
+    }
+
+    void Wake() {
+        uint64_t one = 1;
+        [[maybe_unused]] auto n = ::write(wake, &one, sizeof(one));
+    }
+
+    // False only for the watch limit; a directory that vanished or cannot
+    // be read is skipped
+    bool Add(const std::string& dir) {
+        int wd = ::inotify_add_watch(fd, dir.c_str(), kWatchMask);
+        if (wd < 0) {
+            if (errno == ENOSPC || errno == ENOMEM) exhausted = true;
+            return !exhausted;
+        }
+        // The same inode under a new path keeps its descriptor
+        if (auto it = dirs.find(wd); it != dirs.end()) wds.erase(it->second);
+        dirs[wd]  = dir;
+        wds[dir]  = wd;
+        return true;
+    }
+
+    void Remove(const std::string& dir) {
+        for (auto it = wds.lower_bound(dir); it != wds.end() && is_under(it->first, dir);) {
+            ::inotify_rm_watch(fd, it->second);
+            dirs.erase(it->second);
+            it = wds.erase(it);
+        }
+    }
+};
+
+#else
+
+struct FileWatcher::Inotify {
+    void Wake() {}
+};
+
+#endif
+
 FileWatcher::FileWatcher(Config config)
     : config_(std::move(config)) {
     // Initialize with current file states
@@ -24,26 +149,127 @@ void FileWatcher::OnChange(ChangeCallback cb) {
     callback_ = std::move(cb);
 }
 
+void FileWatcher::OnEvents(EventCallback cb) {
+    event_callback_ = std::move(cb);
+}
+
 void FileWatcher::Start() {
     running_ = true;
-    watch_thread_ = std::thread([this]() {
-        while (running_) {
-            std::this_thread::sleep_for(config_.interval);
-            if (!running_) break;
-
-            auto changed = DetectChanges();
-            if (!changed.empty() && callback_) {
-                callback_(changed);
-            }
-        }
+    bool inotify = config_.backend != Backend::Polling && StartInotify();
+    active_ = inotify ? Backend::Inotify : Backend::Polling;
+    watch_thread_ = std::thread([this, inotify]() {
+        if (inotify) RunInotify();
+        if (running_) RunPolling();
+        // Stopped: report what was still waiting out the debounce
+        if (!pending_.empty()) Deliver(std::exchange(pending_, {}));
     });
 }
 
 void FileWatcher::Stop() {
     running_ = false;
+    if (watch_thread_.get_id() == std::this_thread::get_id()) {
+        // From a callback on the watcher thread: it winds down once the
+        // callback returns, and the next Stop() joins it
+        return;
+    }
+    if (inotify_) inotify_->Wake();
     if (watch_thread_.joinable()) {
         watch_thread_.join();
     }
+    inotify_.reset();
+
+    // Batches already handed to the executor still run, unless this is one
+    std::unique_lock lock(delivery_mutex_);
+    if (delivery_thread_ == std::this_thread::get_id()) return;
+    delivered_.wait(lock, [this] { return !delivering_; });
+}
+
+bool FileWatcher::Matches(const fs::path& path) const {
+    auto ext = path.extension().string();
+    for (const auto& wanted : config_.extensions) {
+        if (ext == wanted) return true;
+    }
+    return false;
+}
+
+void FileWatcher::Queue(const std::vector<Event>& events) {
+    if (events.empty()) return;
+    auto now = Clock::now();
+    if (pending_.empty()) first_change_ = now;
+    last_change_ = now;
+    for (const auto& event : events) merge_into(pending_, event.path, event.change);
+    FlushDue();
+}
+
+FileWatcher::Clock::time_point FileWatcher::Deadline() const {
+    if (pending_.empty()) return Clock::time_point::max();
+    return std::min(last_change_ + config_.debounce, first_change_ + config_.max_delay);
+}
+
+void FileWatcher::FlushDue() {
+    if (pending_.empty() || Clock::now() < Deadline()) return;
+    Deliver(std::exchange(pending_, {}));
+}
+
+void FileWatcher::Deliver(Batch batch) {
+    if (!config_.executor) {
+        Dispatch(batch);
+        return;
+    }
+    std::lock_guard lock(delivery_mutex_);
+    for (const auto& [path, change] : batch) merge_into(undelivered_, path, change);
+    if (delivering_ || undelivered_.empty()) return;
+    delivering_ = true;
+    run_on(*config_.executor, [this] { Drain(); });
+}
+
+void FileWatcher::Drain() {
+    for (;;) {
+        Batch batch;
+        {
+            std::lock_guard lock(delivery_mutex_);
+            if (undelivered_.empty()) {
+                delivering_ = false;
+                delivery_thread_ = {};
+                delivered_.notify_all();
+                return;
+            }
+            batch.swap(undelivered_);
+            delivery_thread_ = std::this_thread::get_id();
+        }
+        Dispatch(batch);
+    }
+}
+
+void FileWatcher::Dispatch(const Batch& batch) {
+    if (batch.empty()) return;
+    if (event_callback_) {
+        std::vector<Event> events;
+        events.reserve(batch.size());
+        for (const auto& [path, change] : batch) events.push_back({path, change});
+        event_callback_(events);
+    }
+    if (callback_) {
+        std::vector<std::string> paths;
+        paths.reserve(batch.size());
+        for (const auto& [path, change] : batch) paths.push_back(path);
+        callback_(paths);
+    }
+}
+
+void FileWatcher::RunPolling() {
+    active_ = Backend::Polling;
+    auto next_scan = Clock::now() + config_.interval;
+    while (running_) {
+        std::this_thread::sleep_until(std::min(next_scan, Deadline()));
+        if (!running_) break;
+
+        if (Clock::now() >= next_scan) {
+            next_scan = Clock::now() + config_.interval;
+            Queue(DetectChanges());
+        }
+        FlushDue();
+    }
 }
 
 std::vector<std::string> FileWatcher::ScanFiles() const {
@@ -52,13 +278,8 @@ std::vector<std::string> FileWatcher::ScanFiles() const {
         if (!fs::exists(dir)) continue;
         try {
             for (auto& entry : fs::recursive_directory_iterator(dir)) {
-                if (!entry.is_regular_file()) continue;
-                auto ext = entry.path().extension().string();
-                for (const auto& wanted : config_.extensions) {
-                    if (ext == wanted) {
-                        files.push_back(entry.path().string());
-                        break;
-                    }
+                if (entry.is_regular_file() && Matches(entry.path())) {
+                    files.push_back(entry.path().string());
                 }
             }
         } catch (...) {}
@@ -66,8 +287,8 @@ std::vector<std::string> FileWatcher::ScanFiles() const {
     return files;
 }
 
-std::vector<std::string> FileWatcher::DetectChanges() {
-    std::vector<std::string> changed;
+std::vector<FileWatcher::Event> FileWatcher::DetectChanges() {
+    std::vector<Event> changed;
     auto current_files = ScanFiles();
 
     std::unordered_set<std::string> current_set(current_files.begin(), current_files.end());
@@ -77,9 +298,12 @@ std::vector<std::string> FileWatcher::DetectChanges() {
         try {
             auto mtime = fs::last_write_time(file);
             auto it = mtimes_.find(file);
-            if (it == mtimes_.end() || it->second != mtime) {
-                changed.push_back(file);
+            if (it == mtimes_.end()) {
+                changed.push_back({file, Change::Created});
                 mtimes_[file] = mtime;
+            } else if (it->second != mtime) {
+                changed.push_back({file, Change::Modified});
+                it->second = mtime;
             }
         } catch (...) {}
     }
@@ -92,10 +316,168 @@ std::vector<std::string> FileWatcher::DetectChanges() {
     }
     for (const auto& d : deleted) {
         mtimes_.erase(d);
-        changed.push_back(d);
+        changed.push_back({d, Change::Deleted});
     }
 
     return changed;
 }
 
+std::vector<FileWatcher::Event> FileWatcher::Resolve(const std::set<std::string>& paths) {
+    std::vector<Event> changed;
+    for (const auto& path : paths) {
+        if (!Matches(path)) continue;
+        std::error_code ec;
+        auto mtime = fs::last_write_time(path, ec);
+        if (!ec && fs::is_regular_file(path, ec)) {
+            // The event says it changed even if the coarse mtime did not
+            auto [it, created] = mtimes_.insert_or_assign(path, mtime);
+            changed.push_back({path, created ? Change::Created : Change::Modified});
+        } else if (mtimes_.erase(path)) {
+            changed.push_back({path, Change::Deleted});
+        }
+        // else created and deleted again before we looked
+    }
+    return changed;
+}
+
+#ifdef FWUI_HAS_INOTIFY
+
+bool FileWatcher::StartInotify() {
+    auto state = std::make_unique<Inotify>();
+    state->fd   = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    state->wake = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (state->fd < 0 || state->wake < 0) {
+        std::cerr << "[fwui] inotify unavailable (" << std::strerror(errno) << "), polling\n";
+        return false;
+    }
+    inotify_ = std::move(state);
+
+    std::set<std::string> found;
+    for (const auto& dir : config_.directories) {
+        if (fs::is_directory(dir) && !WatchTree(dir, found)) break;
+    }
+    if (inotify_->exhausted) {
+        std::cerr << "[fwui] inotify watch limit reached (fs.inotify.max_user_watches), polling\n";
+        inotify_->Close();
+        return false;
+    }
+    return true;
+}
+
+bool FileWatcher::WatchTree(const std::string& dir, std::set<std::string>& found) {
+    // Watch before listing: a file created meanwhile is listed, reported by
+    // an event, or both
+    if (!inotify_->Add(dir)) return false;
+    std::error_code ec;
+    for (auto it = fs::recursive_directory_iterator(dir, ec);
+         !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+        if (it->is_directory(ec) && !it->is_symlink(ec)) {
+            if (!inotify_->Add(it->path().string())) return false;
+        } else if (it->is_regular_file(ec) && Matches(it->path())) {
+            found.insert(it->path().string());
+        }
+    }
+    return true;
+}
+
+void FileWatcher::UnwatchTree(const std::string& dir, std::set<std::string>& gone) {
+    inotify_->Remove(dir);
+    for (auto it = mtimes_.lower_bound(dir); it != mtimes_.end() && is_under(it->first, dir); ++it) {
+        gone.insert(it->first);
+    }
+}
+
+std::vector<FileWatcher::Event> FileWatcher::Rescan() {
+    for (const auto& [dir, wd] : inotify_->wds) ::inotify_rm_watch(inotify_->fd, wd);
+    inotify_->dirs.clear();
+    inotify_->wds.clear();
+
+    std::set<std::string> found;
+    for (const auto& dir : config_.directories) {
+        if (fs::is_directory(dir) && !WatchTree(dir, found)) break;
+    }
+    return DetectChanges();
+}
+
+void FileWatcher::RunInotify() {
+    auto& state = *inotify_;
+
+    // Changes between construction and the first watch
+    Queue(DetectChanges());
+
+    alignas(inotify_event) char buf[64 * 1024];
+    pollfd fds[2] = {{state.fd, POLLIN, 0}, {state.wake, POLLIN, 0}};
+    while (running_) {
+        // Sleep until the next event, or until pending changes are due
+        int timeout = -1;
+        if (auto deadline = Deadline(); deadline != Clock::time_point::max()) {
+            auto wait = std::chrono::ceil<std::chrono::milliseconds>(deadline - Clock::now());
+            timeout = static_cast<int>(std::max<std::chrono::milliseconds::rep>(wait.count(), 0));
+        }
+        if (::poll(fds, 2, timeout) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (!running_ || fds[1].revents) break;
+
+        // Drain the queue: one callback per burst that is already queued
+        std::set<std::string> paths;
+        bool overflow = false;
+        ssize_t n;
+        while ((n = ::read(state.fd, buf, sizeof(buf))) > 0) {
+            for (char* p = buf; p < buf + n;) {
+                const auto& event = *reinterpret_cast<const inotify_event*>(p);
+                p += sizeof(inotify_event) + event.len;
+
+                if (event.mask & IN_Q_OVERFLOW) {
+                    overflow = true;
+                    continue;
+                }
+                auto it = state.dirs.find(event.wd);
+                if (it == state.dirs.end()) continue;  // already unwatched
+                if (event.mask & IN_IGNORED) {
+                    state.wds.erase(it->second);
+                    state.dirs.erase(it);
+                    continue;
+                }
+                auto dir = it->second;
+                if (event.mask & (IN_DELETE_SELF | IN_MOVE_SELF)) {
+                    UnwatchTree(dir, paths);
+                    continue;
+                }
+
+                auto path = (fs::path(dir) / event.name).string();
+                if (!(event.mask & IN_ISDIR)) {
+                    // A new file counts once its writer closes it
+                    if (!(event.mask & IN_CREATE)) paths.insert(std::move(path));
+                } else if (event.mask & (IN_CREATE | IN_MOVED_TO)) {
+                    // Files already inside count as created
+                    WatchTree(path, paths);
+                } else if (event.mask & (IN_DELETE | IN_MOVED_FROM)) {
+                    UnwatchTree(path, paths);
+                }
+            }
+        }
+
+        Queue(overflow ? Rescan() : Resolve(paths));
+        FlushDue();
+
+        if (state.exhausted) {
+            std::cerr << "[fwui] inotify watch limit reached (fs.inotify.max_user_watches), polling\n";
+            state.Close();
+            return;
+        }
+    }
+}
+
+#else
+
+bool FileWatcher::StartInotify() { return false; }
+void FileWatcher::RunInotify() {}
+bool FileWatcher::WatchTree(const std::string&, std::set<std::string>&) { return false; }
+void FileWatcher::UnwatchTree(const std::string&, std::set<std::string>&) {}
+std::vector<FileWatcher::Event> FileWatcher::Rescan() { return DetectChanges(); }
+
+#endif
+
 } // namespace fwui
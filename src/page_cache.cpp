@@ -0,0 +1,154 @@
+#include "fwui/page_cache.hpp"
+#include "fwui/route_trie.hpp"
+
+#include <algorithm>
+
+namespace fwui {
+
+PageCache::PageCache() : opts_() {}
+PageCache::PageCache(Options opts) : opts_(std::move(opts)) {}
+
+uint64_t PageCache::Fingerprint(const nlohmann::json& data) {
+    // FNV-1a over the canonical dump: stable across runs, unlike std::hash
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (unsigned char c : data.dump()) {
+        h ^= c;
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+uint64_t PageCache::Epoch() const {
+    std::lock_guard lock(mutex_);
+    return epoch_;
+}
+
+PageHtml PageCache::GetOrRender(const std::string& route, uint64_t fingerprint,
+                                uint64_t epoch, const std::string& pattern,
+                                const std::vector<std::string>& tags,
+                                const std::function<std::string()>& render) {
+    Key key{route, fingerprint};
+    std::unique_lock lock(mutex_);
+
+    if (auto it = entries_.find(key); it != entries_.end()) {
+        auto& entry = it->second;
+        if (!entry.ready) {
+            // Someone is rendering this key right now: wait for their result
+            stats_.coalesced++;
+            auto pending = entry.html;
+            lock.unlock();
+            return pending.get();
+        }
+        if (opts_.ttl.count() > 0 && Clock::now() >= entry.expires) {
+            erase(it);
+            stats_.evictions++;
+        } else {
+            stats_.hits++;
+            lru_.splice(lru_.begin(), lru_, entry.lru);
+            return entry.html.get();
+        }
+    }
+
+    stats_.misses++;
+    std::promise<PageHtml> promise;
+    uint64_t id = ++next_id_;
+    auto& pending   = entries_[key];
+    pending.html    = promise.get_future().share();
+    pending.id      = id;
+    pending.pattern = pattern;
+    pending.tags    = tags;
+    lock.unlock();
+
+    PageHtml html;
+    try {
+        html = std::make_shared<const std::string>(render());
+    } catch (...) {
+        promise.set_exception(std::current_exception());
+        lock.lock();
+        if (auto it = entries_.find(key); it != entries_.end() && it->second.id == id) {
+            entries_.erase(it);
+        }
+        throw;
+    }
+    promise.set_value(html);
+
+    lock.lock();
+    auto it = entries_.find(key);
+    // Invalidated while rendering: our pending entry is gone
+    if (it == entries_.end() || it->second.id != id) return html;
+    // The page was resolved before an invalidation that may have covered it
+    if (epoch != epoch_ || html->size() > opts_.max_bytes) {
+        entries_.erase(it);
+        return html;
+    }
+
+    auto& entry   = it->second;
+    entry.ready   = true;
+    entry.bytes   = html->size();
+    entry.expires = Clock::now() + opts_.ttl;
+    lru_.push_front(&it->first);
+    entry.lru     = lru_.begin();
+    stats_.bytes += entry.bytes;
+    evict_over_budget();
+    return html;
+}
+
+PageCache::Entries::iterator PageCache::erase(Entries::iterator it) {
+    if (it->second.ready) {
+        stats_.bytes -= it->second.bytes;
+        lru_.erase(it->second.lru);
+    }
+    return entries_.erase(it);
+}
+
+void PageCache::evict_over_budget() {
+    while (stats_.bytes > opts_.max_bytes && !lru_.empty()) {
+        erase(entries_.find(*lru_.back()));
+        stats_.evictions++;
+    }
+}
+
+void PageCache::Invalidate(const std::string& route) {
+    std::lock_guard lock(mutex_);
+    epoch_++;
+    auto it = entries_.lower_bound(Key{route, 0});
+    while (it != entries_.end() && it->first.first == route) it = erase(it);
+
+    if (!RouteTrie::IsPattern(route)) return;
+    for (it = entries_.begin(); it != entries_.end();) {
+        it = it->second.pattern == route ? erase(it) : std::next(it);
+    }
+}
+
+void PageCache::InvalidatePrefix(const std::string& prefix) {
+    std::lock_guard lock(mutex_);
+    epoch_++;
+    auto it = entries_.lower_bound(Key{prefix, 0});
+    while (it != entries_.end() && it->first.first.starts_with(prefix)) it = erase(it);
+}
+
+void PageCache::InvalidateTag(const std::string& tag) {
+    std::lock_guard lock(mutex_);
+    epoch_++;
+    for (auto it = entries_.begin(); it != entries_.end();) {
+        const auto& tags = it->second.tags;
+        it = std::find(tags.begin(), tags.end(), tag) != tags.end() ? erase(it) : std::next(it);
+    }
+}
+
+void PageCache::Clear() {
+    std::lock_guard lock(mutex_);
+    epoch_++;
+    entries_.clear();
+    lru_.clear();
+    stats_.bytes = 0;
+}
+
+PageCache::Stats PageCache::GetStats() const {
+    std::lock_guard lock(mutex_);
+    auto s = stats_;
+    s.entries = entries_.size();
+    return s;
+}
+
+} // namespace fwui
@@ -15,13 +15,13 @@ void RegisterSSGPages(Registry& registry) {
             a("About",   "#about",  "_self") | AddClass("nav-link"),
             a("Contact", "#contact","_self") | AddClass("nav-link"),
         }) | SetClass("navbar");
-    });
+    }, Registry::Memo::ByData);
 
     registry.RegisterComponent("footer", [](const nlohmann::json&) {
         return footer({
             paragraph("Built with FWUI") | Center() | Color("#999"),
         }) | Padding(24);
-    });
+    }, Registry::Memo::ByData);
 
     // --- Pages ---
 
@@ -1,88 +1,398 @@
 #include "fwui/registry.hpp"
+#include "fwui/elements.hpp"
+#include "fwui/renderer.hpp"
 
-#include <mutex>
+#include <algorithm>
 
 namespace fwui {
 
+// --- Snapshot ---
+
+Registry::Registry() : snapshot_(std::make_shared<const Snapshot>()) {}
+
+Registry::SnapshotPtr Registry::load() const {
+#ifdef __cpp_lib_atomic_shared_ptr
+    return snapshot_.load(std::memory_order_acquire);
+#else
+    return std::atomic_load_explicit(&snapshot_, std::memory_order_acquire);
+#endif
+}
+
+void Registry::update(const std::function<void(Snapshot&)>& edit) {
+    std::lock_guard lock(write_mutex_);
+    auto next = std::make_shared<Snapshot>(*load());
+    edit(*next);
+    next->version++;
+#ifdef __cpp_lib_atomic_shared_ptr
+    snapshot_.store(std::move(next), std::memory_order_release);
+#else
+    std::atomic_store_explicit(&snapshot_, SnapshotPtr(std::move(next)),
+                               std::memory_order_release);
+#endif
+}
+
+// Published tries are never modified: edit a copy, which shares every node
+// off the pattern's path
+void Registry::update_patterns(Snapshot& s, const std::string& route, bool add) {
+    auto trie = s.patterns ? std::make_shared<RouteTrie>(*s.patterns)
+                           : std::make_shared<RouteTrie>();
+    if (add) trie->Insert(route);
+    else     trie->Erase(route);
+    s.patterns = trie->Size() ? std::move(trie) : nullptr;
+}
+
 // --- Component registration ---
 
+namespace {
+
+// Each caller gets its own root over the shared children, carrying the
+// cached HTML: it can set attributes on it or insert it into a page
+// without touching what other callers got
+Element own_copy(const Element& shared) {
+    return shared ? shared->ShallowClone() : nullptr;
+}
+
+} // namespace
+
+Element Registry::ComponentEntry::Create(const nlohmann::json& data) const {
+    if (memo == Memo::None) return factory(data);
+
+    auto key = data.dump();
+    {
+        std::lock_guard lock(memo_mutex);
+        if (auto it = memo_results.find(key); it != memo_results.end()) {
+            hits.fetch_add(1, std::memory_order_relaxed);
+            return own_copy(it->second);
+        }
+    }
+    misses.fetch_add(1, std::memory_order_relaxed);
+    auto result = factory(data);
+    // Render once before sharing: concurrent renders then only read the cache
+    if (result) HtmlRenderer::RenderToString(result);
+
+    std::lock_guard lock(memo_mutex);
+    if (memo_results.size() >= kMaxMemoEntries) memo_results.clear();
+    // A concurrent miss may have won: everyone gets the same subtree
+    return own_copy(memo_results.try_emplace(std::move(key), std::move(result)).first->second);
+}
+
 void Registry::RegisterComponent(const std::string& name,
                                   ComponentFactory factory) {
-    std::unique_lock lock(mutex_);
-    components_[name] = std::move(factory);
+    RegisterComponent(name, std::move(factory), Memo::None);
+}
+
+// Built field by field: the memo mutex makes the entry immovable
+std::shared_ptr<const Registry::ComponentEntry> Registry::make_component(ComponentFactory factory,
+                                                                         Memo memo) {
+    auto entry = std::make_shared<ComponentEntry>();
+    entry->factory = std::move(factory);
+    entry->memo    = memo;
+    return entry;
+}
+
+void Registry::RegisterComponent(const std::string& name,
+                                  ComponentFactory factory, Memo memo) {
+    auto entry = make_component(std::move(factory), memo);
+    update([&](Snapshot& s) { s.components.Set(name, std::move(entry)); });
 }
 
 void Registry::UnregisterComponent(const std::string& name) {
-    std::unique_lock lock(mutex_);
-    components_.erase(name);
+    update([&](Snapshot& s) { s.components.Erase(name); });
 }
 
 bool Registry::HasComponent(const std::string& name) const {
-    std::shared_lock lock(mutex_);
-    return components_.contains(name);
+    return load()->components.Find(name) != nullptr;
 }
 
-Element Registry::CreateComponent(const std::string& name,
-                                   const nlohmann::json& data) const {
-    std::shared_lock lock(mutex_);
-    auto it = components_.find(name);
-    if (it == components_.end()) {
+const Registry::ComponentEntry& Registry::find_component(const Snapshot& s,
+                                                         const std::string& name) {
+    auto* entry = s.components.Find(name);
+    if (!entry) {
         throw std::runtime_error("Component not found: " + name);
     }
-    auto factory = it->second;
-    lock.unlock();
-    return factory(data);
+    return *entry;
+}
+
+std::string Registry::props_mismatch(const std::string& name, const ComponentEntry& entry,
+                                     const std::type_info& got) {
+    if (!entry.props_type) {
+        return "Component " + name + " takes JSON data; props of type " + got.name() +
+               " do not convert to JSON";
+    }
+    return "Component " + name + " expects props of type " + entry.props_type->name() +
+           ", got " + got.name();
+}
+
+Registry::ComponentStats Registry::GetComponentStats(const std::string& name) const {
+    auto snapshot = load();
+    const auto& entry = find_component(*snapshot, name);
+    ComponentStats stats;
+    stats.hits   = entry.hits;
+    stats.misses = entry.misses;
+    std::lock_guard lock(entry.memo_mutex);
+    stats.entries = entry.memo_results.size();
+    return stats;
+}
+
+Element Registry::CreateComponent(const std::string& name,
+                                   const nlohmann::json& data) const {
+    auto snapshot = load();
+    return find_component(*snapshot, name).Create(data);
+}
+
+void Registry::RegisterComponentAsync(const std::string& name, AsyncComponentFactory factory) {
+    auto entry = std::make_shared<ComponentEntry>();
+    entry->factory = [factory](const nlohmann::json& data) { return SyncWait(factory(data)); };
+    entry->async_factory = std::move(factory);
+    update([&](Snapshot& s) { s.components.Set(name, std::move(entry)); });
+}
+
+// The snapshot in the coroutine frame keeps the factory alive while suspended
+Task<Element> Registry::CreateComponentAsync(std::string name, nlohmann::json data) const {
+    auto snapshot = load();
+    const auto& entry = find_component(*snapshot, name);
+    if (entry.async_factory) co_return co_await entry.async_factory(std::move(data));
+    co_return entry.Create(data);
+}
+
+Element Registry::SlotComponent(const std::string& name, const nlohmann::json& data,
+                                 Element fallback) const {
+    return slot([this, name, data] { return CreateComponentAsync(name, data); },
+                std::move(fallback));
+}
+
+Element Registry::LazyComponent(const std::string& name,
+                                 const nlohmann::json& data) const {
+    return lazy([this, name, data] { return CreateComponent(name, data); });
 }
 
 // --- Page registration ---
 
 void Registry::RegisterPage(const std::string& route, PageFactory factory) {
-    std::unique_lock lock(mutex_);
-    pages_[route] = std::move(factory);
+    RegisterPage(route, std::move(factory), {});
+}
+
+void Registry::RegisterPage(const std::string& route, PageFactory factory,
+                            std::vector<std::string> cache_tags) {
+    auto entry = std::make_shared<const PageEntry>(
+        PageEntry{std::move(factory), std::move(cache_tags), nullptr});
+    update([&](Snapshot& s) { set_page(s, route, std::move(entry)); });
+    invalidate_page(route);
+}
+
+std::shared_ptr<const Registry::PageEntry> Registry::make_async_page(
+        AsyncPageFactory factory, std::vector<std::string> cache_tags) {
+    return std::make_shared<const PageEntry>(PageEntry{
+        [factory](const nlohmann::json& data) { return SyncWait(factory(data)); },
+        std::move(cache_tags), factory});
+}
+
+void Registry::RegisterPageAsync(const std::string& route, AsyncPageFactory factory,
+                                 std::vector<std::string> cache_tags) {
+    auto entry = make_async_page(std::move(factory), std::move(cache_tags));
+    update([&](Snapshot& s) { set_page(s, route, std::move(entry)); });
+    invalidate_page(route);
 }
 
 void Registry::UnregisterPage(const std::string& route) {
-    std::unique_lock lock(mutex_);
-    pages_.erase(route);
+    update([&](Snapshot& s) { erase_page(s, route); });
+    invalidate_page(route);
+}
+
+// The trie goes first: a rejected pattern leaves the snapshot untouched
+void Registry::set_page(Snapshot& s, const std::string& route,
+                        std::shared_ptr<const PageEntry> entry) {
+    if (RouteTrie::IsPattern(route)) update_patterns(s, route, true);
+    s.pages.Set(route, std::move(entry));
+}
+
+void Registry::erase_page(Snapshot& s, const std::string& route) {
+    if (s.pages.Erase(route) && RouteTrie::IsPattern(route)) update_patterns(s, route, false);
+}
+
+// Runs after the new snapshot is published, so no render of the old
+// factory can be cached past this point (see PageCache::Epoch())
+void Registry::invalidate_page(const std::string& route) const {
+    if (auto cache = load()->page_cache) cache->Invalidate(route);
 }
 
 bool Registry::HasPage(const std::string& route) const {
-    std::shared_lock lock(mutex_);
-    return pages_.contains(route);
+    auto snapshot = load();
+    if (snapshot->pages.Find(route)) return true;
+    RouteParams params;
+    return snapshot->patterns && snapshot->patterns->Match(route, params);
+}
+
+const Registry::PageEntry* Registry::find_page(const Snapshot& s, const std::string& route,
+                                               const std::string*& pattern,
+                                               RouteParams& params) {
+    if (auto* entry = s.pages.Find(route)) {
+        pattern = &route;
+        return entry;
+    }
+    pattern = s.patterns ? s.patterns->Match(route, params) : nullptr;
+    if (!pattern) {
+        throw std::runtime_error("Page not found: " + route);
+    }
+    return s.pages.Find(*pattern);
+}
+
+nlohmann::json Registry::with_params(const nlohmann::json& data, RouteParams& params) {
+    nlohmann::json merged = data.is_object() ? data : nlohmann::json::object();
+    for (auto& [name, value] : params) {
+        merged[name] = std::move(value);
+    }
+    return merged;
 }
 
 Element Registry::CreatePage(const std::string& route,
                               const nlohmann::json& data) const {
-    std::shared_lock lock(mutex_);
-    auto it = pages_.find(route);
-    if (it == pages_.end()) {
-        throw std::runtime_error("Page not found: " + route);
+    auto snapshot = load();
+    const std::string* pattern = nullptr;
+    RouteParams params;
+    auto* entry = find_page(*snapshot, route, pattern, params);
+    if (params.empty()) return entry->factory(data);
+    return entry->factory(with_params(data, params));
+}
+
+Task<Element> Registry::CreatePageAsync(std::string route, nlohmann::json data) const {
+    auto snapshot = load();
+    const std::string* pattern = nullptr;
+    RouteParams params;
+    auto* entry = find_page(*snapshot, route, pattern, params);
+    if (!params.empty()) data = with_params(data, params);
+    if (entry->async_factory) co_return co_await entry->async_factory(std::move(data));
+    co_return entry->factory(data);
+}
+
+PageHtml Registry::RenderPage(const std::string& route,
+                               const nlohmann::json& data) const {
+    auto cache = load()->page_cache;
+    if (!cache) {
+        return std::make_shared<const std::string>(
+            HtmlRenderer::RenderToString(CreatePage(route, data)));
+    }
+
+    // Epoch first, then the snapshot: a factory replaced after this point
+    // bumps the epoch and keeps our render out of the cache
+    uint64_t epoch = cache->Epoch();
+    auto snapshot = load();
+    const std::string* pattern = nullptr;
+    RouteParams params;
+    auto* entry = find_page(*snapshot, route, pattern, params);
+
+    return cache->GetOrRender(route, PageCache::Fingerprint(data), epoch, *pattern,
+                              entry->cache_tags, [&] {
+        auto page = params.empty() ? entry->factory(data)
+                                   : entry->factory(with_params(data, params));
+        return HtmlRenderer::RenderToString(page);
+    });
+}
+
+// --- Page output cache ---
+
+void Registry::EnablePageCache(PageCache::Options opts) {
+    auto cache = std::make_shared<PageCache>(std::move(opts));
+    update([&](Snapshot& s) { s.page_cache = std::move(cache); });
+}
+
+void Registry::DisablePageCache() {
+    update([](Snapshot& s) { s.page_cache.reset(); });
+}
+
+std::shared_ptr<PageCache> Registry::GetPageCache() const {
+    return load()->page_cache;
+}
+
+// --- Transactions ---
+
+Registry::Transaction::Transaction(Registry& registry) : registry_(registry) {}
+
+void Registry::Transaction::RegisterComponent(const std::string& name,
+                                              ComponentFactory factory, Memo memo) {
+    ops_.push_back([name, entry = make_component(std::move(factory), memo)](Snapshot& s) {
+        s.components.Set(name, entry);
+    });
+}
+
+void Registry::Transaction::UnregisterComponent(const std::string& name) {
+    ops_.push_back([name](Snapshot& s) { s.components.Erase(name); });
+}
+
+void Registry::Transaction::RegisterPage(const std::string& route, PageFactory factory,
+                                         std::vector<std::string> cache_tags) {
+    auto entry = std::make_shared<const PageEntry>(
+        PageEntry{std::move(factory), std::move(cache_tags), nullptr});
+    ops_.push_back([route, entry](Snapshot& s) { set_page(s, route, entry); });
+    routes_.push_back(route);
+}
+
+void Registry::Transaction::RegisterPageAsync(const std::string& route, AsyncPageFactory factory,
+                                              std::vector<std::string> cache_tags) {
+    auto entry = make_async_page(std::move(factory), std::move(cache_tags));
+    ops_.push_back([route, entry](Snapshot& s) { set_page(s, route, entry); });
+    routes_.push_back(route);
+}
+
+void Registry::Transaction::UnregisterPage(const std::string& route) {
+    ops_.push_back([route](Snapshot& s) { erase_page(s, route); });
+    routes_.push_back(route);
+}
+
+void Registry::Transaction::Commit() {
+    if (ops_.empty()) return;
+    registry_.update([&](Snapshot& s) {
+        for (const auto& op : ops_) op(s);
+    });
+    ops_.clear();
+
+    // After publishing, as in invalidate_page()
+    if (auto cache = registry_.GetPageCache()) {
+        std::sort(routes_.begin(), routes_.end());
+        routes_.erase(std::unique(routes_.begin(), routes_.end()), routes_.end());
+        for (const auto& route : routes_) cache->Invalidate(route);
     }
-    auto factory = it->second;
-    lock.unlock();
-    return factory(data);
+    routes_.clear();
 }
 
 // --- Introspection ---
 
 std::vector<std::string> Registry::ComponentNames() const {
-    std::shared_lock lock(mutex_);
+    auto snapshot = load();
     std::vector<std::string> names;
-    names.reserve(components_.size());
-    for (const auto& [name, _] : components_) {
+    names.reserve(snapshot->components.Size());
+    snapshot->components.ForEach([&](const std::string& name, const auto&) {
         names.push_back(name);
-    }
+    });
+    std::sort(names.begin(), names.end());
     return names;
 }
 
 std::vector<std::string> Registry::PageRoutes() const {
-    std::shared_lock lock(mutex_);
+    auto snapshot = load();
     std::vector<std::string> routes;
-    routes.reserve(pages_.size());
-    for (const auto& [route, _] : pages_) {
-        routes.push_back(route);
-    }
+    routes.reserve(snapshot->pages.Size() - (snapshot->patterns ? snapshot->patterns->Size() : 0));
+    snapshot->pages.ForEach([&](const std::string& route, const auto&) {
+        if (!RouteTrie::IsPattern(route)) routes.push_back(route);
+    });
+    std::sort(routes.begin(), routes.end());
     return routes;
 }
 
+std::vector<std::string> Registry::PagePatterns() const {
+    auto snapshot = load();
+    std::vector<std::string> patterns;
+    if (!snapshot->patterns) return patterns;
+    patterns.reserve(snapshot->patterns->Size());
+    snapshot->pages.ForEach([&](const std::string& route, const auto&) {
+        if (RouteTrie::IsPattern(route)) patterns.push_back(route);
+    });
+    std::sort(patterns.begin(), patterns.end());
+    return patterns;
+}
+
+uint64_t Registry::Version() const {
+    return load()->version;
+}
+
 } // namespace fwui
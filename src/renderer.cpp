@@ -1,9 +1,122 @@
 #include "fwui/renderer.hpp"
+#include "fwui/elements.hpp"
+#include "fwui/task.hpp"
 
 #include <fmt/format.h>
 
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <streambuf>
+#include <string_view>
+#include <vector>
+
 namespace fwui {
 
+// RenderTo() hands the buffer to the sink once it grows past this, at row
+// boundaries of streamed content
+static constexpr size_t kFlushThreshold = 64 * 1024;
+
+// RenderStream(): moves a filled <template>'s content over its placeholder
+static constexpr std::string_view kSlotSwapScript =
+    "<script>function fwuiSwap(n){var s=document.getElementById('fwui-slot-'+n),"
+    "t=document.getElementById('fwui-fill-'+n);if(s&&t){s.replaceWith(t.content);t.remove()}}"
+    "</script>";
+
+namespace {
+
+// Stream over the render buffer for raw_sink() writers. With a sink, full
+// chunks go out as they are written.
+class BufferStreambuf final : public std::streambuf {
+public:
+    BufferStreambuf(fmt::memory_buffer& buf, std::ostream* sink) : buf_(buf), sink_(sink) {}
+
+protected:
+    std::streamsize xsputn(const char* data, std::streamsize n) override {
+        buf_.append(data, data + n);
+        flush_full();
+        return n;
+    }
+    int overflow(int c) override {
+        if (c != traits_type::eof()) {
+            buf_.push_back(static_cast<char>(c));
+            flush_full();
+        }
+        return traits_type::not_eof(c);
+    }
+
+private:
+    fmt::memory_buffer& buf_;
+    std::ostream*       sink_;
+
+    void flush_full() {
+        if (!sink_ || buf_.size() < kFlushThreshold) return;
+        sink_->write(buf_.data(), static_cast<std::streamsize>(buf_.size()));
+        buf_.clear();
+    }
+};
+
+// Slot results in completion order, handed from executor threads to RenderStream()
+struct SlotResults {
+    struct Done {
+        size_t             index;
+        Element            content;
+        std::exception_ptr error;
+    };
+
+    std::mutex              mutex;
+    std::condition_variable ready;
+    std::deque<Done>        done;
+
+    void push(Done result) {
+        {
+            std::lock_guard lock(mutex);
+            done.push_back(std::move(result));
+        }
+        ready.notify_one();
+    }
+
+    Done pop() {
+        std::unique_lock lock(mutex);
+        ready.wait(lock, [this] { return !done.empty(); });
+        auto result = std::move(done.front());
+        done.pop_front();
+        return result;
+    }
+};
+
+// Shared ownership: a render that throws early leaves these running
+detail::Detached run_slot(Task<Element> task, std::shared_ptr<SlotResults> results,
+                          size_t index, Executor& executor) {
+    co_await executor.Schedule();
+    SlotResults::Done result{index, nullptr, nullptr};
+    try {
+        result.content = co_await std::move(task);
+    } catch (...) {
+        result.error = std::current_exception();
+    }
+    results->push(std::move(result));
+}
+
+// Slots RenderStream() can defer: not under a cached node, lazy() content
+// or another slot
+void collect_slots(const Element& node, std::unordered_map<const Node*, size_t>& ids,
+                   std::vector<const SlotNode*>& slots) {
+    if (!node || !node->HtmlCache().empty()) return;
+    if (node->IsSlot()) {
+        if (ids.emplace(node.get(), slots.size()).second) {
+            slots.push_back(static_cast<const SlotNode*>(node.get()));
+        }
+        return;
+    }
+    if (node->IsDeferred()) return;
+    for (const auto& child : node->Children()) collect_slots(child, ids, slots);
+}
+
+} // namespace
+
 // ============================================================================
 // HtmlRenderer
 // ============================================================================
@@ -24,10 +137,96 @@ std::string HtmlRenderer::Render(const Element& root) const {
     if (!cache.empty()) return cache;
 
     fmt::memory_buffer buf;
-    render_node(root, buf, 0);
+    RenderState state;
+    render_node(root, buf, 0, state);
     return fmt::to_string(buf);
 }
 
+void HtmlRenderer::RenderTo(const Element& root, std::ostream& out) const {
+    if (!root) return;
+
+    const auto& cache = root->HtmlCache();
+    if (!cache.empty()) {
+        out.write(cache.data(), static_cast<std::streamsize>(cache.size()));
+        return;
+    }
+
+    fmt::memory_buffer buf;
+    RenderState state;
+    state.sink = &out;
+    render_node(root, buf, 0, state);
+    out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+}
+
+void HtmlRenderer::RenderStream(const Element& root, std::ostream& out) const {
+    RenderStream(root, out, Executor::Default());
+}
+
+void HtmlRenderer::RenderStream(const Element& root, std::ostream& out,
+                                Executor& executor) const {
+    std::unordered_map<const Node*, size_t> ids;
+    std::vector<const SlotNode*> slots;
+    collect_slots(root, ids, slots);
+    if (slots.empty()) {
+        RenderTo(root, out);
+        return;
+    }
+
+    // Start every slot before rendering the shell
+    auto results = std::make_shared<SlotResults>();
+    for (size_t i = 0; i < slots.size(); ++i) {
+        const auto& open = slots[i]->Opener();
+        if (!open) {
+            results->push({i, nullptr, nullptr});
+            continue;
+        }
+        try {
+            run_slot(open(), results, i, executor);
+        } catch (...) {
+            results->push({i, nullptr, std::current_exception()});
+        }
+    }
+
+    // Shell: everything up to </body>, sent right away
+    fmt::memory_buffer buf;
+    RenderState state;
+    state.sink  = &out;
+    state.slots = &ids;
+    render_node(root, buf, 0, state);
+
+    std::string_view html(buf.data(), buf.size());
+    auto body_end = html.rfind("</body>");
+    if (body_end == std::string_view::npos) body_end = html.size();
+    out.write(html.data(), static_cast<std::streamsize>(body_end));
+    out.write(kSlotSwapScript.data(), static_cast<std::streamsize>(kSlotSwapScript.size()));
+    out.flush();
+
+    // Fills, in completion order
+    std::exception_ptr first_error;
+    for (size_t remaining = slots.size(); remaining > 0; --remaining) {
+        auto done = results->pop();
+        if (done.error) {
+            if (!first_error) first_error = done.error;
+            continue;
+        }
+        if (!done.content) continue;
+
+        fmt::memory_buffer fill;
+        fmt::format_to(std::back_inserter(fill), "<template id=\"fwui-fill-{}\">", done.index);
+        RenderState fill_state;
+        fill_state.sink = &out;
+        render_node(done.content, fill, 0, fill_state);
+        fmt::format_to(std::back_inserter(fill), "</template><script>fwuiSwap({})</script>",
+                       done.index);
+        out.write(fill.data(), static_cast<std::streamsize>(fill.size()));
+        out.flush();
+    }
+
+    out.write(html.data() + body_end, static_cast<std::streamsize>(html.size() - body_end));
+    out.flush();
+    if (first_error) std::rethrow_exception(first_error);
+}
+
 void HtmlRenderer::format_opening_tag(const Element& node,
                                        fmt::memory_buffer& buf) const {
     auto out = std::back_inserter(buf);
@@ -43,9 +242,10 @@ void HtmlRenderer::format_opening_tag(const Element& node,
         fmt::format_to(out, " class=\"{}\"", Node::EscapeHTML(cls));
     }
 
-    // Styles
-    if (auto style = node->StyleString(); !style.empty()) {
-        fmt::format_to(out, " style=\"{}\"", Node::EscapeHTML(style));
+    // Styles — pre-rendered and escaped once per interned block
+    if (const auto& styles = node->SharedStyles()) {
+        const auto& attr = styles->Attribute();
+        buf.append(attr.data(), attr.data() + attr.size());
     }
 
     // Other attributes (skip id — already handled)
@@ -65,18 +265,68 @@ void HtmlRenderer::format_opening_tag(const Element& node,
     }
 }
 
-void HtmlRenderer::render_node(const Element& node, fmt::memory_buffer& buf,
-                                int depth) const {
-    if (!node) return;
+bool HtmlRenderer::render_node(const Element& node, fmt::memory_buffer& buf,
+                                int depth, RenderState& state) const {
+    if (!node) return true;
 
     // Subtree cache check — emit cached HTML directly
     const auto& cache = node->HtmlCache();
     if (!cache.empty()) {
         buf.append(cache.data(), cache.data() + cache.size());
-        return;
+        return true;
     }
 
     size_t html_start = buf.size();  // record for caching later
+    auto store_cache = [&]() {
+        // Rows of a streamed node are freed right after rendering
+        if (state.streaming > 0) return;
+        node->SetHtmlCache(std::string(buf.data() + html_start, buf.size() - html_start));
+    };
+
+    // Streamed node (for_each_row()) — rows are rendered one at a time and
+    // may be flushed to the sink in between; nothing above it is cached
+    if (node->IsStreamed()) {
+        state.streaming++;
+        node->ForEachDeferred([&](const Element& row) {
+            render_node(row, buf, depth, state);
+            if (state.sink && buf.size() >= kFlushThreshold) {
+                state.sink->write(buf.data(), static_cast<std::streamsize>(buf.size()));
+                buf.clear();
+            }
+        });
+        state.streaming--;
+        return false;
+    }
+
+    // Raw sink (raw_sink()) — written straight into the buffer, never cached
+    if (node->IsRawSink()) {
+        BufferStreambuf streambuf(buf, state.sink);
+        std::ostream out(&streambuf);
+        static_cast<const RawSinkNode&>(*node).Write(out);
+        return false;
+    }
+
+    // Slot sent later by RenderStream() — a placeholder holding the fallback
+    if (node->IsSlot() && state.slots) {
+        if (auto it = state.slots->find(node.get()); it != state.slots->end()) {
+            fmt::format_to(std::back_inserter(buf),
+                           "<fwui-slot id=\"fwui-slot-{}\" style=\"display: contents\">",
+                           it->second);
+            render_node(static_cast<const SlotNode&>(*node).Fallback(), buf, depth, state);
+            fmt::format_to(std::back_inserter(buf), "</fwui-slot>");
+            return false;
+        }
+    }
+
+    // Deferred node (lazy()) — a fragment whose content is built only now
+    if (node->IsDeferred()) {
+        bool cacheable = true;
+        node->ForEachDeferred([&](const Element& child) {
+            cacheable = render_node(child, buf, depth, state) && cacheable;
+        });
+        if (cacheable) store_cache();
+        return cacheable;
+    }
 
     auto out = std::back_inserter(buf);
 
@@ -93,7 +343,7 @@ void HtmlRenderer::render_node(const Element& node, fmt::memory_buffer& buf,
     };
 
     const auto& tag      = node->Tag();
-    const auto& text     = node->TextContent();
+    const auto  text     = node->TextView();
     const auto& children = node->Children();
 
     bool has_styles  = !node->Styles().empty();
@@ -110,23 +360,22 @@ void HtmlRenderer::render_node(const Element& node, fmt::memory_buffer& buf,
     if (tag.empty()) {
         if (node->IsRaw()) {
             indent();
-            fmt::format_to(out, "{}", text);
+            buf.append(text.data(), text.data() + text.size());
             newline();
-            return;
+            return true;
         }
 
         if (!has_decoration) {
             indent();
             fmt::format_to(out, "{}", Node::EscapeHTML(text));
             newline();
-            return;
+            return true;
         }
 
         // Styled text node -> wrap in <span>
         indent();
-        auto span_node = std::make_shared<Node>("span", text);
-        for (const auto& [k, v] : node->Styles())
-            span_node->SetStyle(k, v);
+        auto span_node = std::make_shared<Node>("span", std::string(text));
+        span_node->SetSharedStyles(node->SharedStyles());
         for (const auto& c : node->Classes())
             span_node->AddClass(c);
         for (const auto& [k, v] : node->Attributes())
@@ -138,7 +387,7 @@ void HtmlRenderer::render_node(const Element& node, fmt::memory_buffer& buf,
         fmt::format_to(out, "{}", Node::EscapeHTML(text));
         fmt::format_to(out, "</span>");
         newline();
-        return;
+        return true;
     }
 
     // Self-closing elements
@@ -147,8 +396,8 @@ void HtmlRenderer::render_node(const Element& node, fmt::memory_buffer& buf,
         format_opening_tag(node, buf);
         newline();
         // Cache this void element
-        node->SetHtmlCache(std::string(buf.data() + html_start, buf.size() - html_start));
-        return;
+        store_cache();
+        return true;
     }
 
     // Normal element with tag
@@ -162,29 +411,38 @@ void HtmlRenderer::render_node(const Element& node, fmt::memory_buffer& buf,
         out = std::back_inserter(buf);
         fmt::format_to(out, "</{}>", tag);
         newline();
-        node->SetHtmlCache(std::string(buf.data() + html_start, buf.size() - html_start));
-        return;
+        store_cache();
+        return true;
     }
 
     if (has_text && !has_children) {
+        // Raw payloads (<style>, <script>, svg()) are emitted verbatim
+        if (node->IsRaw()) {
+            buf.append(text.data(), text.data() + text.size());
+        } else {
+            auto escaped = Node::EscapeHTML(text);
+            buf.append(escaped.data(), escaped.data() + escaped.size());
+        }
         out = std::back_inserter(buf);
-        fmt::format_to(out, "{}</{}>", Node::EscapeHTML(text), tag);
+        fmt::format_to(out, "</{}>", tag);
         newline();
-        node->SetHtmlCache(std::string(buf.data() + html_start, buf.size() - html_start));
-        return;
+        store_cache();
+        return true;
     }
 
     // Has children
     newline();
+    bool cacheable = true;
     for (const auto& child : children) {
-        render_node(child, buf, depth + 1);
+        cacheable = render_node(child, buf, depth + 1, state) && cacheable;
     }
     indent();
     out = std::back_inserter(buf);
     fmt::format_to(out, "</{}>", tag);
     newline();
-    // Cache this subtree
-    node->SetHtmlCache(std::string(buf.data() + html_start, buf.size() - html_start));
+    // Cache this subtree unless it holds streamed content
+    if (cacheable) store_cache();
+    return cacheable;
 }
 
 // ============================================================================
@@ -0,0 +1,181 @@
+#include "fwui/route_trie.hpp"
+
+#include <functional>
+#include <stdexcept>
+
+namespace fwui {
+
+namespace {
+
+// Heterogeneous lookup: find a string_view segment without allocating
+struct SegmentHash {
+    using is_transparent = void;
+    size_t operator()(std::string_view s) const { return std::hash<std::string_view>{}(s); }
+};
+
+std::vector<std::string_view> split_segments(std::string_view route) {
+    if (!route.empty() && route.front() == '/') route.remove_prefix(1);
+    std::vector<std::string_view> segments;
+    while (true) {
+        auto slash = route.find('/');
+        segments.push_back(route.substr(0, slash));
+        if (slash == std::string_view::npos) break;
+        route.remove_prefix(slash + 1);
+    }
+    return segments;
+}
+
+} // namespace
+
+struct RouteTrie::Node {
+    std::unordered_map<std::string, NodePtr, SegmentHash, std::equal_to<>> statics;
+    NodePtr param;     // `:name`
+    NodePtr wildcard;  // `*name`, always a leaf
+
+    // Terminal nodes: the pattern and its parameter names in capture order
+    bool                     terminal = false;
+    std::string              pattern;
+    std::vector<std::string> names;
+
+    bool empty() const { return !terminal && statics.empty() && !param && !wildcard; }
+};
+
+bool RouteTrie::IsPattern(std::string_view route) {
+    for (size_t i = 0; i < route.size(); ++i) {
+        if ((route[i] == ':' || route[i] == '*') && (i == 0 || route[i - 1] == '/')) return true;
+    }
+    return false;
+}
+
+void RouteTrie::Insert(const std::string& pattern) {
+    auto segments = split_segments(pattern);
+    for (size_t i = 0; i < segments.size(); ++i) {
+        auto segment = segments[i];
+        if (segment.empty() || (segment.front() != ':' && segment.front() != '*')) continue;
+        if (segment.size() == 1) {
+            throw std::runtime_error("Route parameter without a name: " + pattern);
+        }
+        if (segment.front() == '*' && i + 1 != segments.size()) {
+            throw std::runtime_error("Route wildcard must be the last segment: " + pattern);
+        }
+    }
+
+    std::vector<std::string> names;
+    bool added = false;
+    root_ = insert(root_.get(), segments, 0, pattern, names, added);
+    if (added) size_++;
+}
+
+bool RouteTrie::Erase(const std::string& pattern) {
+    if (!root_) return false;
+    bool removed = false;
+    auto root = erase(root_.get(), split_segments(pattern), 0, pattern, removed);
+    if (!removed) return false;
+    root_ = std::move(root);
+    size_--;
+    return true;
+}
+
+RouteTrie::NodePtr RouteTrie::insert(const Node* node, const std::vector<std::string_view>& segments,
+                                     size_t index, const std::string& pattern,
+                                     std::vector<std::string>& names, bool& added) {
+    auto copy = node ? std::make_shared<Node>(*node) : std::make_shared<Node>();
+
+    if (index == segments.size()) {
+        if (copy->terminal && copy->pattern != pattern) {
+            throw std::runtime_error("Route pattern " + pattern + " conflicts with " + copy->pattern);
+        }
+        added          = !copy->terminal;
+        copy->terminal = true;
+        copy->pattern  = pattern;
+        copy->names    = std::move(names);
+        return copy;
+    }
+
+    auto segment = segments[index];
+    char kind = segment.empty() ? 0 : segment.front();
+    if (kind == ':' || kind == '*') {
+        names.emplace_back(segment.substr(1));
+        auto& child = kind == ':' ? copy->param : copy->wildcard;
+        child = insert(child.get(), segments, index + 1, pattern, names, added);
+    } else {
+        auto it = copy->statics.find(segment);
+        auto child = insert(it == copy->statics.end() ? nullptr : it->second.get(),
+                            segments, index + 1, pattern, names, added);
+        copy->statics.insert_or_assign(std::string(segment), std::move(child));
+    }
+    return copy;
+}
+
+RouteTrie::NodePtr RouteTrie::erase(const Node* node, const std::vector<std::string_view>& segments,
+                                    size_t index, const std::string& pattern, bool& removed) {
+    if (!node) return nullptr;
+    auto copy = std::make_shared<Node>(*node);
+
+    if (index == segments.size()) {
+        if (!copy->terminal || copy->pattern != pattern) return copy;
+        removed        = true;
+        copy->terminal = false;
+        copy->pattern.clear();
+        copy->names.clear();
+    } else {
+        auto segment = segments[index];
+        char kind = segment.empty() ? 0 : segment.front();
+        if (kind == ':' || kind == '*') {
+            auto& child = kind == ':' ? copy->param : copy->wildcard;
+            child = erase(child.get(), segments, index + 1, pattern, removed);
+        } else if (auto it = copy->statics.find(segment); it != copy->statics.end()) {
+            auto child = erase(it->second.get(), segments, index + 1, pattern, removed);
+            if (child) it->second = std::move(child);
+            else copy->statics.erase(it);
+        }
+    }
+    // Prune branches that no longer lead to a pattern
+    return copy->empty() ? nullptr : copy;
+}
+
+const std::string* RouteTrie::Match(std::string_view path, RouteParams& params) const {
+    if (!root_) return nullptr;
+    auto segments = split_segments(path);
+    std::vector<std::string_view> values;
+    const Node* found = nullptr;
+    if (!match(*root_, segments, 0, path.data() + path.size(), values, found)) return nullptr;
+
+    params.clear();
+    params.reserve(values.size());
+    for (size_t i = 0; i < values.size(); ++i) {
+        params.emplace_back(found->names[i], std::string(values[i]));
+    }
+    return &found->pattern;
+}
+
+bool RouteTrie::match(const Node& node, const std::vector<std::string_view>& segments,
+                      size_t index, const char* end,
+                      std::vector<std::string_view>& values, const Node*& found) {
+    if (index == segments.size()) {
+        if (!node.terminal) return false;
+        found = &node;
+        return true;
+    }
+
+    auto segment = segments[index];
+    if (auto it = node.statics.find(segment); it != node.statics.end()) {
+        if (match(*it->second, segments, index + 1, end, values, found)) return true;
+    }
+    if (node.param && !segment.empty()) {
+        values.push_back(segment);
+        if (match(*node.param, segments, index + 1, end, values, found)) return true;
+        values.pop_back();
+    }
+    if (node.wildcard && node.wildcard->terminal) {
+        std::string_view rest(segment.data(), static_cast<size_t>(end - segment.data()));
+        if (!rest.empty()) {
+            values.push_back(rest);
+            found = node.wildcard.get();
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace fwui
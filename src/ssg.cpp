@@ -8,6 +8,7 @@
 //     --minify                 Minify HTML output
 //     --pretty                 Pretty-print HTML (default)
 //     --clean                  Remove output dir before build
+//     --changed <file>         Rebuild only template pages built from <file>
 //     --help, -h               Show usage
 
 #include <fwui/fwui.hpp>
@@ -17,6 +18,7 @@
 #include <fstream>
 #include <iostream>
 #include <string>
+#include <vector>
 
 namespace fs = std::filesystem;
 
@@ -31,6 +33,7 @@ struct Config {
     bool minify = false;
     bool pretty = true;
     bool clean  = false;
+    std::vector<std::string> changed;  // --changed: incremental build
 };
 
 static void print_usage() {
@@ -49,6 +52,8 @@ static void print_usage() {
         "  --minify                 Minify HTML output\n"
         "  --pretty                 Pretty-print HTML (default)\n"
         "  --clean                  Remove output dir before build\n"
+        "  --changed <file>         Rebuild only template pages built from <file>\n"
+        "                           (repeatable; needs --pages)\n"
         "  --help, -h               Show this message\n";
 }
 
@@ -77,6 +82,8 @@ static Config parse_args(int argc, char* argv[]) {
             cfg.minify = false;
         } else if (arg == "--clean") {
             cfg.clean = true;
+        } else if (arg == "--changed" && i + 1 < argc) {
+            cfg.changed.push_back(argv[++i]);
         } else {
             std::cerr << "Unknown option: " << arg << "\n";
             print_usage();
@@ -122,12 +129,11 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
-    // Set template directory
-    if (!cfg.template_dir.empty()) {
-        TemplateEngine::SetTemplateDirectory(cfg.template_dir);
-    }
-
     // Clean output
+    if (cfg.clean && !cfg.changed.empty()) {
+        std::cerr << "Error: --clean removes the pages --changed would keep\n";
+        return 1;
+    }
     if (cfg.clean && fs::exists(cfg.output_dir)) {
         fs::remove_all(cfg.output_dir);
     }
@@ -140,16 +146,30 @@ int main(int argc, char* argv[]) {
     pages::RegisterSSGPages(registry);
 
     // Load template pages if --pages specified (override C++ pages)
+    auto routes = registry.PageRoutes();
     if (!cfg.pages_dir.empty()) {
         TemplatePageLoader loader({
-            cfg.pages_dir,
-            cfg.data_dir.empty() ? "data" : cfg.data_dir,
-            cfg.template_dir.empty() ? "templates" : cfg.template_dir
+            .pages_dir     = cfg.pages_dir,
+            .data_dir      = cfg.data_dir.empty() ? "data" : cfg.data_dir,
+            .templates_dir = cfg.template_dir.empty() ? "templates" : cfg.template_dir,
         });
         auto tpl_routes = loader.LoadPages(registry);
         for (const auto& r : tpl_routes) {
             std::cout << "  [template] " << r << "\n";
         }
+        routes = registry.PageRoutes();
+
+        // Incremental build: only pages whose template, includes or data changed
+        if (!cfg.changed.empty()) {
+            routes = loader.Dependencies().Affected(cfg.changed);
+            // A pattern has no file of its own to write
+            std::erase_if(routes, [](const std::string& r) { return RouteTrie::IsPattern(r); });
+            std::cout << "  " << routes.size() << " pages affected by "
+                      << cfg.changed.size() << " changed files\n";
+        }
+    } else if (!cfg.changed.empty()) {
+        std::cerr << "Error: --changed needs --pages\n";
+        return 1;
     }
 
     // Configure renderer
@@ -159,7 +179,6 @@ int main(int argc, char* argv[]) {
     HtmlRenderer renderer(opts);
 
     // Render each page
-    auto routes = registry.PageRoutes();
     int rendered = 0;
     int errors = 0;
 
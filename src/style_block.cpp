@@ -0,0 +1,152 @@
+#include "fwui/style_block.hpp"
+#include "fwui/core.hpp"
+
+#include <functional>
+#include <vector>
+
+namespace fwui {
+
+// --- Pool ---
+
+namespace {
+
+struct PoolEntry {
+    const StyleBlock*                raw;
+    std::weak_ptr<const StyleBlock>  weak;
+};
+
+struct StylePool {
+    std::mutex                                   mutex;
+    std::unordered_multimap<size_t, PoolEntry>   blocks;
+};
+
+// Leaked on purpose: blocks owned by static Elements may be released after
+// function-local statics are destroyed.
+StylePool& pool() {
+    static auto* p = new StylePool;
+    return *p;
+}
+
+size_t hash_styles(const StyleMap& styles) {
+    size_t h = styles.size();
+    std::hash<std::string> hasher;
+    for (const auto& [prop, val] : styles) {
+        h ^= hasher(prop) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+        h ^= hasher(val)  + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+    }
+    return h;
+}
+
+} // namespace
+
+StyleBlock::StyleBlock(StyleMap styles, size_t hash)
+    : styles_(std::move(styles)), hash_(hash) {
+    for (const auto& [prop, val] : styles_) {
+        if (!css_.empty()) css_ += ' ';
+        css_ += prop;
+        css_ += ": ";
+        css_ += val;
+        css_ += ';';
+    }
+    if (!css_.empty()) {
+        attribute_ = " style=\"" + Node::EscapeHTML(css_) + "\"";
+    }
+}
+
+StyleBlockPtr StyleBlock::Intern(StyleMap styles) {
+    if (styles.empty()) return nullptr;
+
+    size_t hash = hash_styles(styles);
+    auto& p = pool();
+    std::lock_guard lock(p.mutex);
+
+    auto [first, last] = p.blocks.equal_range(hash);
+    for (auto it = first; it != last; ++it) {
+        if (it->second.raw->styles_ != styles) continue;
+        // May be expired while its deleter waits on the mutex — then fall
+        // through and intern a fresh block next to it.
+        if (auto live = it->second.weak.lock()) return live;
+    }
+
+    auto* raw = new StyleBlock(std::move(styles), hash);
+    StyleBlockPtr block(raw, &StyleBlock::Release);
+    p.blocks.emplace(hash, PoolEntry{raw, block});
+    return block;
+}
+
+void StyleBlock::Release(const StyleBlock* block) {
+    auto& p = pool();
+    {
+        std::lock_guard lock(p.mutex);
+        auto [first, last] = p.blocks.equal_range(block->hash_);
+        for (auto it = first; it != last; ++it) {
+            if (it->second.raw == block) {
+                p.blocks.erase(it);
+                break;
+            }
+        }
+    }
+    delete block;
+}
+
+const StyleBlock& StyleBlock::Empty() {
+    static auto* empty = new StyleBlock({}, 0);
+    return *empty;
+}
+
+size_t StyleBlock::PoolSize() {
+    auto& p = pool();
+    std::lock_guard lock(p.mutex);
+    return p.blocks.size();
+}
+
+// --- Transitions ---
+
+// Unique values (per-node heights, colors from data) would otherwise grow the
+// transition table of a hot block forever.
+static constexpr size_t kMaxTransitions = 256;
+
+StyleBlockPtr StyleBlock::FindTransition(const std::string& key) const {
+    std::lock_guard lock(transitions_mutex_);
+    auto it = transitions_.find(key);
+    return it != transitions_.end() ? it->second.lock() : nullptr;
+}
+
+StyleBlockPtr StyleBlock::StoreTransition(std::string key, StyleMap next) const {
+    auto block = Intern(std::move(next));
+    std::lock_guard lock(transitions_mutex_);
+    if (transitions_.size() >= kMaxTransitions) {
+        std::erase_if(transitions_, [](const auto& t) { return t.second.expired(); });
+        if (transitions_.size() >= kMaxTransitions) transitions_.clear();
+    }
+    transitions_[std::move(key)] = block;
+    return block;
+}
+
+StyleBlockPtr StyleBlock::With(const std::string& property,
+                               const std::string& value) const {
+    std::string key;
+    key.reserve(property.size() + value.size() + 1);
+    key += property;
+    key += '\0';
+    key += value;
+    if (auto hit = FindTransition(key)) return hit;
+
+    StyleMap next = styles_;
+    next[property] = value;
+    return StoreTransition(std::move(key), std::move(next));
+}
+
+StyleBlockPtr StyleBlock::Without(const std::string& property) const {
+    std::string key;
+    key += '\0';
+    key += property;
+    if (auto hit = FindTransition(key)) return hit;
+
+    StyleMap next = styles_;
+    next.erase(property);
+    if (next.empty()) return nullptr;
+    return StoreTransition(std::move(key), std::move(next));
+}
+
+} // namespace fwui
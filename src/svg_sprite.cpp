@@ -0,0 +1,170 @@
+#include "fwui/svg_sprite.hpp"
+#include "fwui/renderer.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <functional>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace fwui {
+
+namespace {
+
+constexpr const char* kSpriteAttr = "data-fwui-sprite";
+
+struct Payload {
+    size_t           hash;
+    std::string_view text;   // view into the first occurrence
+    Elements         nodes;
+};
+
+struct PayloadIndex {
+    std::vector<Payload>                                payloads;  // first-seen order
+    std::unordered_map<size_t, std::vector<size_t>>     by_hash;
+    // Clones share their text buffer: hash each buffer only once
+    std::unordered_map<const char*, size_t>             hashed;
+    size_t                                              seen = 0;
+
+    void add(const Element& node, std::string_view text) {
+        seen++;
+        auto [h, fresh] = hashed.try_emplace(text.data(), 0);
+        if (fresh) h->second = std::hash<std::string_view>{}(text);
+        size_t hash = h->second;
+
+        auto& bucket = by_hash[hash];
+        for (size_t i : bucket) {
+            if (payloads[i].text == text) {
+                payloads[i].nodes.push_back(node);
+                return;
+            }
+        }
+        bucket.push_back(payloads.size());
+        payloads.push_back({hash, text, {node}});
+    }
+};
+
+bool is_svg_payload(const Element& node) {
+    return node->Tag() == "svg" && node->IsRaw() && !node->HasAttribute(kSpriteAttr);
+}
+
+void collect(const Element& node, size_t min_bytes, PayloadIndex& index) {
+    if (!node || node->IsDeferred()) return;
+    if (is_svg_payload(node)) {
+        auto text = node->TextView();
+        if (text.size() >= min_bytes) index.add(node, text);
+        return;
+    }
+    for (const auto& child : node->Children()) collect(child, min_bytes, index);
+}
+
+using Uses = std::unordered_map<const Node*, std::shared_ptr<const std::string>>;
+
+void replace_child(const Element& parent, size_t index, Element child) {
+    parent->RemoveChild(index);
+    parent->InsertChild(index, std::move(child));
+}
+
+// Nodes below the root may be shared with other trees (memoized components,
+// cached subtrees), so a rewritten payload and each of its ancestors are
+// replaced by copies instead of being changed. Returns the copy standing in
+// for `node`, or nullptr when nothing under it was rewritten.
+Element rewrite(const Element& node, const Uses& uses) {
+    if (!node || node->IsDeferred()) return nullptr;
+    if (auto it = uses.find(node.get()); it != uses.end()) {
+        auto copy = node->ShallowClone();
+        copy->SetSharedText(it->second, *it->second);
+        return copy;
+    }
+    Element copy;
+    const auto& children = node->Children();
+    for (size_t i = 0; i < children.size(); ++i) {
+        auto child = rewrite(children[i], uses);
+        if (!child) continue;
+        if (!copy) copy = node->ShallowClone();
+        replace_child(copy, i, std::move(child));
+    }
+    return copy;
+}
+
+// <body> of a document, otherwise the root itself
+Element sprite_parent(const Element& root) {
+    if (root->Tag() == "html") {
+        for (const auto& child : root->Children())
+            if (child->Tag() == "body") return child;
+    }
+    if (root->Tag().empty() || root->IsRaw() || root->IsSelfClosing()) return nullptr;
+    return root;
+}
+
+} // namespace
+
+SvgSpritePass::SvgSpritePass() : opts_() {}
+SvgSpritePass::SvgSpritePass(Options opts) : opts_(std::move(opts)) {}
+
+SvgSpritePass::Report SvgSpritePass::Apply(const Element& root) const {
+    Report report;
+    if (!root) return report;
+
+    auto parent = sprite_parent(root);
+    if (!parent) return report;
+
+    PayloadIndex index;
+    collect(root, opts_.min_bytes, index);
+    report.svgs = index.seen;
+
+    std::string symbols;
+    Uses uses;
+    for (auto& payload : index.payloads) {
+        size_t n = payload.nodes.size();
+        if (n < opts_.min_occurrences) continue;
+
+        auto id = fmt::format("{}{:016x}", opts_.id_prefix, payload.hash);
+        if (index.by_hash[payload.hash].size() > 1) {
+            // Same hash, different markup: disambiguate by first-seen order
+            id += fmt::format("-{}", &payload - index.payloads.data());
+        }
+        auto use = std::make_shared<const std::string>(fmt::format("<use href=\"#{}\"/>", id));
+        auto symbol = fmt::format("<symbol id=\"{}\">{}</symbol>", id, payload.text);
+
+        // Only hoist when it pays for its symbol wrapper
+        if (n * payload.text.size() <= symbol.size() + n * use->size()) continue;
+
+        symbols += symbol;
+        report.symbols++;
+        report.replaced     += n;
+        report.bytes_before += n * payload.text.size();
+        report.bytes_after  += n * use->size();
+        for (const auto& node : payload.nodes) uses.emplace(node.get(), use);
+    }
+    if (symbols.empty()) return report;
+
+    // The root itself is the caller's to change
+    const auto& children = root->Children();
+    for (size_t i = 0; i < children.size(); ++i) {
+        if (auto child = rewrite(children[i], uses)) replace_child(root, i, std::move(child));
+    }
+    if (parent != root) {
+        // <body> may be shared too, and may have been replaced above
+        const auto& top = root->Children();
+        auto it = std::find(top.begin(), top.end(), sprite_parent(root));
+        parent = (*it)->ShallowClone();
+        replace_child(root, static_cast<size_t>(it - top.begin()), parent);
+    }
+
+    auto sprite = std::make_shared<Node>("svg", symbols);
+    sprite->SetRaw(true);
+    sprite->SetAttribute("aria-hidden", "true");
+    sprite->SetAttribute(kSpriteAttr, "");
+    // Not display:none — that breaks gradients and masks referenced by symbols
+    sprite->SetStyleString("position: absolute; width: 0; height: 0; overflow: hidden");
+    parent->PrependChild(sprite);
+
+    report.bytes_after += HtmlRenderer::RenderToString(sprite).size();
+    return report;
+}
+
+} // namespace fwui
@@ -0,0 +1,51 @@
+#include "fwui/task.hpp"
+
+#include <algorithm>
+
+namespace fwui {
+
+Executor::Executor(size_t threads) {
+    if (threads == 0) threads = std::max(4u, std::thread::hardware_concurrency());
+    workers_.reserve(threads);
+    for (size_t i = 0; i < threads; ++i) {
+        workers_.emplace_back([this] { run(); });
+    }
+}
+
+Executor::~Executor() {
+    {
+        std::lock_guard lock(mutex_);
+        stopping_ = true;
+    }
+    ready_.notify_all();
+    for (auto& worker : workers_) worker.join();
+}
+
+void Executor::Post(std::coroutine_handle<> handle) {
+    {
+        std::lock_guard lock(mutex_);
+        queue_.push_back(handle);
+    }
+    ready_.notify_one();
+}
+
+void Executor::run() {
+    while (true) {
+        std::coroutine_handle<> handle;
+        {
+            std::unique_lock lock(mutex_);
+            ready_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+            if (queue_.empty()) return;  // stopping and drained
+            handle = queue_.front();
+            queue_.pop_front();
+        }
+        handle.resume();
+    }
+}
+
+Executor& Executor::Default() {
+    static Executor executor;
+    return executor;
+}
+
+} // namespace fwui
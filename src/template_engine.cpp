@@ -1,28 +1,309 @@
 #include "fwui/template_engine.hpp"
+#include "fwui/registry.hpp"
+#include "fwui/renderer.hpp"
 #include <inja/inja.hpp>
 
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+
+namespace fs = std::filesystem;
+
 namespace fwui {
 
-std::string TemplateEngine::template_dir_;
+namespace {
+
+// String templates kept before the cache starts over
+constexpr size_t kMaxStringTemplates = 1024;
+
+struct CompiledFile {
+    fs::file_time_type                    mtime;
+    uintmax_t                             size = 0;
+    std::shared_ptr<const inja::Template> tmpl;
+};
+
+// A template and the environment holding the partials it includes
+struct Compiled {
+    std::shared_ptr<inja::Environment>    env;
+    std::shared_ptr<const inja::Template> tmpl;
+};
+
+std::string resolve(const std::string& dir, const std::string& path) {
+    if (dir.empty() || fs::path(path).is_absolute()) return path;
+    return (fs::path(dir) / path).string();
+}
+
+std::string read_file(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) throw std::runtime_error("Cannot read template: " + path);
+    return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+}
+
+bool inside(const fs::path& path, const fs::path& dir) {
+    auto p = fs::absolute(path).lexically_normal();
+    auto d = fs::absolute(dir).lexically_normal();
+    auto rel = p.lexically_relative(d);
+    return !rel.empty() && *rel.begin() != "..";
+}
+
+} // namespace
+
+struct TemplateEngine::Impl {
+    std::string dir;
+
+    // Guards the members below; renders run unlocked on what lookup() and
+    // parse() handed them, so a slow output stream or a callback that
+    // renders through this engine blocks nobody.
+    mutable std::shared_mutex                                              mutex;
+    // Parsing stores included partials in the environment. A render may be
+    // using it, so a parse writes to a copy (see writable_env()) and reset()
+    // replaces it; either way the one a render holds stays unchanged.
+    std::shared_ptr<inja::Environment>                                     env;
+    std::vector<std::tuple<std::string, int, Callback>>                    callbacks;
+    std::shared_ptr<const Functions> functions = std::make_shared<const Functions>();
+    std::unordered_map<std::string, std::shared_ptr<const inja::Template>> strings;
+    std::unordered_map<std::string, CompiledFile>                          files;
+    mutable std::atomic<size_t>                                            hits{0};
+    mutable std::atomic<size_t>                                            misses{0};
+
+    // Call with the exclusive lock held
+    void reset() {
+        // Inja joins its input path and include names as plain strings
+        auto input = dir;
+        if (!input.empty() && input.back() != '/') input.push_back('/');
+        env = input.empty() ? std::make_shared<inja::Environment>()
+                            : std::make_shared<inja::Environment>(input);
+        for (const auto& [name, num_args, callback] : callbacks) {
+            env->add_callback(name, num_args, callback);
+        }
+        strings.clear();
+        files.clear();
+    }
+
+    // Call with the exclusive lock held. References to env are only taken
+    // under the lock, so a count of one cannot grow meanwhile: nothing else
+    // uses it and it can be written in place.
+    inja::Environment& writable_env() {
+        if (env.use_count() > 1) env = std::make_shared<inja::Environment>(*env);
+        return *env;
+    }
+
+    Compiled string_template(const std::string& template_str) {
+        {
+            std::shared_lock lock(mutex);
+            if (auto it = strings.find(template_str); it != strings.end()) {
+                hits.fetch_add(1, std::memory_order_relaxed);
+                return {env, it->second};
+            }
+        }
+
+        std::unique_lock lock(mutex);
+        auto it = strings.find(template_str);
+        if (it == strings.end()) {
+            misses.fetch_add(1, std::memory_order_relaxed);
+            auto tmpl = std::make_shared<const inja::Template>(writable_env().parse(template_str));
+            if (strings.size() >= kMaxStringTemplates) strings.clear();
+            it = strings.emplace(template_str, std::move(tmpl)).first;
+        } else {
+            hits.fetch_add(1, std::memory_order_relaxed);
+        }
+        return {env, it->second};
+    }
+
+    Compiled file_template(const std::string& template_path) {
+        auto path = resolve(dir, template_path);
+        std::error_code ec;
+        auto mtime = fs::last_write_time(path, ec);
+        uintmax_t size = ec ? 0 : fs::file_size(path, ec);
+        if (ec) throw std::runtime_error("Template not found: " + path);
+
+        {
+            std::shared_lock lock(mutex);
+            auto it = files.find(path);
+            if (it != files.end() && it->second.mtime == mtime && it->second.size == size) {
+                hits.fetch_add(1, std::memory_order_relaxed);
+                return {env, it->second.tmpl};
+            }
+        }
+
+        // Read outside the lock; a concurrent parse of the same file is harmless
+        auto source = read_file(path);
+
+        std::unique_lock lock(mutex);
+        misses.fetch_add(1, std::memory_order_relaxed);
+        auto tmpl = std::make_shared<const inja::Template>(writable_env().parse(source));
+        files[path] = CompiledFile{mtime, size, tmpl};
+        return {env, std::move(tmpl)};
+    }
+};
+
+TemplateEngine::TemplateEngine(std::string template_dir) : impl_(std::make_unique<Impl>()) {
+    impl_->dir = std::move(template_dir);
+    impl_->reset();
+}
+
+TemplateEngine::~TemplateEngine() = default;
+
+std::string TemplateEngine::RenderString(const std::string& template_str,
+                                         const nlohmann::json& data) const {
+    auto compiled = impl_->string_template(template_str);
+    return compiled.env->render(*compiled.tmpl, data);
+}
+
+std::string TemplateEngine::RenderPath(const std::string& template_path,
+                                       const nlohmann::json& data) const {
+    auto compiled = impl_->file_template(template_path);
+    return compiled.env->render(*compiled.tmpl, data);
+}
+
+void TemplateEngine::RenderStringTo(std::ostream& out, const std::string& template_str,
+                                    const nlohmann::json& data) const {
+    auto compiled = impl_->string_template(template_str);
+    compiled.env->render_to(out, *compiled.tmpl, data);
+}
+
+void TemplateEngine::RenderPathTo(std::ostream& out, const std::string& template_path,
+                                  const nlohmann::json& data) const {
+    auto compiled = impl_->file_template(template_path);
+    compiled.env->render_to(out, *compiled.tmpl, data);
+}
+
+void TemplateEngine::Preload(const std::string& template_path) const {
+    impl_->file_template(template_path);
+}
+
+void TemplateEngine::AddCallback(const std::string& name, int num_args, Callback callback) {
+    std::unique_lock lock(impl_->mutex);
+    auto& callbacks = impl_->callbacks;
+    std::erase_if(callbacks, [&](const auto& c) {
+        return std::get<0>(c) == name && std::get<1>(c) == num_args;
+    });
+    callbacks.emplace_back(name, num_args, callback);
+    auto functions = std::make_shared<Functions>(*impl_->functions);
+    (*functions)[name] = std::move(callback);
+    impl_->functions = std::move(functions);
+    impl_->reset();
+}
+
+void TemplateEngine::BindComponents(const Registry& registry) {
+    AddCallback("component", -1, [&registry](Arguments& args) -> nlohmann::json {
+        if (args.empty() || args.size() > 2 || !args[0]->is_string()) {
+            throw std::runtime_error("component() takes a name and optional data");
+        }
+        auto element = registry.CreateComponent(args[0]->get_ref<const std::string&>(),
+                                                args.size() == 2 ? *args[1] : nlohmann::json{});
+        // A memoized subtree was rendered by the registry: this is a cache hit
+        return HtmlRenderer::RenderToString(element);
+    });
+}
+
+std::shared_ptr<const TemplateEngine::Functions> TemplateEngine::Callbacks() const {
+    std::shared_lock lock(impl_->mutex);
+    return impl_->functions;
+}
+
+const std::string& TemplateEngine::Directory() const {
+    return impl_->dir;
+}
+
+void TemplateEngine::Evict(const std::string& path) {
+    auto& c = *impl_;
+    auto resolved = resolve(c.dir, path);
+    std::unique_lock lock(c.mutex);
+    c.files.erase(resolved);
+    if (!c.dir.empty() && inside(resolved, c.dir)) c.reset();
+}
+
+void TemplateEngine::EvictAll() {
+    std::unique_lock lock(impl_->mutex);
+    impl_->reset();
+}
+
+TemplateEngine::CacheStats TemplateEngine::Stats() const {
+    auto& c = *impl_;
+    std::shared_lock lock(c.mutex);
+    CacheStats stats;
+    stats.hits    = c.hits.load(std::memory_order_relaxed);
+    stats.misses  = c.misses.load(std::memory_order_relaxed);
+    stats.entries = c.strings.size() + c.files.size();
+    return stats;
+}
+
+// --- Default instance ---
+
+namespace {
+
+struct DefaultEngine {
+#ifdef __cpp_lib_atomic_shared_ptr
+    std::atomic<std::shared_ptr<TemplateEngine>> engine{std::make_shared<TemplateEngine>()};
+
+    std::shared_ptr<TemplateEngine> load() const { return engine.load(std::memory_order_acquire); }
+    void store(std::shared_ptr<TemplateEngine> next) {
+        engine.store(std::move(next), std::memory_order_release);
+    }
+#else
+    std::shared_ptr<TemplateEngine> engine = std::make_shared<TemplateEngine>();
+
+    std::shared_ptr<TemplateEngine> load() const {
+        return std::atomic_load_explicit(&engine, std::memory_order_acquire);
+    }
+    void store(std::shared_ptr<TemplateEngine> next) {
+        std::atomic_store_explicit(&engine, std::move(next), std::memory_order_release);
+    }
+#endif
+};
+
+DefaultEngine& default_engine() {
+    static DefaultEngine slot;
+    return slot;
+}
+
+} // namespace
+
+std::shared_ptr<TemplateEngine> TemplateEngine::Default() {
+    return default_engine().load();
+}
 
 std::string TemplateEngine::Render(const std::string& template_str,
                                    const nlohmann::json& data) {
-    inja::Environment env;
-    return env.render(template_str, data);
+    return Default()->RenderString(template_str, data);
 }
 
 std::string TemplateEngine::RenderFile(const std::string& template_path,
                                        const nlohmann::json& data) {
-    if (!template_dir_.empty()) {
-        inja::Environment env(template_dir_);
-        return env.render_file(template_path, data);
-    }
-    inja::Environment env;
-    return env.render_file(template_path, data);
+    return Default()->RenderPath(template_path, data);
+}
+
+void TemplateEngine::RenderTo(std::ostream& out, const std::string& template_str,
+                              const nlohmann::json& data) {
+    Default()->RenderStringTo(out, template_str, data);
+}
+
+void TemplateEngine::RenderFileTo(std::ostream& out, const std::string& template_path,
+                                  const nlohmann::json& data) {
+    Default()->RenderPathTo(out, template_path, data);
 }
 
 void TemplateEngine::SetTemplateDirectory(const std::string& dir) {
-    template_dir_ = dir;
+    default_engine().store(std::make_shared<TemplateEngine>(dir));
+}
+
+void TemplateEngine::Invalidate(const std::string& path) {
+    Default()->Evict(path);
+}
+
+void TemplateEngine::Clear() {
+    Default()->EvictAll();
+}
+
+TemplateEngine::CacheStats TemplateEngine::GetCacheStats() {
+    return Default()->Stats();
 }
 
 } // namespace fwui
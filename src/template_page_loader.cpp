@@ -1,15 +1,231 @@
 #include "fwui/template_page_loader.hpp"
+#include "fwui/data_context.hpp"
 #include "fwui/elements.hpp"
+#include "fwui/task.hpp"
+#include "fwui/template_vm.hpp"
 
+#include <algorithm>
+#include <chrono>
 #include <fstream>
 #include <iostream>
+#include <mutex>
+#include <ostream>
+#include <set>
+#include <type_traits>
 
 namespace fs = std::filesystem;
 
 namespace fwui {
 
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double ms_since(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+template <typename Fn>
+Task<std::invoke_result_t<const Fn&, size_t>> call_at(const Fn& fn, size_t i) {
+    co_return fn(i);
+}
+
+// fn(0) ... fn(n - 1) on `executor`, results in order. Rethrows the first
+// exception once every call has finished.
+template <typename Fn>
+auto parallel_map(size_t n, const Fn& fn, Executor& executor) {
+    using T = std::invoke_result_t<const Fn&, size_t>;
+    std::vector<Task<T>> tasks;
+    tasks.reserve(n);
+    for (size_t i = 0; i < n; ++i) tasks.push_back(call_at(fn, i));
+    return SyncWait(WhenAll(std::move(tasks), executor));
+}
+
+struct Listing {
+    std::vector<fs::path> pages;  // relative to the pages root
+    std::vector<fs::path> dirs;
+};
+
+// One directory of the pages tree. Subdirectories are not followed through
+// symlinks, as with recursive_directory_iterator.
+Listing list_dir(const fs::path& root, const fs::path& rel) {
+    Listing listing;
+    for (auto& entry : fs::directory_iterator(rel.empty() ? root : root / rel)) {
+        auto name = entry.path().filename();
+        if (entry.is_directory() && !entry.is_symlink()) {
+            listing.dirs.push_back(rel / name);
+        } else if (entry.is_regular_file() && name.extension() == ".html") {
+            listing.pages.push_back(rel / name);
+        }
+    }
+    return listing;
+}
+
+// Page compiled for the native VM, recompiled when the file or one of the
+// files it includes changes
+class NativePage {
+public:
+    NativePage(std::string path, TemplateProgram::Options opts)
+        : path_(std::move(path)), opts_(std::move(opts)) {
+        compile();
+    }
+
+    std::shared_ptr<const TemplateProgram> Program() {
+        std::lock_guard lock(mutex_);
+        if (!fresh()) compile();
+        return program_;
+    }
+
+private:
+    struct Stamp {
+        std::string        path;
+        fs::file_time_type mtime;
+        uintmax_t          size;
+    };
+
+    std::string                            path_;
+    TemplateProgram::Options               opts_;
+    std::mutex                             mutex_;
+    std::shared_ptr<const TemplateProgram> program_;
+    std::vector<Stamp>                     stamps_;
+
+    static Stamp stamp(const std::string& path) {
+        std::error_code ec;
+        auto mtime = fs::last_write_time(path, ec);
+        uintmax_t size = ec ? 0 : fs::file_size(path, ec);
+        return {path, ec ? fs::file_time_type{} : mtime, ec ? 0 : size};
+    }
+
+    bool fresh() const {
+        for (const auto& s : stamps_) {
+            auto now = stamp(s.path);
+            if (now.mtime != s.mtime || now.size != s.size) return false;
+        }
+        return true;
+    }
+
+    void compile() {
+        // Stamp first: a write during compilation triggers another one
+        std::vector<Stamp> stamps{stamp(path_)};
+        auto program = std::make_shared<const TemplateProgram>(
+            TemplateProgram::CompileFile(path_, opts_));
+        for (const auto& include : program->Includes()) stamps.push_back(stamp(include));
+        program_ = std::move(program);
+        stamps_  = std::move(stamps);
+    }
+};
+
+bool is_within(const fs::path& path, const fs::path& dir) {
+    auto [d, p] = std::mismatch(dir.begin(), dir.end(), path.begin(), path.end());
+    return d == dir.end();
+}
+
+} // namespace
+
+// A page compiled and analysed off the transaction, in parallel with others
+struct TemplatePageLoader::PreparedPage {
+    PageFile                                page;
+    std::shared_ptr<NativePage>             native;  // config.bytecode and the VM compiled it
+    std::vector<std::string>                files;   // dependencies
+    std::optional<std::vector<std::string>> names;   // data names read; nullopt: all
+};
+
+// Global data as a page sees it: site.json at the root and each data file
+// the page reads under its name. Files are parsed on first use
+// (DataSources); pages that read the same names share one merged object,
+// rebuilt when one of its files changes.
+struct TemplatePageLoader::GlobalData {
+    using Names = std::vector<std::string>;
+
+    struct Merged {
+        std::vector<DataContext::Layer> inputs;  // site.json, then one per name
+        DataContext::Layer              layer;
+    };
+
+    std::shared_ptr<DataSources> sources;
+    std::mutex                   mutex;
+    std::map<Names, Merged>      merged;
+
+    explicit GlobalData(std::shared_ptr<DataSources> sources) : sources(std::move(sources)) {}
+
+    // nullopt: every source
+    DataContext::Layer Get(const std::optional<Names>& reads) {
+        auto names = reads ? *reads : sources->Names();
+        std::vector<DataContext::Layer> inputs{sources->Get("site")};
+        for (const auto& name : names) {
+            // site.json only ever merges at the root
+            inputs.push_back(name == "site" ? nullptr : sources->Get(name));
+        }
+
+        std::lock_guard lock(mutex);
+        auto& entry = merged[names];
+        if (!entry.layer || entry.inputs != inputs) {
+            entry.layer  = merge(names, inputs);
+            entry.inputs = std::move(inputs);
+        }
+        return entry.layer;
+    }
+
+    void Clear() {
+        std::lock_guard lock(mutex);
+        merged.clear();
+    }
+
+    static DataContext::Layer merge(const Names& names, const std::vector<DataContext::Layer>& inputs) {
+        const auto& site = inputs.front();
+        bool site_object = site && site->is_object();
+        bool others = std::any_of(inputs.begin() + 1, inputs.end(), [](const auto& l) { return l != nullptr; });
+        if (!others && site_object) return site;
+
+        auto data = std::make_shared<nlohmann::json>(site_object ? *site : nlohmann::json::object());
+        for (size_t i = 0; i < names.size(); ++i) {
+            // projects.json → data["projects"]
+            if (inputs[i + 1]) (*data)[names[i]] = *inputs[i + 1];
+        }
+        return data;
+    }
+};
+
+// Data behind one template page: the global data it reads plus the page's
+// own JSON file, merged once per change of either
+class TemplatePageLoader::PageData {
+public:
+    PageData(std::string name, std::optional<std::vector<std::string>> reads,
+             std::shared_ptr<GlobalData> global)
+        : name_(std::move(name)), reads_(std::move(reads)), global_(std::move(global)) {}
+
+    DataContext Context() {
+        auto page = global_->sources->Get(name_);
+        if (page && !page->is_object()) page = nullptr;
+        auto global = global_->Get(reads_);
+
+        std::lock_guard lock(mutex_);
+        if (!merged_ || page != page_ || global != base_) {
+            page_   = page;
+            base_   = global;
+            merged_ = DataContext(global).With(page).Flatten();
+        }
+        return DataContext(merged_);
+    }
+
+private:
+    std::string                             name_;   // data/<name>.json
+    std::optional<std::vector<std::string>> reads_;  // nullopt: everything
+    std::shared_ptr<GlobalData>             global_;
+    std::mutex                              mutex_;
+    DataContext::Layer                      page_;
+    DataContext::Layer                      base_;
+    DataContext::Layer                      merged_;  // base_ when there is no page data
+};
+
 TemplatePageLoader::TemplatePageLoader(TemplatePageConfig config)
-    : config_(std::move(config)) {}
+    : config_(std::move(config)),
+      engine_(config_.engine ? config_.engine
+                             : std::make_shared<TemplateEngine>(config_.templates_dir)),
+      sources_(std::make_shared<DataSources>()),
+      global_(std::make_shared<GlobalData>(sources_)) {}
+
+TemplatePageLoader::~TemplatePageLoader() = default;
 
 nlohmann::json TemplatePageLoader::LoadGlobalData() const {
     nlohmann::json data = nlohmann::json::object();
@@ -65,77 +281,310 @@ std::string TemplatePageLoader::path_to_route(const fs::path& rel_path) {
     return route;
 }
 
+Executor& TemplatePageLoader::executor() const {
+    return config_.executor ? *config_.executor : Executor::Default();
+}
+
 std::vector<std::string> TemplatePageLoader::LoadPages(Registry& registry) {
-    std::vector<std::string> routes;
+    auto start = Clock::now();
+    timings_ = LoadTimings{};
+    timings_.threads = executor().Size();
+    engine_->BindComponents(registry);
 
-    if (!fs::exists(config_.pages_dir)) return routes;
+    Registry::Transaction tx(registry);
+    auto pages = stage_pages(tx);
+    auto commit = Clock::now();
+    tx.Commit();
+    timings_.register_ms += ms_since(commit);
+    timings_.total_ms = ms_since(start);
 
-    // Set template directory for {% include %} support
-    if (fs::exists(config_.templates_dir)) {
-        TemplateEngine::SetTemplateDirectory(
-            (fs::path(config_.templates_dir) / "").string());
+    std::vector<std::string> routes;
+    for (auto& [path, route] : pages) {
+        routes.push_back(route);
+        pages_[std::move(path)] = std::move(route);
     }
+    return routes;
+}
 
-    auto global_data = LoadGlobalData();
-    auto pages_path = fs::path(config_.pages_dir);
+std::vector<TemplatePageLoader::PageFile> TemplatePageLoader::ScanPages() const {
+    std::vector<PageFile> pages;
 
-    for (auto& entry : fs::recursive_directory_iterator(config_.pages_dir)) {
-        if (!entry.is_regular_file()) continue;
-        if (entry.path().extension() != ".html") continue;
-
-        auto rel = fs::relative(entry.path(), pages_path);
-        auto route = path_to_route(rel);
-        auto abs_path = fs::absolute(entry.path()).string();
-        auto data_dir = config_.data_dir;
-
-        // Register page factory that reads template at render time (for hot-reload)
-        registry.RegisterPage(route, [abs_path, data_dir, global_data](const nlohmann::json& runtime_data) -> Element {
-            // Start with global data
-            nlohmann::json merged = global_data;
-
-            // Merge per-page data if exists
-            auto page_stem = fs::path(abs_path).stem().string();
-            auto page_data_path = fs::path(data_dir) / (page_stem + ".json");
-            if (fs::exists(page_data_path)) {
-                std::ifstream f(page_data_path);
-                auto page_json = nlohmann::json::parse(f, nullptr, false);
-                if (!page_json.is_discarded() && page_json.is_object()) {
-                    merged.merge_patch(page_json);
-                }
+    if (!fs::exists(config_.pages_dir)) return pages;
+
+    // Breadth first, one task per directory of the current level. Paths are
+    // joined onto the normalized root instead of resolving every entry.
+    auto root = fs::path(DependencyGraph::Normalize(config_.pages_dir));
+    std::vector<fs::path> level{fs::path()};
+    while (!level.empty()) {
+        auto listings = parallel_map(level.size(), [&](size_t i) {
+            return list_dir(root, level[i]);
+        }, executor());
+
+        level.clear();
+        for (auto& listing : listings) {
+            for (const auto& rel : listing.pages) {
+                pages.push_back({path_to_route(rel), (root / rel).string()});
             }
+            level.insert(level.end(), std::make_move_iterator(listing.dirs.begin()),
+                         std::make_move_iterator(listing.dirs.end()));
+        }
+    }
+    std::sort(pages.begin(), pages.end(),
+              [](const PageFile& a, const PageFile& b) { return a.path < b.path; });
+    return pages;
+}
+
+TemplatePageLoader::PreparedPage TemplatePageLoader::prepare_page(const PageFile& page) const {
+    const auto& abs_path = page.path;
+    TemplateProgram::Options native_opts;
+    native_opts.template_dir = config_.templates_dir;
+
+    auto stem      = fs::path(abs_path).stem().string();
+    auto data_file = fs::path(config_.data_dir) / (stem + ".json");
+
+    std::shared_ptr<NativePage> native;
+    if (config_.bytecode) {
+        try {
+            native = std::make_shared<NativePage>(abs_path, native_opts);
+        } catch (const std::exception& e) {
+            std::cerr << "[fwui] " << e.what() << "; rendering " << abs_path << " with inja\n";
+        }
+    }
+
+    // The page file, its page data and site.json (merged at the root, so
+    // it may define any name), then what the template reads. The VM knows
+    // the includes and data names; without it, assume everything.
+    std::vector<std::string> files{abs_path, data_file.string(),
+                                   (fs::path(config_.data_dir) / "site.json").string()};
+    std::shared_ptr<const TemplateProgram> program;
+    if (native) {
+        program = native->Program();
+    } else {
+        try {
+            program = std::make_shared<const TemplateProgram>(
+                TemplateProgram::CompileFile(abs_path, native_opts));
+        } catch (const std::exception&) {}
+    }
+    auto names = program ? program->DataNames() : std::nullopt;
+    if (program) {
+        files.insert(files.end(), program->Includes().begin(), program->Includes().end());
+    } else {
+        files.push_back(config_.templates_dir);
+    }
+    if (names) {
+        for (const auto& name : *names) {
+            files.push_back((fs::path(config_.data_dir) / (name + ".json")).string());
+        }
+    } else {
+        files.push_back(config_.data_dir);
+    }
+    return {page, std::move(native), std::move(files), std::move(names)};
+}
 
-            // Merge runtime data (highest priority)
-            if (runtime_data.is_object()) {
-                merged.merge_patch(runtime_data);
+void TemplatePageLoader::stage(Registry::Transaction& tx, const std::vector<PageFile>& pages) {
+    auto start = Clock::now();
+    auto prepared = parallel_map(pages.size(), [&](size_t i) {
+        return prepare_page(pages[i]);
+    }, executor());
+    timings_.compile_ms = ms_since(start);
+
+    if (config_.preload) {
+        // Files are read in parallel; the engine parses one at a time
+        start = Clock::now();
+        parallel_map(prepared.size(), [&](size_t i) {
+            const auto& page = prepared[i];
+            if (page.native) return false;  // compiled above
+            try {
+                engine_->Preload(page.page.path);
+                return true;
+            } catch (const std::exception& e) {
+                std::cerr << "[fwui] Warning: " << e.what() << " in " << page.page.path << "\n";
+                return false;
             }
+        }, executor());
+        timings_.preload_ms = ms_since(start);
+    }
 
-            // Render template
-            std::ifstream tpl_file(abs_path);
-            std::string tpl_str((std::istreambuf_iterator<char>(tpl_file)),
-                                 std::istreambuf_iterator<char>());
-            auto html = TemplateEngine::Render(tpl_str, merged);
+    start = Clock::now();
+    for (auto& page : prepared) stage_page(tx, std::move(page));
+    timings_.register_ms = ms_since(start);
+    timings_.pages = pages.size();
+}
+
+void TemplatePageLoader::stage_page(Registry::Transaction& tx, PreparedPage prepared) {
+    const auto& route    = prepared.page.route;
+    const auto& abs_path = prepared.page.path;
+    auto native = std::move(prepared.native);
+    deps_.Set(route, prepared.files);
 
-            return raw(html);
+    // Only the data files this page reads get parsed, on its first render
+    auto stem      = fs::path(abs_path).stem().string();
+    auto page_data = std::make_shared<PageData>(stem, std::move(prepared.names), global_);
+
+    // Register page factory that renders the template at request time (for hot-reload)
+    tx.RegisterPage(route, [engine = engine_, abs_path, page_data, native](const nlohmann::json& runtime_data) -> Element {
+        // Global data, then per-page data, then runtime data (highest priority)
+        auto context = page_data->Context();
+        if (runtime_data.is_object() && !runtime_data.empty()) {
+            context = context.With(std::make_shared<const nlohmann::json>(runtime_data));
+        }
+
+        // Render template: parsed once, re-parsed when the file changes.
+        // The HTML goes straight into the renderer's output buffer
+        if (native) {
+            return raw_sink([engine, native, data = context.Flatten()](std::ostream& out) {
+                native->Program()->RenderTo(out, *data, engine->Callbacks().get());
+            });
+        }
+        return raw_sink([engine, abs_path, data = context.Flatten()](std::ostream& out) {
+            engine->RenderPathTo(out, abs_path, *data);
         });
+    });
+}
 
-        registered_routes_.push_back(route);
-        routes.push_back(route);
+std::map<std::string, std::string> TemplatePageLoader::stage_pages(Registry::Transaction& tx) {
+    std::map<std::string, std::string> staged;
+
+    auto start = Clock::now();
+    auto pages = ScanPages();
+    timings_.discover_ms = ms_since(start);
+    if (pages.empty()) return staged;
+
+    // Lists data_dir; files are parsed when a page first needs them
+    start = Clock::now();
+    sources_->Scan(config_.data_dir);
+    timings_.data_ms = ms_since(start);
+
+    stage(tx, pages);
+    for (auto& [route, abs_path] : pages) staged.emplace(std::move(abs_path), std::move(route));
+    return staged;
+}
+
+std::vector<std::string> TemplatePageLoader::ReloadPages(Registry& registry) {
+    auto start = Clock::now();
+    timings_ = LoadTimings{};
+    timings_.threads = executor().Size();
+
+    // Partials may have changed too
+    engine_->EvictAll();
+    engine_->BindComponents(registry);
+
+    // Unregister old template routes and register the re-scanned ones in a
+    // single publish: routes that survive the reload are replaced in place
+    Registry::Transaction tx(registry);
+    for (const auto& [path, route] : pages_) {
+        tx.UnregisterPage(route);
     }
+    deps_.Clear();
+    global_->Clear();
+    auto pages = stage_pages(tx);
+    auto commit = Clock::now();
+    tx.Commit();
+    timings_.register_ms += ms_since(commit);
+    timings_.total_ms = ms_since(start);
 
+    std::vector<std::string> routes;
+    for (const auto& [path, route] : pages) routes.push_back(route);
+    pages_ = std::move(pages);
     return routes;
 }
 
-std::vector<std::string> TemplatePageLoader::ReloadPages(Registry& registry) {
-    // Unregister old template routes
-    for (const auto& route : registered_routes_) {
-        if (registry.HasPage(route)) {
-            registry.UnregisterPage(route);
+std::vector<std::string> TemplatePageLoader::ReloadPages(Registry& registry,
+                                                        const std::vector<std::string>& changed) {
+    auto start = Clock::now();
+    timings_ = LoadTimings{};
+    timings_.threads = executor().Size();
+
+    auto pages_dir = fs::path(DependencyGraph::Normalize(config_.pages_dir));
+    evict(changed);
+
+    std::set<std::string> staged;   // page files to register again
+    std::set<std::string> removed;  // page files that are gone
+    std::error_code ec;
+    for (const auto& file : changed) {
+        auto path = fs::path(DependencyGraph::Normalize(file));
+        if (!is_within(path, pages_dir)) continue;
+
+        // Known pages at or below `path` (a file or a removed directory)
+        const auto& prefix = path.native();
+        for (auto it = pages_.lower_bound(prefix);
+             it != pages_.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it) {
+            if (is_within(it->first, path) && !fs::is_regular_file(it->first, ec)) {
+                removed.insert(it->first);
+            }
+        }
+
+        if (fs::is_directory(path, ec)) {
+            // A directory created or moved in: its pages are new
+            for (auto& entry : fs::recursive_directory_iterator(path, ec)) {
+                if (!entry.is_regular_file() || entry.path().extension() != ".html") continue;
+                auto page = DependencyGraph::Normalize(entry.path().string());
+                if (!pages_.contains(page)) staged.insert(std::move(page));
+            }
+        } else if (path.extension() == ".html" && fs::is_regular_file(path, ec)) {
+            staged.insert(path.string());
         }
     }
-    registered_routes_.clear();
 
-    // Re-scan and register
-    return LoadPages(registry);
+    // Pages built from a changed partial or data file
+    auto affected = deps_.Affected(changed);
+    std::set<std::string> affected_routes(affected.begin(), affected.end());
+    for (const auto& [path, route] : pages_) {
+        if (affected_routes.contains(route) && !removed.contains(path)) staged.insert(path);
+    }
+    timings_.discover_ms = ms_since(start);
+
+    std::set<std::string> routes;
+    std::vector<PageFile> added;
+    Registry::Transaction tx(registry);
+    for (const auto& path : removed) {
+        const auto& route = pages_.at(path);
+        tx.UnregisterPage(route);
+        deps_.Remove(route);
+        routes.insert(route);
+    }
+    for (const auto& path : staged) {
+        auto route = path_to_route(fs::path(path).lexically_relative(pages_dir));
+        routes.insert(route);
+        added.push_back({std::move(route), path});
+    }
+    stage(tx, added);
+    auto commit = Clock::now();
+    tx.Commit();
+    timings_.register_ms += ms_since(commit);
+    timings_.total_ms = ms_since(start);
+
+    for (const auto& path : removed) pages_.erase(path);
+    for (auto& [route, path] : added) pages_[std::move(path)] = std::move(route);
+    return {routes.begin(), routes.end()};
+}
+
+void TemplatePageLoader::evict(const std::vector<std::string>& files) {
+    auto data_dir = DependencyGraph::Normalize(config_.data_dir);
+    bool data_changed = false;
+    for (const auto& file : files) {
+        auto path = fs::path(DependencyGraph::Normalize(file));
+        if (path.extension() == ".json" && path.parent_path() == data_dir) {
+            data_changed = true;
+        } else {
+            // A partial drops the whole environment, a page only itself
+            engine_->Evict(path.string());
+        }
+    }
+    // Sources re-parse changed files on their next use; pick up new and
+    // deleted ones
+    if (data_changed) sources_->Scan(config_.data_dir);
+}
+
+std::vector<std::string> TemplatePageLoader::Invalidate(Registry& registry,
+                                                       const std::vector<std::string>& files) {
+    auto routes = deps_.Affected(files);
+    evict(files);
+
+    if (auto cache = registry.GetPageCache()) {
+        for (const auto& route : routes) cache->Invalidate(route);
+    }
+    return routes;
 }
 
 } // namespace fwui
@@ -0,0 +1,1634 @@
+#include "fwui/template_vm.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <initializer_list>
+#include <ostream>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace fs = std::filesystem;
+
+namespace fwui {
+
+using json = nlohmann::json;
+using Op   = TemplateProgram::Op;
+
+namespace {
+
+constexpr std::string_view kMagic   = "FWTC";
+constexpr uint32_t         kVersion = 1;
+
+// RenderTo(ostream) hands the buffer over once it grows past this
+constexpr size_t kFlushThreshold = 64 * 1024;
+
+enum Builtin : uint32_t {
+    kAt, kCapitalize, kDefault, kDivisibleBy, kEscape, kEven, kExists, kExistsIn,
+    kFirst, kFloat, kInt, kIsArray, kIsBoolean, kIsFloat, kIsInteger, kIsNumber,
+    kIsObject, kIsString, kJoin, kLast, kLength, kLower, kMax, kMin, kOdd, kRange,
+    kReplace, kRound, kSafe, kSort, kUpper,
+    kBuiltinCount
+};
+
+struct BuiltinInfo {
+    std::string_view name;
+    uint16_t         min_args;
+    uint16_t         max_args;
+};
+
+// Indexed by Builtin
+constexpr BuiltinInfo kBuiltins[kBuiltinCount] = {
+    {"at", 2, 2},        {"capitalize", 1, 1}, {"default", 2, 2},   {"divisibleBy", 2, 2},
+    {"escape", 1, 1},    {"even", 1, 1},       {"exists", 1, 1},    {"existsIn", 2, 2},
+    {"first", 1, 1},     {"float", 1, 1},      {"int", 1, 1},       {"isArray", 1, 1},
+    {"isBoolean", 1, 1}, {"isFloat", 1, 1},    {"isInteger", 1, 1}, {"isNumber", 1, 1},
+    {"isObject", 1, 1},  {"isString", 1, 1},   {"join", 2, 2},      {"last", 1, 1},
+    {"length", 1, 1},    {"lower", 1, 1},      {"max", 1, 1},       {"min", 1, 1},
+    {"odd", 1, 1},       {"range", 1, 1},      {"replace", 3, 3},   {"round", 2, 2},
+    {"safe", 1, 1},      {"sort", 1, 1},       {"upper", 1, 1},
+};
+
+enum LoopField : uint32_t { kIndex, kIndex1, kIsFirst, kIsLast, kLoopFieldCount };
+
+constexpr std::string_view kLoopFields[kLoopFieldCount] = {"index", "index1", "is_first",
+                                                           "is_last"};
+
+constexpr uint8_t kSoft = 1;  // PushData / PushLocal / PushSet: missing is not an error
+constexpr uint8_t kKey  = 2;  // PushLocal: the loop key, not the value
+
+bool is_push(Op op) {
+    return op == Op::PushData || op == Op::PushLocal || op == Op::PushSet;
+}
+
+std::string_view trim_left(std::string_view s) {
+    size_t i = 0;
+    while (i < s.size() && std::isspace(static_cast<unsigned char>(s[i]))) ++i;
+    return s.substr(i);
+}
+
+std::string_view trim_right(std::string_view s) {
+    size_t n = s.size();
+    while (n > 0 && std::isspace(static_cast<unsigned char>(s[n - 1]))) --n;
+    return s.substr(0, n);
+}
+
+std::string_view trim(std::string_view s) { return trim_right(trim_left(s)); }
+
+std::string join_path(const std::vector<std::string>& keys) {
+    std::string out;
+    for (const auto& key : keys) {
+        if (!out.empty()) out += '.';
+        out += key;
+    }
+    return out;
+}
+
+void append_escaped(fmt::memory_buffer& buf, std::string_view text) {
+    size_t start = 0;
+    for (size_t i = 0; i < text.size(); ++i) {
+        std::string_view entity;
+        switch (text[i]) {
+            case '&':  entity = "&amp;";  break;
+            case '<':  entity = "&lt;";   break;
+            case '>':  entity = "&gt;";   break;
+            case '"':  entity = "&quot;"; break;
+            case '\'': entity = "&#39;";  break;
+            default:   continue;
+        }
+        buf.append(text.data() + start, text.data() + i);
+        buf.append(entity.data(), entity.data() + entity.size());
+        start = i + 1;
+    }
+    buf.append(text.data() + start, text.data() + text.size());
+}
+
+std::string read_file(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) throw std::runtime_error("Cannot read template: " + path);
+    return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+}
+
+std::string resolve(const std::string& dir, const std::string& path) {
+    if (dir.empty() || fs::path(path).is_absolute()) return path;
+    return (fs::path(dir) / path).string();
+}
+
+} // namespace
+
+// ============================================================================
+// Compiler
+// ============================================================================
+
+class TemplateCompiler {
+public:
+    TemplateCompiler(TemplateProgram& program, const TemplateProgram::Options& opts)
+        : p_(program), opts_(opts) {}
+
+    void compile_source(std::string_view source, const std::string& name) {
+        // Includes compile nested sources: keep the caller's state
+        auto saved_source = source_;
+        auto saved_name   = name_;
+        auto saved_items  = std::move(items_);
+        auto saved_pos    = pos_;
+
+        source_ = source;
+        name_   = name;
+        items_  = split(source);
+        pos_    = 0;
+        parse_block({});
+
+        source_ = saved_source;
+        name_   = saved_name;
+        items_  = std::move(saved_items);
+        pos_    = saved_pos;
+    }
+
+private:
+    struct Item {
+        enum Kind { Text, Expr, Stmt } kind;
+        std::string_view body;
+        size_t           offset;  // in the source, for error lines
+    };
+
+    struct Token {
+        enum Kind { End, Ident, Number, String, Punct } kind = End;
+        std::string_view text;
+        std::string      value;  // unescaped string literal
+        size_t           offset = 0;
+    };
+
+    struct LoopScope {
+        std::string value;
+        std::string key;
+    };
+
+    class Lexer;
+
+    TemplateProgram&                 p_;
+    const TemplateProgram::Options&  opts_;
+    std::string_view                 source_;
+    std::string                      name_;
+    std::vector<Item>                items_;
+    size_t                           pos_ = 0;
+    size_t                           barrier_ = 0;  // code before this is a jump target
+    std::vector<LoopScope>           loops_;
+    std::unordered_map<std::string, uint16_t> sets_;
+    std::unordered_map<std::string, uint32_t> path_ids_;
+    std::vector<std::string>         include_stack_;
+
+    [[noreturn]] void fail(size_t offset, const std::string& message) const {
+        size_t line = 1 + static_cast<size_t>(
+            std::count(source_.begin(), source_.begin() + std::min(offset, source_.size()), '\n'));
+        throw std::runtime_error(fmt::format("Template error in {} at line {}: {}",
+                                             name_.empty() ? "<string>" : name_, line, message));
+    }
+
+    // --- Source → text, expression and statement items ---
+
+    std::vector<Item> split(std::string_view s) const {
+        std::vector<Item> items;
+        size_t pos = 0;
+        bool strip_next = false;  // previous tag ended with '-'
+
+        auto push_text = [&](std::string_view text, size_t offset) {
+            if (!text.empty()) items.push_back({Item::Text, text, offset});
+        };
+        auto find_tag = [&](size_t from) {
+            for (size_t i = s.find('{', from); i != std::string_view::npos; i = s.find('{', i + 1)) {
+                if (i + 1 < s.size() && (s[i + 1] == '{' || s[i + 1] == '%' || s[i + 1] == '#')) {
+                    return i;
+                }
+            }
+            return std::string_view::npos;
+        };
+        // Body of the tag opened at `open`: [start, body_end), tag ends at `close`
+        struct Tag {
+            size_t start, body_end, close;
+            bool   strip_left, strip_right;
+        };
+        auto read_tag = [&](size_t open) {
+            Tag tag{open + 2, 0, 0, false, false};
+            if (tag.start < s.size() && s[tag.start] == '-') {
+                tag.strip_left = true;
+                tag.start++;
+            }
+            std::string_view closing = s[open + 1] == '{' ? "}}" : s[open + 1] == '%' ? "%}" : "#}";
+            tag.close = s.find(closing, tag.start);
+            if (tag.close == std::string_view::npos) fail(open, "unterminated tag");
+            tag.body_end = tag.close;
+            if (tag.body_end > tag.start && s[tag.body_end - 1] == '-') {
+                tag.strip_right = true;
+                tag.body_end--;
+            }
+            return tag;
+        };
+
+        while (true) {
+            size_t open = find_tag(pos);
+            auto text = s.substr(pos, open == std::string_view::npos ? s.size() - pos : open - pos);
+            if (strip_next) text = trim_left(text);
+            if (open == std::string_view::npos) {
+                push_text(text, pos);
+                break;
+            }
+
+            char kind = s[open + 1];
+            auto tag  = read_tag(open);
+            if (tag.strip_left) text = trim_right(text);
+            push_text(text, pos);
+            auto body  = s.substr(tag.start, tag.body_end - tag.start);
+            pos        = tag.close + 2;
+            strip_next = tag.strip_right;
+
+            if (kind == '#') continue;
+            if (kind == '%' && trim(body) == "raw") {
+                // Everything up to {% endraw %} is text
+                size_t search = pos;
+                while (true) {
+                    size_t end_open = s.find("{%", search);
+                    if (end_open == std::string_view::npos) fail(open, "raw without endraw");
+                    auto end_tag = read_tag(end_open);
+                    if (trim(s.substr(end_tag.start, end_tag.body_end - end_tag.start)) == "endraw") {
+                        auto raw = s.substr(pos, end_open - pos);
+                        if (strip_next) raw = trim_left(raw);
+                        if (end_tag.strip_left) raw = trim_right(raw);
+                        push_text(raw, pos);
+                        pos        = end_tag.close + 2;
+                        strip_next = end_tag.strip_right;
+                        break;
+                    }
+                    search = end_tag.close + 2;
+                }
+                continue;
+            }
+            items.push_back({kind == '{' ? Item::Expr : Item::Stmt, body, open});
+        }
+        return items;
+    }
+
+    // --- Emitting ---
+
+    size_t emit(Op op, uint32_t a = 0, uint16_t y = 0, uint8_t x = 0) {
+        p_.code_.push_back({op, x, y, a});
+        return p_.code_.size() - 1;
+    }
+
+    // Current position as a jump target
+    uint32_t label() {
+        barrier_ = p_.code_.size();
+        return static_cast<uint32_t>(p_.code_.size());
+    }
+
+    void patch(size_t at) { p_.code_[at].a = label(); }
+
+    void emit_text(std::string_view text) {
+        if (text.empty()) return;
+        auto offset = static_cast<uint32_t>(p_.text_.size());
+        p_.text_.append(text);
+        // Extend the previous chunk when nothing jumps in between
+        if (!p_.code_.empty() && barrier_ < p_.code_.size() && p_.code_.back().op == Op::Text) {
+            auto& chunk = p_.chunks_[p_.code_.back().a];
+            if (chunk.offset + chunk.size == offset) {
+                chunk.size += static_cast<uint32_t>(text.size());
+                return;
+            }
+        }
+        p_.chunks_.push_back({offset, static_cast<uint32_t>(text.size())});
+        emit(Op::Text, static_cast<uint32_t>(p_.chunks_.size() - 1));
+    }
+
+    uint32_t constant(json value) {
+        p_.constants_.push_back(std::move(value));
+        return static_cast<uint32_t>(p_.constants_.size() - 1);
+    }
+
+    uint32_t path_id(const std::vector<std::string>& keys) {
+        auto joined = join_path(keys);
+        auto [it, inserted] = path_ids_.try_emplace(joined, static_cast<uint32_t>(p_.paths_.size()));
+        if (inserted) p_.paths_.push_back(keys);
+        return it->second;
+    }
+
+    // --- Blocks and statements ---
+
+    // Compiles items until a statement starting with one of `ends` (left
+    // unconsumed; its index is returned) or, with no `ends`, the end
+    size_t parse_block(std::initializer_list<std::string_view> ends);
+
+    void compile_statement(Lexer& lx, size_t offset);
+    void compile_if(Lexer& lx);
+    void compile_for(Lexer& lx);
+    void compile_include(Lexer& lx, size_t offset);
+    void compile_set(Lexer& lx);
+    void compile_output(Lexer& lx);
+
+    // Consumes the terminator found by parse_block() and checks its keyword
+    Lexer take_terminator(size_t index);
+
+    // --- Expressions ---
+
+    void compile_expr(Lexer& lx);
+    void parse_or(Lexer& lx);
+    void parse_and(Lexer& lx);
+    void parse_not(Lexer& lx);
+    void parse_compare(Lexer& lx);
+    void parse_add(Lexer& lx);
+    void parse_mul(Lexer& lx);
+    void parse_pow(Lexer& lx);
+    void parse_unary(Lexer& lx);
+    void parse_postfix(Lexer& lx);
+    void parse_primary(Lexer& lx);
+    uint16_t parse_args(Lexer& lx);
+    void emit_call(const Token& name, uint16_t argc, size_t first_begin, size_t first_end);
+    void compile_path(const Token& token);
+};
+
+class TemplateCompiler::Lexer {
+public:
+    Lexer(const TemplateCompiler& compiler, std::string_view body, size_t offset)
+        : c_(compiler), body_(body), base_(offset) {
+        advance();
+    }
+
+    const Token& peek() const { return current_; }
+
+    Token next() {
+        Token token = std::move(current_);
+        advance();
+        return token;
+    }
+
+    bool is(std::string_view punct) const {
+        return current_.kind == Token::Punct && current_.text == punct;
+    }
+    bool is_word(std::string_view word) const {
+        return current_.kind == Token::Ident && current_.text == word;
+    }
+
+    bool accept(std::string_view punct) {
+        if (!is(punct)) return false;
+        advance();
+        return true;
+    }
+    bool accept_word(std::string_view word) {
+        if (!is_word(word)) return false;
+        advance();
+        return true;
+    }
+
+    void expect(std::string_view punct) {
+        if (!accept(punct)) fail(fmt::format("expected '{}'", punct));
+    }
+    void expect_word(std::string_view word) {
+        if (!accept_word(word)) fail(fmt::format("expected '{}'", word));
+    }
+    std::string expect_name() {
+        if (current_.kind != Token::Ident || current_.text.find('.') != std::string_view::npos) {
+            fail("expected a name");
+        }
+        return std::string(next().text);
+    }
+    void expect_end() {
+        if (current_.kind != Token::End) fail(fmt::format("unexpected '{}'", current_.text));
+    }
+
+    [[noreturn]] void fail(const std::string& message) const {
+        c_.fail(current_.offset, message);
+    }
+
+private:
+    const TemplateCompiler& c_;
+    std::string_view        body_;
+    size_t                  base_;
+    size_t                  pos_ = 0;
+    Token                   current_;
+
+    void advance() {
+        while (pos_ < body_.size() && std::isspace(static_cast<unsigned char>(body_[pos_]))) ++pos_;
+        current_ = Token{};
+        current_.offset = base_ + pos_;
+        if (pos_ >= body_.size()) return;
+
+        size_t start = pos_;
+        char ch = body_[pos_];
+        auto is_name = [](char c) {
+            return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '.';
+        };
+
+        if (std::isalpha(static_cast<unsigned char>(ch)) || ch == '_') {
+            while (pos_ < body_.size() && is_name(body_[pos_])) ++pos_;
+            current_.kind = Token::Ident;
+        } else if (std::isdigit(static_cast<unsigned char>(ch))) {
+            while (pos_ < body_.size() && std::isdigit(static_cast<unsigned char>(body_[pos_]))) ++pos_;
+            if (pos_ + 1 < body_.size() && body_[pos_] == '.' &&
+                std::isdigit(static_cast<unsigned char>(body_[pos_ + 1]))) {
+                ++pos_;
+                while (pos_ < body_.size() && std::isdigit(static_cast<unsigned char>(body_[pos_]))) ++pos_;
+            }
+            if (pos_ < body_.size() && (body_[pos_] == 'e' || body_[pos_] == 'E')) {
+                size_t exp = pos_ + 1;
+                if (exp < body_.size() && (body_[exp] == '+' || body_[exp] == '-')) ++exp;
+                if (exp < body_.size() && std::isdigit(static_cast<unsigned char>(body_[exp]))) {
+                    pos_ = exp;
+                    while (pos_ < body_.size() && std::isdigit(static_cast<unsigned char>(body_[pos_]))) ++pos_;
+                }
+            }
+            current_.kind = Token::Number;
+        } else if (ch == '"' || ch == '\'') {
+            ++pos_;
+            std::string value;
+            while (pos_ < body_.size() && body_[pos_] != ch) {
+                char c = body_[pos_++];
+                if (c == '\\' && pos_ < body_.size()) {
+                    char e = body_[pos_++];
+                    switch (e) {
+                        case 'n': c = '\n'; break;
+                        case 't': c = '\t'; break;
+                        case 'r': c = '\r'; break;
+                        default:  c = e;    break;
+                    }
+                }
+                value += c;
+            }
+            if (pos_ >= body_.size()) c_.fail(base_ + start, "unterminated string");
+            ++pos_;
+            current_.kind  = Token::String;
+            current_.value = std::move(value);
+        } else {
+            static constexpr std::string_view kTwo[] = {"==", "!=", "<=", ">="};
+            current_.kind = Token::Punct;
+            pos_++;
+            for (auto two : kTwo) {
+                if (body_.substr(start, 2) == two) {
+                    pos_ = start + 2;
+                    break;
+                }
+            }
+            if (pos_ == start + 1 && std::string_view("()[]{},:|+-*/%^<>=").find(ch) == std::string_view::npos) {
+                c_.fail(base_ + start, fmt::format("unexpected character '{}'", ch));
+            }
+        }
+        current_.text = body_.substr(start, pos_ - start);
+    }
+};
+
+size_t TemplateCompiler::parse_block(std::initializer_list<std::string_view> ends) {
+    while (pos_ < items_.size()) {
+        const auto& item = items_[pos_];
+        if (item.kind == Item::Text) {
+            emit_text(item.body);
+            pos_++;
+            continue;
+        }
+        Lexer lx(*this, item.body, static_cast<size_t>(item.body.data() - source_.data()));
+        if (item.kind == Item::Expr) {
+            pos_++;
+            compile_output(lx);
+            continue;
+        }
+        for (auto end : ends) {
+            if (lx.is_word(end)) return pos_;
+        }
+        pos_++;
+        compile_statement(lx, item.offset);
+    }
+    if (ends.size() > 0) {
+        fail(source_.size(), fmt::format("missing {{% {} %}}", *(ends.end() - 1)));
+    }
+    return pos_;
+}
+
+TemplateCompiler::Lexer TemplateCompiler::take_terminator(size_t index) {
+    const auto& item = items_[index];
+    pos_ = index + 1;
+    return Lexer(*this, item.body, static_cast<size_t>(item.body.data() - source_.data()));
+}
+
+void TemplateCompiler::compile_statement(Lexer& lx, size_t offset) {
+    if (lx.is_word("if"))      return compile_if(lx);
+    if (lx.is_word("for"))     return compile_for(lx);
+    if (lx.is_word("include")) return compile_include(lx, offset);
+    if (lx.is_word("set"))     return compile_set(lx);
+    if (lx.peek().kind == Token::End) fail(offset, "empty statement");
+    fail(offset, fmt::format("unsupported statement '{}'", lx.peek().text));
+}
+
+void TemplateCompiler::compile_if(Lexer& lx) {
+    lx.expect_word("if");
+    compile_expr(lx);
+    lx.expect_end();
+
+    std::vector<size_t> to_end;
+    size_t skip = emit(Op::JumpIfFalse);
+    while (true) {
+        auto tl = take_terminator(parse_block({"else", "endif"}));
+        if (tl.accept_word("endif")) {
+            tl.expect_end();
+            patch(skip);
+            break;
+        }
+        tl.expect_word("else");
+        to_end.push_back(emit(Op::Jump));
+        patch(skip);
+        if (tl.accept_word("if")) {
+            compile_expr(tl);
+            tl.expect_end();
+            skip = emit(Op::JumpIfFalse);
+            continue;
+        }
+        tl.expect_end();
+        auto end = take_terminator(parse_block({"endif"}));
+        end.expect_word("endif");
+        end.expect_end();
+        break;
+    }
+    for (auto at : to_end) patch(at);
+}
+
+void TemplateCompiler::compile_for(Lexer& lx) {
+    lx.expect_word("for");
+    LoopScope scope;
+    scope.value = lx.expect_name();
+    if (lx.accept(",")) {
+        scope.key   = std::move(scope.value);
+        scope.value = lx.expect_name();
+    }
+    lx.expect_word("in");
+    compile_expr(lx);
+    lx.expect_end();
+
+    auto depth = static_cast<uint16_t>(loops_.size());
+    size_t begin = emit(Op::ForBegin, 0, depth, scope.key.empty() ? 0 : 1);
+    loops_.push_back(std::move(scope));
+    p_.max_depth_ = std::max<uint16_t>(p_.max_depth_, static_cast<uint16_t>(loops_.size()));
+
+    uint32_t body = label();
+    auto end = take_terminator(parse_block({"endfor"}));
+    end.expect_word("endfor");
+    end.expect_end();
+    loops_.pop_back();
+
+    emit(Op::ForNext, body, depth);
+    patch(begin);
+}
+
+void TemplateCompiler::compile_include(Lexer& lx, size_t offset) {
+    lx.expect_word("include");
+    if (lx.peek().kind != Token::String) lx.fail("include needs a quoted file name");
+    auto name = lx.next().value;
+    lx.expect_end();
+
+    auto path = resolve(opts_.template_dir, name);
+    if (std::find(include_stack_.begin(), include_stack_.end(), path) != include_stack_.end()) {
+        fail(offset, "include cycle through " + path);
+    }
+    std::string source;
+    try {
+        source = read_file(path);
+    } catch (const std::exception&) {
+        fail(offset, "include not found: " + path);
+    }
+    if (std::find(p_.includes_.begin(), p_.includes_.end(), path) == p_.includes_.end()) {
+        p_.includes_.push_back(path);
+    }
+
+    include_stack_.push_back(path);
+    compile_source(source, path);
+    include_stack_.pop_back();
+}
+
+void TemplateCompiler::compile_set(Lexer& lx) {
+    lx.expect_word("set");
+    auto name = lx.expect_name();
+    lx.expect("=");
+    compile_expr(lx);
+    lx.expect_end();
+    auto [it, inserted] = sets_.try_emplace(name, p_.set_slots_);
+    if (inserted) p_.set_slots_++;
+    emit(Op::Set, 0, it->second);
+}
+
+void TemplateCompiler::compile_output(Lexer& lx) {
+    size_t begin = p_.code_.size();
+    compile_expr(lx);
+    lx.expect_end();
+
+    bool escape = opts_.autoescape;
+    auto& last = p_.code_.back();
+    if (last.op == Op::Call && last.a == kSafe) {
+        p_.code_.pop_back();
+        escape = false;
+    }
+
+    // A literal string is just more text
+    if (p_.code_.size() == begin + 1 && p_.code_.back().op == Op::PushConst &&
+        p_.constants_[p_.code_.back().a].is_string()) {
+        auto value = p_.constants_[p_.code_.back().a].get<std::string>();
+        p_.code_.pop_back();
+        p_.constants_.pop_back();
+        if (escape) {
+            fmt::memory_buffer escaped;
+            append_escaped(escaped, value);
+            value.assign(escaped.data(), escaped.size());
+        }
+        emit_text(value);
+        return;
+    }
+    emit(Op::Print, 0, 0, escape ? 1 : 0);
+}
+
+// --- Expressions ---
+
+void TemplateCompiler::compile_expr(Lexer& lx) {
+    if (lx.peek().kind == Token::End) lx.fail("expected an expression");
+    parse_or(lx);
+}
+
+void TemplateCompiler::parse_or(Lexer& lx) {
+    parse_and(lx);
+    while (lx.accept_word("or")) {
+        size_t jump = emit(Op::OrJump);
+        parse_and(lx);
+        emit(Op::ToBool);
+        patch(jump);
+    }
+}
+
+void TemplateCompiler::parse_and(Lexer& lx) {
+    parse_not(lx);
+    while (lx.accept_word("and")) {
+        size_t jump = emit(Op::AndJump);
+        parse_not(lx);
+        emit(Op::ToBool);
+        patch(jump);
+    }
+}
+
+void TemplateCompiler::parse_not(Lexer& lx) {
+    if (lx.accept_word("not")) {
+        parse_not(lx);
+        emit(Op::Not);
+        return;
+    }
+    parse_compare(lx);
+}
+
+void TemplateCompiler::parse_compare(Lexer& lx) {
+    parse_add(lx);
+    while (true) {
+        Op op;
+        if (lx.accept("=="))           op = Op::Eq;
+        else if (lx.accept("!="))      op = Op::Ne;
+        else if (lx.accept("<="))      op = Op::Le;
+        else if (lx.accept(">="))      op = Op::Ge;
+        else if (lx.accept("<"))       op = Op::Lt;
+        else if (lx.accept(">"))       op = Op::Gt;
+        else if (lx.accept_word("in")) op = Op::In;
+        else return;
+        parse_add(lx);
+        emit(op);
+    }
+}
+
+void TemplateCompiler::parse_add(Lexer& lx) {
+    parse_mul(lx);
+    while (true) {
+        Op op;
+        if (lx.accept("+"))      op = Op::Add;
+        else if (lx.accept("-")) op = Op::Sub;
+        else return;
+        parse_mul(lx);
+        emit(op);
+    }
+}
+
+void TemplateCompiler::parse_mul(Lexer& lx) {
+    parse_pow(lx);
+    while (true) {
+        Op op;
+        if (lx.accept("*"))      op = Op::Mul;
+        else if (lx.accept("/")) op = Op::Div;
+        else if (lx.accept("%")) op = Op::Mod;
+        else return;
+        parse_pow(lx);
+        emit(op);
+    }
+}
+
+void TemplateCompiler::parse_pow(Lexer& lx) {
+    parse_unary(lx);
+    if (lx.accept("^")) {
+        parse_pow(lx);
+        emit(Op::Pow);
+    }
+}
+
+void TemplateCompiler::parse_unary(Lexer& lx) {
+    if (lx.accept("-")) {
+        parse_unary(lx);
+        // Fold negative literals
+        auto& last = p_.code_.back();
+        if (last.op == Op::PushConst && p_.constants_[last.a].is_number()) {
+            auto& value = p_.constants_[last.a];
+            if (value.is_number_float()) value = -value.get<double>();
+            else value = -value.get<int64_t>();
+            return;
+        }
+        emit(Op::Neg);
+        return;
+    }
+    parse_postfix(lx);
+}
+
+void TemplateCompiler::parse_postfix(Lexer& lx) {
+    size_t begin = p_.code_.size();
+    parse_primary(lx);
+    // x | f(args) == f(x, args)
+    while (lx.accept("|")) {
+        size_t end = p_.code_.size();
+        if (lx.peek().kind != Token::Ident) lx.fail("expected a function name after '|'");
+        auto name = lx.next();
+        uint16_t argc = 1;
+        if (lx.accept("(")) argc += parse_args(lx);
+        emit_call(name, argc, begin, end);
+    }
+}
+
+uint16_t TemplateCompiler::parse_args(Lexer& lx) {
+    uint16_t argc = 0;
+    if (lx.accept(")")) return argc;
+    do {
+        compile_expr(lx);
+        argc++;
+    } while (lx.accept(","));
+    lx.expect(")");
+    return argc;
+}
+
+void TemplateCompiler::parse_primary(Lexer& lx) {
+    const auto& token = lx.peek();
+    switch (token.kind) {
+        case Token::End:
+            lx.fail("expected an expression");
+        case Token::Number: {
+            auto text = std::string(token.text);
+            bool is_float = text.find_first_of(".eE") != std::string::npos;
+            emit(Op::PushConst, constant(is_float ? json(std::stod(text))
+                                                  : json(std::stoll(text))));
+            lx.next();
+            return;
+        }
+        case Token::String:
+            emit(Op::PushConst, constant(lx.next().value));
+            return;
+        case Token::Punct:
+            if (lx.accept("(")) {
+                compile_expr(lx);
+                lx.expect(")");
+                return;
+            }
+            if (lx.accept("[")) {
+                uint16_t n = 0;
+                if (!lx.accept("]")) {
+                    do {
+                        compile_expr(lx);
+                        n++;
+                    } while (lx.accept(","));
+                    lx.expect("]");
+                }
+                emit(Op::MakeArray, 0, n);
+                return;
+            }
+            if (lx.accept("{")) {
+                uint16_t n = 0;
+                if (!lx.accept("}")) {
+                    do {
+                        if (lx.peek().kind != Token::String) lx.fail("object keys must be strings");
+                        emit(Op::PushConst, constant(lx.next().value));
+                        lx.expect(":");
+                        compile_expr(lx);
+                        n++;
+                    } while (lx.accept(","));
+                    lx.expect("}");
+                }
+                emit(Op::MakeObject, 0, n);
+                return;
+            }
+            lx.fail(fmt::format("unexpected '{}'", token.text));
+        case Token::Ident:
+            break;
+    }
+
+    if (lx.accept_word("true"))  { emit(Op::PushConst, constant(true));    return; }
+    if (lx.accept_word("false")) { emit(Op::PushConst, constant(false));   return; }
+    if (lx.accept_word("null"))  { emit(Op::PushConst, constant(nullptr)); return; }
+
+    auto name = lx.next();
+    if (lx.accept("(")) {
+        size_t begin = p_.code_.size();
+        size_t first_end = begin;
+        uint16_t argc = 0;
+        if (!lx.accept(")")) {
+            do {
+                compile_expr(lx);
+                if (argc++ == 0) first_end = p_.code_.size();
+            } while (lx.accept(","));
+            lx.expect(")");
+        }
+        emit_call(name, argc, begin, first_end);
+        return;
+    }
+    compile_path(name);
+}
+
+void TemplateCompiler::emit_call(const Token& name, uint16_t argc, size_t first_begin,
+                                 size_t first_end) {
+    for (uint32_t id = 0; id < kBuiltinCount; ++id) {
+        const auto& info = kBuiltins[id];
+        if (info.name != name.text) continue;
+        if (argc < info.min_args || argc > info.max_args) {
+            fail(name.offset, fmt::format("{}() takes {} argument(s), got {}", info.name,
+                                          info.min_args, argc));
+        }
+        // default(x, fallback): a missing x is not an error
+        if (id == kDefault && first_end == first_begin + 1 && is_push(p_.code_[first_begin].op)) {
+            p_.code_[first_begin].x |= kSoft;
+        }
+        emit(Op::Call, id, argc);
+        return;
+    }
+    if (name.text.find('.') != std::string_view::npos) {
+        fail(name.offset, fmt::format("bad function name '{}'", name.text));
+    }
+    emit(Op::CallUser, constant(std::string(name.text)), argc);
+}
+
+void TemplateCompiler::compile_path(const Token& token) {
+    std::vector<std::string> keys;
+    size_t start = 0;
+    auto text = token.text;
+    while (true) {
+        size_t dot = text.find('.', start);
+        auto key = text.substr(start, dot == std::string_view::npos ? text.size() - start : dot - start);
+        if (key.empty()) fail(token.offset, fmt::format("bad name '{}'", text));
+        keys.emplace_back(key);
+        if (dot == std::string_view::npos) break;
+        start = dot + 1;
+    }
+
+    // loop.index, loop.parent.is_last, ...
+    if (keys[0] == "loop" && !loops_.empty()) {
+        size_t depth = loops_.size() - 1;
+        size_t i = 1;
+        for (; i < keys.size() && keys[i] == "parent"; ++i) {
+            if (depth == 0) fail(token.offset, "loop.parent outside a nested loop");
+            depth--;
+        }
+        if (i + 1 != keys.size()) fail(token.offset, fmt::format("unsupported '{}'", text));
+        auto field = std::find(std::begin(kLoopFields), std::end(kLoopFields), keys[i]);
+        if (field == std::end(kLoopFields)) {
+            fail(token.offset, fmt::format("unknown loop field '{}'", keys[i]));
+        }
+        emit(Op::PushLoop, static_cast<uint32_t>(field - std::begin(kLoopFields)),
+             static_cast<uint16_t>(depth));
+        return;
+    }
+
+    // Innermost loop variable first
+    for (size_t d = loops_.size(); d-- > 0;) {
+        if (keys[0] == loops_[d].value) {
+            emit(Op::PushLocal, path_id(keys), static_cast<uint16_t>(d));
+            return;
+        }
+        if (!loops_[d].key.empty() && keys[0] == loops_[d].key) {
+            emit(Op::PushLocal, path_id(keys), static_cast<uint16_t>(d), kKey);
+            return;
+        }
+    }
+    if (auto it = sets_.find(keys[0]); it != sets_.end()) {
+        emit(Op::PushSet, path_id(keys), it->second);
+        return;
+    }
+    emit(Op::PushData, path_id(keys));
+}
+
+TemplateProgram TemplateProgram::Compile(std::string_view source) {
+    return Compile(source, Options());
+}
+
+TemplateProgram TemplateProgram::CompileFile(const std::string& path) {
+    return CompileFile(path, Options());
+}
+
+TemplateProgram TemplateProgram::Compile(std::string_view source, const Options& opts) {
+    TemplateProgram program;
+    TemplateCompiler(program, opts).compile_source(source, "");
+    program.verify();
+    return program;
+}
+
+TemplateProgram TemplateProgram::CompileFile(const std::string& path, const Options& opts) {
+    auto resolved = resolve(opts.template_dir, path);
+    auto source = read_file(resolved);
+    TemplateProgram program;
+    TemplateCompiler(program, opts).compile_source(source, resolved);
+    program.verify();
+    return program;
+}
+
+// ============================================================================
+// VM
+// ============================================================================
+
+namespace {
+
+// Stack value: borrowed from the data, a loop or a set variable, or owned
+struct Value {
+    const json* ref     = nullptr;
+    json        own;
+    bool        missing = false;
+
+    Value() = default;
+    explicit Value(const json* r) : ref(r) {}
+    explicit Value(json j) : own(std::move(j)) {}
+
+    const json& get() const { return ref ? *ref : own; }
+    json take() { return ref ? *ref : std::move(own); }
+};
+
+struct Frame {
+    Value                iterable;
+    size_t               index  = 0;
+    size_t               size   = 0;
+    bool                 object = false;
+    json::const_iterator it;
+    json                 key;
+};
+
+[[noreturn]] void render_error(const std::string& message) {
+    throw std::runtime_error("Template error: " + message);
+}
+
+bool truthy(const json& value) {
+    if (value.is_boolean()) return value.get<bool>();
+    if (value.is_number())  return value != 0;
+    if (value.is_null())    return false;
+    return !value.empty();
+}
+
+void print(fmt::memory_buffer& buf, const json& value, bool escape) {
+    auto append = [&](std::string_view text) {
+        if (escape) append_escaped(buf, text);
+        else buf.append(text.data(), text.data() + text.size());
+    };
+    switch (value.type()) {
+        case json::value_t::string:
+            append(value.get_ref<const std::string&>());
+            break;
+        case json::value_t::number_unsigned:
+            fmt::format_to(std::back_inserter(buf), "{}", value.get<uint64_t>());
+            break;
+        case json::value_t::number_integer:
+            fmt::format_to(std::back_inserter(buf), "{}", value.get<int64_t>());
+            break;
+        case json::value_t::null:
+            break;
+        default:
+            append(value.dump());
+            break;
+    }
+}
+
+const json* walk(const json* value, const std::vector<std::string>& keys, size_t from) {
+    for (size_t i = from; i < keys.size() && value; ++i) {
+        const auto& key = keys[i];
+        if (value->is_object()) {
+            auto it = value->find(key);
+            value = it == value->end() ? nullptr : &*it;
+        } else if (value->is_array()) {
+            size_t index = 0;
+            auto [end, ec] = std::from_chars(key.data(), key.data() + key.size(), index);
+            if (ec != std::errc{} || end != key.data() + key.size() || index >= value->size()) {
+                return nullptr;
+            }
+            value = &(*value)[index];
+        } else {
+            return nullptr;
+        }
+    }
+    return value;
+}
+
+std::string to_text(const json& value) {
+    return value.is_string() ? value.get<std::string>() : value.dump();
+}
+
+Value call_builtin(uint32_t id, std::vector<Value>& args, const json& data) {
+    auto arg = [&](size_t i) -> const json& { return args[i].get(); };
+    switch (static_cast<Builtin>(id)) {
+        case kAt: {
+            const auto& container = arg(0);
+            if (container.is_array()) return Value(&container.at(arg(1).get<size_t>()));
+            return Value(&container.at(arg(1).get<std::string>()));
+        }
+        case kCapitalize: {
+            auto s = arg(0).get<std::string>();
+            for (size_t i = 0; i < s.size(); ++i) {
+                auto c = static_cast<unsigned char>(s[i]);
+                s[i] = static_cast<char>(i == 0 ? std::toupper(c) : std::tolower(c));
+            }
+            return Value(json(std::move(s)));
+        }
+        case kDefault:
+            return args[0].missing ? std::move(args[1]) : std::move(args[0]);
+        case kDivisibleBy: {
+            auto divisor = arg(1).get<int64_t>();
+            return Value(json(divisor != 0 && arg(0).get<int64_t>() % divisor == 0));
+        }
+        case kEscape: {
+            fmt::memory_buffer buf;
+            append_escaped(buf, to_text(arg(0)));
+            return Value(json(std::string(buf.data(), buf.size())));
+        }
+        case kEven: return Value(json(arg(0).get<int64_t>() % 2 == 0));
+        case kOdd:  return Value(json(arg(0).get<int64_t>() % 2 != 0));
+        case kExists: {
+            std::vector<std::string> keys;
+            auto name = arg(0).get<std::string>();
+            size_t start = 0;
+            while (true) {
+                size_t dot = name.find('.', start);
+                keys.push_back(name.substr(start, dot == std::string::npos ? std::string::npos : dot - start));
+                if (dot == std::string::npos) break;
+                start = dot + 1;
+            }
+            return Value(json(walk(&data, keys, 0) != nullptr));
+        }
+        case kExistsIn:
+            return Value(json(arg(0).is_object() && arg(0).contains(arg(1).get<std::string>())));
+        case kFirst: return Value(&arg(0).front());
+        case kLast:  return Value(&arg(0).back());
+        case kFloat:
+            if (arg(0).is_string()) return Value(json(std::stod(arg(0).get<std::string>())));
+            return Value(json(arg(0).get<double>()));
+        case kInt:
+            if (arg(0).is_string()) return Value(json(std::stoll(arg(0).get<std::string>())));
+            return Value(json(arg(0).get<int64_t>()));
+        case kIsArray:   return Value(json(arg(0).is_array()));
+        case kIsBoolean: return Value(json(arg(0).is_boolean()));
+        case kIsFloat:   return Value(json(arg(0).is_number_float()));
+        case kIsInteger: return Value(json(arg(0).is_number_integer()));
+        case kIsNumber:  return Value(json(arg(0).is_number()));
+        case kIsObject:  return Value(json(arg(0).is_object()));
+        case kIsString:  return Value(json(arg(0).is_string()));
+        case kJoin: {
+            std::string out;
+            auto separator = arg(1).get<std::string>();
+            bool first = true;
+            for (const auto& item : arg(0)) {
+                if (!first) out += separator;
+                first = false;
+                out += to_text(item);
+            }
+            return Value(json(std::move(out)));
+        }
+        case kLength:
+            if (arg(0).is_string()) return Value(json(arg(0).get_ref<const std::string&>().size()));
+            return Value(json(arg(0).size()));
+        case kLower:
+        case kUpper: {
+            auto s = arg(0).get<std::string>();
+            for (auto& c : s) {
+                auto u = static_cast<unsigned char>(c);
+                c = static_cast<char>(id == kUpper ? std::toupper(u) : std::tolower(u));
+            }
+            return Value(json(std::move(s)));
+        }
+        case kMax:
+        case kMin: {
+            const auto& list = arg(0);
+            if (list.empty()) return Value(json(nullptr));
+            auto it = id == kMax ? std::max_element(list.begin(), list.end())
+                                 : std::min_element(list.begin(), list.end());
+            return Value(&*it);
+        }
+        case kRange: {
+            json list = json::array();
+            for (int64_t i = 0; i < arg(0).get<int64_t>(); ++i) list.push_back(i);
+            return Value(std::move(list));
+        }
+        case kReplace: {
+            auto s    = arg(0).get<std::string>();
+            auto from = arg(1).get<std::string>();
+            auto to   = arg(2).get<std::string>();
+            if (!from.empty()) {
+                for (size_t i = 0; (i = s.find(from, i)) != std::string::npos; i += to.size()) {
+                    s.replace(i, from.size(), to);
+                }
+            }
+            return Value(json(std::move(s)));
+        }
+        case kRound: {
+            auto precision = arg(1).get<int64_t>();
+            double scale  = std::pow(10.0, static_cast<double>(precision));
+            double result = std::round(arg(0).get<double>() * scale) / scale;
+            if (precision == 0) return Value(json(static_cast<int64_t>(result)));
+            return Value(json(result));
+        }
+        case kSafe:
+            return std::move(args[0]);
+        case kSort: {
+            json list = arg(0);
+            std::sort(list.begin(), list.end());
+            return Value(std::move(list));
+        }
+        case kBuiltinCount:
+            break;
+    }
+    render_error("bad builtin");
+}
+
+json arithmetic(Op op, const json& l, const json& r) {
+    switch (op) {
+        case Op::Add:
+            if (l.is_string() && r.is_string()) {
+                return l.get_ref<const std::string&>() + r.get_ref<const std::string&>();
+            }
+            if (l.is_number_integer() && r.is_number_integer()) return l.get<int64_t>() + r.get<int64_t>();
+            return l.get<double>() + r.get<double>();
+        case Op::Sub:
+            if (l.is_number_integer() && r.is_number_integer()) return l.get<int64_t>() - r.get<int64_t>();
+            return l.get<double>() - r.get<double>();
+        case Op::Mul:
+            if (l.is_number_integer() && r.is_number_integer()) return l.get<int64_t>() * r.get<int64_t>();
+            return l.get<double>() * r.get<double>();
+        case Op::Div:
+            if (r.get<double>() == 0) render_error("division by zero");
+            return l.get<double>() / r.get<double>();
+        case Op::Mod: {
+            auto divisor = r.get<int64_t>();
+            if (divisor == 0) render_error("division by zero");
+            return l.get<int64_t>() % divisor;
+        }
+        case Op::Pow:
+            if (l.is_number_integer() && r.is_number_integer() && r.get<int64_t>() >= 0) {
+                return static_cast<int64_t>(std::pow(l.get<double>(), r.get<double>()));
+            }
+            return std::pow(l.get<double>(), r.get<double>());
+        case Op::Eq: return l == r;
+        case Op::Ne: return l != r;
+        case Op::Lt: return l < r;
+        case Op::Le: return l <= r;
+        case Op::Gt: return l > r;
+        case Op::Ge: return l >= r;
+        case Op::In: return std::find(r.begin(), r.end(), l) != r.end();
+        default:     break;
+    }
+    render_error("bad operator");
+}
+
+} // namespace
+
+void TemplateProgram::run(fmt::memory_buffer& buf, std::ostream* sink, const json& data,
+                          const TemplateEngine::Functions* functions) const {
+    std::vector<Value> stack;
+    stack.reserve(16);
+    std::vector<Frame> frames;
+    frames.reserve(max_depth_);
+    // Set values are never moved or freed during a render: values on the
+    // stack or in loop frames may still point at an overwritten one
+    std::deque<json>         set_store;
+    std::vector<const json*> sets(set_slots_, nullptr);
+    std::vector<Value>       args;
+
+    auto pop = [&]() {
+        if (stack.empty()) render_error("stack underflow");
+        Value value = std::move(stack.back());
+        stack.pop_back();
+        return value;
+    };
+    auto pop_args = [&](size_t n) {
+        if (stack.size() < n) render_error("stack underflow");
+        args.clear();
+        for (size_t i = stack.size() - n; i < stack.size(); ++i) args.push_back(std::move(stack[i]));
+        stack.resize(stack.size() - n);
+    };
+    auto frame = [&](uint16_t depth) -> Frame& {
+        if (depth >= frames.size()) render_error("loop variable outside its loop");
+        return frames[depth];
+    };
+    auto not_found = [&](const std::vector<std::string>& keys) {
+        render_error(fmt::format("variable '{}' not found", join_path(keys)));
+    };
+    auto push_found = [&](const json* value, const Instruction& in) {
+        if (value) stack.emplace_back(value);
+        else if (in.x & kSoft) stack.emplace_back().missing = true;
+        else not_found(paths_[in.a]);
+    };
+    auto flush = [&]() {
+        if (sink && buf.size() >= kFlushThreshold) {
+            sink->write(buf.data(), static_cast<std::streamsize>(buf.size()));
+            buf.clear();
+        }
+    };
+    // Points the loop variables at the current element
+    auto load = [](Frame& f) {
+        if (f.object && f.index > 0) ++f.it;
+        if (f.object) f.key = f.it.key();
+    };
+
+    try {
+        for (size_t pc = 0; pc < code_.size();) {
+            const auto& in = code_[pc++];
+            switch (in.op) {
+                case Op::Text: {
+                    const auto& chunk = chunks_[in.a];
+                    buf.append(text_.data() + chunk.offset, text_.data() + chunk.offset + chunk.size);
+                    flush();
+                    break;
+                }
+                case Op::Print: {
+                    auto value = pop();
+                    print(buf, value.get(), in.x != 0);
+                    flush();
+                    break;
+                }
+                case Op::PushConst:
+                    stack.emplace_back(&constants_[in.a]);
+                    break;
+                case Op::PushData:
+                    push_found(walk(&data, paths_[in.a], 0), in);
+                    break;
+                case Op::PushLocal: {
+                    auto& f = frame(in.y);
+                    const json* base = (in.x & kKey)  ? &f.key
+                                     : f.object       ? &f.it.value()
+                                                      : &f.iterable.get()[f.index];
+                    push_found(walk(base, paths_[in.a], 1), in);
+                    break;
+                }
+                case Op::PushSet: {
+                    const auto& keys = paths_[in.a];
+                    const json* value = sets[in.y] ? walk(sets[in.y], keys, 1) : walk(&data, keys, 0);
+                    push_found(value, in);
+                    break;
+                }
+                case Op::PushLoop: {
+                    auto& f = frame(in.y);
+                    switch (in.a) {
+                        case kIndex:   stack.emplace_back(json(f.index));              break;
+                        case kIndex1:  stack.emplace_back(json(f.index + 1));          break;
+                        case kIsFirst: stack.emplace_back(json(f.index == 0));         break;
+                        case kIsLast:  stack.emplace_back(json(f.index + 1 == f.size)); break;
+                    }
+                    break;
+                }
+                case Op::MakeArray: {
+                    pop_args(in.y);
+                    json list = json::array();
+                    for (auto& item : args) list.push_back(item.take());
+                    stack.emplace_back(std::move(list));
+                    break;
+                }
+                case Op::MakeObject: {
+                    pop_args(size_t(in.y) * 2);
+                    json object = json::object();
+                    for (size_t i = 0; i < args.size(); i += 2) {
+                        object[args[i].get().get<std::string>()] = args[i + 1].take();
+                    }
+                    stack.emplace_back(std::move(object));
+                    break;
+                }
+                case Op::Call: {
+                    pop_args(in.y);
+                    auto result = call_builtin(in.a, args, data);
+                    // first(), at(), ... may point into an argument about to be dropped
+                    if (result.ref && std::any_of(args.begin(), args.end(),
+                                                  [](const Value& arg) { return !arg.ref; })) {
+                        result = Value(json(*result.ref));
+                    }
+                    stack.push_back(std::move(result));
+                    break;
+                }
+                case Op::CallUser: {
+                    const auto& name = constants_[in.a].get_ref<const std::string&>();
+                    auto it = functions ? functions->find(name) : TemplateEngine::Functions::const_iterator{};
+                    if (!functions || it == functions->end()) {
+                        render_error(fmt::format("unknown function '{}'", name));
+                    }
+                    pop_args(in.y);
+                    TemplateEngine::Arguments call_args;
+                    call_args.reserve(args.size());
+                    for (const auto& arg : args) call_args.push_back(&arg.get());
+                    stack.emplace_back(it->second(call_args));
+                    break;
+                }
+                case Op::Not: {
+                    auto value = pop();
+                    stack.emplace_back(json(!truthy(value.get())));
+                    break;
+                }
+                case Op::Neg: {
+                    auto value = pop();
+                    const auto& v = value.get();
+                    stack.emplace_back(v.is_number_integer() ? json(-v.get<int64_t>())
+                                                             : json(-v.get<double>()));
+                    break;
+                }
+                case Op::Add: case Op::Sub: case Op::Mul: case Op::Div: case Op::Mod:
+                case Op::Pow: case Op::Eq:  case Op::Ne:  case Op::Lt:  case Op::Le:
+                case Op::Gt:  case Op::Ge:  case Op::In: {
+                    auto r = pop();
+                    auto l = pop();
+                    stack.emplace_back(arithmetic(in.op, l.get(), r.get()));
+                    break;
+                }
+                case Op::AndJump:
+                case Op::OrJump: {
+                    if (stack.empty()) render_error("stack underflow");
+                    bool value = truthy(stack.back().get());
+                    if (value == (in.op == Op::OrJump)) {
+                        stack.back() = Value(json(value));
+                        pc = in.a;
+                    } else {
+                        stack.pop_back();
+                    }
+                    break;
+                }
+                case Op::ToBool: {
+                    auto value = pop();
+                    stack.emplace_back(json(truthy(value.get())));
+                    break;
+                }
+                case Op::Jump:
+                    pc = in.a;
+                    break;
+                case Op::JumpIfFalse:
+                    if (!truthy(pop().get())) pc = in.a;
+                    break;
+                case Op::ForBegin: {
+                    if (in.y != frames.size()) render_error("bad loop nesting");
+                    auto iterable = pop();
+                    const auto& value = iterable.get();
+                    bool with_key = in.x != 0;
+                    if (with_key ? !value.is_object() : !value.is_array()) {
+                        render_error(with_key ? "object must be an object" : "object must be an array");
+                    }
+                    if (value.empty()) {
+                        pc = in.a;
+                        break;
+                    }
+                    auto& f    = frames.emplace_back();
+                    f.iterable = std::move(iterable);
+                    f.size     = f.iterable.get().size();
+                    f.object   = with_key;
+                    if (f.object) f.it = f.iterable.get().cbegin();
+                    load(f);
+                    break;
+                }
+                case Op::ForNext: {
+                    auto& f = frame(in.y);
+                    if (++f.index < f.size) {
+                        load(f);
+                        pc = in.a;
+                    } else {
+                        frames.pop_back();
+                    }
+                    break;
+                }
+                case Op::Set:
+                    sets[in.y] = &set_store.emplace_back(pop().take());
+                    break;
+            }
+        }
+    } catch (const json::exception& e) {
+        render_error(e.what());
+    }
+}
+
+void TemplateProgram::RenderTo(fmt::memory_buffer& buf, const json& data,
+                               const TemplateEngine::Functions* functions) const {
+    run(buf, nullptr, data, functions);
+}
+
+void TemplateProgram::RenderTo(std::ostream& out, const json& data,
+                               const TemplateEngine::Functions* functions) const {
+    fmt::memory_buffer buf;
+    run(buf, &out, data, functions);
+    out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+}
+
+std::string TemplateProgram::Render(const json& data,
+                                    const TemplateEngine::Functions* functions) const {
+    fmt::memory_buffer buf;
+    run(buf, nullptr, data, functions);
+    return std::string(buf.data(), buf.size());
+}
+
+// ============================================================================
+// Serialization
+// ============================================================================
+
+namespace {
+
+void put32(std::string& out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+}
+
+void put_string(std::string& out, std::string_view text) {
+    put32(out, static_cast<uint32_t>(text.size()));
+    out.append(text);
+}
+
+class Reader {
+public:
+    explicit Reader(std::string_view bytes) : bytes_(bytes) {}
+
+    uint8_t u8() {
+        need(1);
+        return static_cast<uint8_t>(bytes_[pos_++]);
+    }
+    uint16_t u16() {
+        uint16_t lo = u8();
+        return static_cast<uint16_t>(lo | (uint16_t(u8()) << 8));
+    }
+    uint32_t u32() {
+        uint32_t value = 0;
+        for (int i = 0; i < 4; ++i) value |= uint32_t(u8()) << (8 * i);
+        return value;
+    }
+    std::string_view bytes(size_t n) {
+        need(n);
+        auto view = bytes_.substr(pos_, n);
+        pos_ += n;
+        return view;
+    }
+    std::string string() { return std::string(bytes(u32())); }
+    // Element count, bounded by the bytes left so a corrupt count cannot
+    // trigger a huge allocation
+    uint32_t count(size_t min_bytes_each) {
+        auto n = u32();
+        if (min_bytes_each > 0 && n > (bytes_.size() - pos_) / min_bytes_each) bad();
+        return n;
+    }
+    bool done() const { return pos_ == bytes_.size(); }
+
+    [[noreturn]] static void bad() { throw std::runtime_error("Invalid template bytecode"); }
+
+private:
+    std::string_view bytes_;
+    size_t           pos_ = 0;
+
+    void need(size_t n) {
+        if (bytes_.size() - pos_ < n) bad();
+    }
+};
+
+} // namespace
+
+std::optional<std::vector<std::string>> TemplateProgram::DataNames() const {
+    std::vector<std::string> names;
+    for (size_t i = 0; i < code_.size(); ++i) {
+        const auto& in = code_[i];
+        if (in.op == Op::PushData) {
+            names.push_back(paths_[in.a].front());
+        } else if (in.op == Op::Call && in.a == kExists) {
+            // exists("a.b") names its variable; anything computed could be any name
+            if (i == 0 || code_[i - 1].op != Op::PushConst) return std::nullopt;
+            const auto& name = constants_[code_[i - 1].a];
+            if (!name.is_string()) return std::nullopt;
+            const auto& text = name.get_ref<const std::string&>();
+            names.push_back(text.substr(0, text.find('.')));
+        }
+    }
+    std::sort(names.begin(), names.end());
+    names.erase(std::unique(names.begin(), names.end()), names.end());
+    return names;
+}
+
+std::string TemplateProgram::Serialize() const {
+    std::string out(kMagic);
+    put32(out, kVersion);
+    put32(out, set_slots_);
+    put32(out, max_depth_);
+
+    put32(out, static_cast<uint32_t>(code_.size()));
+    for (const auto& in : code_) {
+        out.push_back(static_cast<char>(in.op));
+        out.push_back(static_cast<char>(in.x));
+        out.push_back(static_cast<char>(in.y & 0xFF));
+        out.push_back(static_cast<char>(in.y >> 8));
+        put32(out, in.a);
+    }
+
+    put_string(out, text_);
+    put32(out, static_cast<uint32_t>(chunks_.size()));
+    for (const auto& chunk : chunks_) {
+        put32(out, chunk.offset);
+        put32(out, chunk.size);
+    }
+
+    put32(out, static_cast<uint32_t>(paths_.size()));
+    for (const auto& keys : paths_) {
+        put32(out, static_cast<uint32_t>(keys.size()));
+        for (const auto& key : keys) put_string(out, key);
+    }
+
+    put32(out, static_cast<uint32_t>(constants_.size()));
+    for (const auto& value : constants_) put_string(out, value.dump());
+
+    put32(out, static_cast<uint32_t>(includes_.size()));
+    for (const auto& include : includes_) put_string(out, include);
+    return out;
+}
+
+TemplateProgram TemplateProgram::Deserialize(std::string_view bytes) {
+    Reader in(bytes);
+    if (in.bytes(kMagic.size()) != kMagic || in.u32() != kVersion) Reader::bad();
+
+    TemplateProgram program;
+    auto set_slots = in.u32();
+    auto max_depth = in.u32();
+    if (set_slots > UINT16_MAX || max_depth > UINT16_MAX) Reader::bad();
+    program.set_slots_ = static_cast<uint16_t>(set_slots);
+    program.max_depth_ = static_cast<uint16_t>(max_depth);
+
+    program.code_.resize(in.count(8));
+    for (auto& instruction : program.code_) {
+        auto op = in.u8();
+        if (op > static_cast<uint8_t>(Op::Set)) Reader::bad();
+        instruction.op = static_cast<Op>(op);
+        instruction.x  = in.u8();
+        instruction.y  = in.u16();
+        instruction.a  = in.u32();
+    }
+
+    program.text_ = in.string();
+    program.chunks_.resize(in.count(8));
+    for (auto& chunk : program.chunks_) {
+        chunk.offset = in.u32();
+        chunk.size   = in.u32();
+    }
+
+    program.paths_.resize(in.count(4));
+    for (auto& keys : program.paths_) {
+        keys.resize(in.count(4));
+        for (auto& key : keys) key = in.string();
+    }
+
+    auto constants = in.count(4);
+    program.constants_.reserve(constants);
+    for (uint32_t i = 0; i < constants; ++i) {
+        auto value = json::parse(in.string(), nullptr, false);
+        if (value.is_discarded()) Reader::bad();
+        program.constants_.push_back(std::move(value));
+    }
+
+    program.includes_.resize(in.count(4));
+    for (auto& include : program.includes_) include = in.string();
+
+    if (!in.done()) Reader::bad();
+    program.verify();
+    return program;
+}
+
+void TemplateProgram::verify() const {
+    auto check = [](bool ok) {
+        if (!ok) Reader::bad();
+    };
+    for (const auto& chunk : chunks_) {
+        check(chunk.offset <= text_.size() && chunk.size <= text_.size() - chunk.offset);
+    }
+    for (const auto& keys : paths_) check(!keys.empty());
+
+    for (const auto& in : code_) {
+        switch (in.op) {
+            case Op::Text:      check(in.a < chunks_.size()); break;
+            case Op::PushConst: check(in.a < constants_.size()); break;
+            case Op::PushData:  check(in.a < paths_.size()); break;
+            case Op::PushLocal: check(in.a < paths_.size() && in.y < max_depth_); break;
+            case Op::PushSet:   check(in.a < paths_.size() && in.y < set_slots_); break;
+            case Op::PushLoop:  check(in.a < kLoopFieldCount && in.y < max_depth_); break;
+            case Op::Call:
+                check(in.a < kBuiltinCount && in.y >= kBuiltins[in.a].min_args &&
+                      in.y <= kBuiltins[in.a].max_args);
+                break;
+            case Op::CallUser:  check(in.a < constants_.size() && constants_[in.a].is_string()); break;
+            case Op::AndJump: case Op::OrJump: case Op::Jump: case Op::JumpIfFalse:
+                check(in.a <= code_.size());
+                break;
+            case Op::ForBegin: case Op::ForNext:
+                check(in.a <= code_.size() && in.y < max_depth_);
+                break;
+            case Op::Set:       check(in.y < set_slots_); break;
+            default:            break;
+        }
+    }
+}
+
+} // namespace fwui
@@ -96,6 +96,37 @@ int main() {
     auto tree = build_tree();
     auto html = HtmlRenderer::RenderToString(tree);
     fmt::print("HTML output size: {} bytes\n", html.size());
+    fmt::print("Interned style blocks: {} (shared by {} styled nodes)\n",
+               StyleBlock::PoolSize(), 500 * 2);
+
+    // ── SVG sprite pass: 500 product rows × 2 icons of ~2 KB ──
+    {
+        std::string icon;
+        for (int j = 0; icon.size() < 2000; ++j)
+            icon += fmt::format("<path d=\"M{} {}l10 5 10-5-10-5z\"/>", j % 24, j % 17);
+        auto icon2 = icon + "<circle cx=\"12\" cy=\"12\" r=\"3\"/>";
+
+        Elements rows;
+        for (int i = 1; i <= 500; ++i) {
+            rows.push_back(tr({
+                td("Product " + std::to_string(i)),
+                td({svg(icon, {{"viewBox", "0 0 24 24"}})}),
+                td({svg(icon2, {{"viewBox", "0 0 24 24"}})}),
+            }));
+        }
+        auto page = document("Products", {}, {table({tbody(std::move(rows))})});
+        auto before = HtmlRenderer::RenderToString(page).size();
+
+        auto t0 = clk::now();
+        auto report = SvgSpritePass().Apply(page);
+        auto t1 = clk::now();
+        auto after = HtmlRenderer::RenderToString(page).size();
+
+        fmt::print("SVG sprite pass:       {:.3f} ms, {} svgs -> {} symbols, "
+                   "{} -> {} bytes (saved {})\n",
+                   std::chrono::duration<double, std::milli>(t1 - t0).count(),
+                   report.svgs, report.symbols, before, after, report.BytesSaved());
+    }
 
     return 0;
 }
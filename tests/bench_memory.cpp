@@ -8,6 +8,8 @@
 #include <chrono>
 #include <string>
 #include <fstream>
+#include <ostream>
+#include <streambuf>
 #include <vector>
 
 using namespace fwui;
@@ -84,6 +86,24 @@ static Element build_dashboard(int n_widgets) {
     return div({hdr, grid_div, foot}) | SetID("dashboard");
 }
 
+// Discards output, counting bytes — stands in for a socket or file
+struct CountingBuf : std::streambuf {
+    size_t bytes = 0;
+    std::streamsize xsputn(const char*, std::streamsize n) override {
+        bytes += static_cast<size_t>(n);
+        return n;
+    }
+    int overflow(int c) override { ++bytes; return c; }
+};
+
+static Element export_row(int i) {
+    return tr({
+        td(std::to_string(i)),
+        td("user" + std::to_string(i) + "@example.com"),
+        td(std::to_string(i * 37 % 1000) + ".00"),
+    });
+}
+
 static size_t count_nodes(const Element& node) {
     size_t c = 1;
     for (const auto& ch : node->Children())
@@ -208,6 +228,44 @@ int main() {
         fmt::print("\n");
     }
 
+    // ── Part 5: 200k-row export — streamed vs eager ─────────────────
+    // Streamed runs first: freed heap is not always returned to the OS
+    fmt::print("== Part 5: Table Export (200000 rows, streamed vs eager) ==\n\n");
+    {
+        constexpr int kRows = 200000;
+
+        long rss_before = read_rss_kb();
+        auto t0 = clk::now();
+        auto streamed = table({tbody({for_each_row([]() -> RowGenerator {
+            return [i = 0]() mutable -> Element {
+                return i < kRows ? export_row(i++) : nullptr;
+            };
+        })})});
+        CountingBuf sink_buf;
+        std::ostream sink(&sink_buf);
+        HtmlRenderer().RenderTo(streamed, sink);
+        auto t1 = clk::now();
+        long rss_streamed = read_rss_kb();
+
+        Elements rows;
+        rows.reserve(kRows);
+        for (int i = 0; i < kRows; ++i) rows.push_back(export_row(i));
+        auto eager = table({tbody(std::move(rows))});
+        auto html = HtmlRenderer::RenderToString(eager);
+        auto t2 = clk::now();
+        long rss_eager = read_rss_kb();
+
+        fmt::print("{:<10} {:>10} {:>12} {:>10}\n", "Mode", "Time ms", "RSS+KB", "HTML KB");
+        fmt::print("{:-<46}\n", "");
+        fmt::print("{:<10} {:>10.1f} {:>12} {:>10.1f}\n", "streamed",
+                   std::chrono::duration<double, std::milli>(t1 - t0).count(),
+                   rss_streamed - rss_before, (double)sink_buf.bytes / 1024.0);
+        fmt::print("{:<10} {:>10.1f} {:>12} {:>10.1f}\n", "eager",
+                   std::chrono::duration<double, std::milli>(t2 - t1).count(),
+                   rss_eager - rss_streamed, (double)html.size() / 1024.0);
+        fmt::print("  Output identical: {}\n\n", sink_buf.bytes == html.size() ? "yes" : "NO");
+    }
+
     long rss_final = read_rss_kb();
     fmt::print("== Summary ==\n");
     fmt::print("  Final RSS:    {} KB\n", rss_final);
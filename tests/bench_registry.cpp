@@ -0,0 +1,203 @@
+// Registry benchmark — route lookup with 10k registered routes, typed vs JSON
+// component props, and site reloads under load.
+//
+// Build: cmake --build build --target fwui-bench-registry
+// Run:   ./build/fwui-bench-registry
+
+#include <fwui/fwui.hpp>
+#include <fmt/core.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace fwui;
+using clk = std::chrono::high_resolution_clock;
+
+static constexpr int kStatic   = 9000;
+static constexpr int kPatterns = 1000;
+static constexpr int kLookups  = 1000000;
+
+struct CardProps {
+    std::string title;
+    std::string href;
+    int         count = 0;
+    bool        active = false;
+};
+NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(CardProps, title, href, count, active)
+
+static Element card_view(const CardProps& p) {
+    return a(p.title, p.href) | SetClass(p.active ? "active" : "card")
+                               | SetAttr("data-count", std::to_string(p.count));
+}
+
+// Naive alternative: try every pattern in turn
+static bool linear_match(const std::vector<std::string>& patterns, const std::string& path) {
+    for (const auto& pattern : patterns) {
+        size_t p = 0, q = 0;
+        bool ok = true;
+        while (p < pattern.size() && ok) {
+            if (pattern[p] == ':') {
+                while (p < pattern.size() && pattern[p] != '/') ++p;
+                size_t start = q;
+                while (q < path.size() && path[q] != '/') ++q;
+                ok = q > start;
+            } else {
+                ok = q < path.size() && pattern[p++] == path[q++];
+            }
+        }
+        if (ok && q == path.size()) return true;
+    }
+    return false;
+}
+
+template <typename Fn>
+static double ns_per_op(int n, Fn&& fn) {
+    auto t0 = clk::now();
+    for (int i = 0; i < n; ++i) fn(i);
+    auto t1 = clk::now();
+    return std::chrono::duration<double, std::nano>(t1 - t0).count() / n;
+}
+
+int main() {
+    fmt::print("================================================================\n");
+    fmt::print("FWUI Registry Benchmark ({} static + {} pattern routes)\n", kStatic, kPatterns);
+    fmt::print("================================================================\n\n");
+
+    Registry reg;
+    auto page = div({h1("Page")});
+    PageFactory factory = [page](const nlohmann::json&) { return page; };
+
+    std::vector<std::string> patterns;
+    auto t0 = clk::now();
+    for (int i = 0; i < kStatic; ++i)
+        reg.RegisterPage(fmt::format("/section{}/page{}", i % 100, i), factory);
+    for (int i = 0; i < kPatterns; ++i) {
+        patterns.push_back(fmt::format("/api/v{}/items/:id", i));
+        reg.RegisterPage(patterns.back(), factory);
+    }
+    auto t1 = clk::now();
+    fmt::print("Register {} routes:    {:.1f} ms\n\n", kStatic + kPatterns,
+               std::chrono::duration<double, std::milli>(t1 - t0).count());
+
+    std::vector<std::string> static_paths, param_paths;
+    for (int i = 0; i < 1024; ++i) {
+        int s = (i * 7919) % kStatic;
+        static_paths.push_back(fmt::format("/section{}/page{}", s % 100, s));
+        param_paths.push_back(fmt::format("/api/v{}/items/{}", (i * 31) % kPatterns, i));
+    }
+
+    fmt::print("{:<28} {:>10}\n", "Lookup", "ns/op");
+    fmt::print("{:-<40}\n", "");
+    fmt::print("{:<28} {:>10.1f}\n", "static route",
+               ns_per_op(kLookups, [&](int i) { reg.CreatePage(static_paths[i & 1023]); }));
+    fmt::print("{:<28} {:>10.1f}\n", "pattern route (trie)",
+               ns_per_op(kLookups, [&](int i) { reg.CreatePage(param_paths[i & 1023]); }));
+    size_t linear_hits = 0;
+    fmt::print("{:<28} {:>10.1f}\n", "pattern route (linear scan)",
+               ns_per_op(kLookups / 100, [&](int i) {
+                   linear_hits += linear_match(patterns, param_paths[i & 1023]);
+               }));
+    fmt::print("{:<28} {:>10.1f}\n", "HasPage",
+               ns_per_op(kLookups, [&](int i) { reg.HasPage(static_paths[i & 1023]); }));
+    fmt::print("  ({} linear-scan matches)\n\n", linear_hits);
+
+    // Component props: struct -> JSON -> string-keyed reads vs passed as is
+    fmt::print("{:<28} {:>10}\n", "CreateComponent", "ns/op");
+    fmt::print("{:-<40}\n", "");
+    {
+        reg.RegisterComponent("card_json", [](const nlohmann::json& d) {
+            return card_view(d.get<CardProps>());
+        });
+        reg.RegisterComponent<CardProps>("card_typed", card_view);
+        CardProps props{"Inbox", "/mail/inbox", 42, true};
+        fmt::print("{:<28} {:>10.1f}\n", "JSON props",
+                   ns_per_op(kLookups / 10, [&](int) {
+                       reg.CreateComponent("card_json", nlohmann::json(props));
+                   }));
+        fmt::print("{:<28} {:>10.1f}\n\n", "typed props",
+                   ns_per_op(kLookups / 10, [&](int) {
+                       reg.CreateComponent<CardProps>("card_typed", props);
+                   }));
+    }
+
+    // Concurrent readers while a writer keeps publishing snapshots
+    unsigned threads = std::max(2u, std::thread::hardware_concurrency());
+    fmt::print("== Concurrent lookups ({} readers, 1 writer) ==\n\n", threads);
+    {
+        std::atomic<bool> stop{false};
+        std::thread writer([&] {
+            while (!stop) {
+                reg.RegisterPage("/dynamic", factory);
+                reg.UnregisterPage("/dynamic");
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        });
+
+        std::vector<std::thread> readers;
+        auto r0 = clk::now();
+        for (unsigned t = 0; t < threads; ++t) {
+            readers.emplace_back([&, t] {
+                for (int i = 0; i < kLookups / 10; ++i)
+                    reg.CreatePage(((i + t) & 1) ? static_paths[i & 1023] : param_paths[i & 1023]);
+            });
+        }
+        for (auto& r : readers) r.join();
+        auto r1 = clk::now();
+        stop = true;
+        writer.join();
+
+        double secs = std::chrono::duration<double>(r1 - r0).count();
+        fmt::print("  Throughput: {:.2f} M lookups/s\n",
+                   (double)threads * (kLookups / 10) / secs / 1e6);
+    }
+
+    // Site reload: unregister + re-register 5k pages while readers run.
+    // One-by-one leaves routes missing between the two calls; a transaction
+    // publishes the whole reload at once.
+    fmt::print("\n== Reload 5000 pages under load ({} readers) ==\n\n", threads);
+    fmt::print("{:<16} {:>10} {:>10} {:>12}\n", "Mode", "ms", "publishes", "failed reads");
+    fmt::print("{:-<52}\n", "");
+    {
+        std::vector<std::string> site;
+        for (int i = 0; i < 5000; ++i) site.push_back(fmt::format("/site/page{}", i));
+        for (const auto& route : site) reg.RegisterPage(route, factory);
+
+        auto run = [&](const char* mode, auto&& reload) {
+            std::atomic<bool> stop{false};
+            std::atomic<size_t> failed{0};
+            std::vector<std::thread> readers;
+            for (unsigned t = 0; t < threads; ++t) {
+                readers.emplace_back([&, t] {
+                    for (size_t i = t; !stop; i += 13) {
+                        if (!reg.HasPage(site[i % site.size()])) failed++;
+                    }
+                });
+            }
+            auto v0 = reg.Version();
+            auto w0 = clk::now();
+            reload();
+            auto w1 = clk::now();
+            stop = true;
+            for (auto& r : readers) r.join();
+            fmt::print("{:<16} {:>10.1f} {:>10} {:>12}\n", mode,
+                       std::chrono::duration<double, std::milli>(w1 - w0).count(),
+                       reg.Version() - v0, failed.load());
+        };
+
+        run("one by one", [&] {
+            for (const auto& route : site) reg.UnregisterPage(route);
+            for (const auto& route : site) reg.RegisterPage(route, factory);
+        });
+        run("transaction", [&] {
+            Registry::Transaction tx(reg);
+            for (const auto& route : site) tx.UnregisterPage(route);
+            for (const auto& route : site) tx.RegisterPage(route, factory);
+            tx.Commit();
+        });
+    }
+
+    return 0;
+}
@@ -0,0 +1,121 @@
+// Streaming benchmark — time to first byte for a page with slow components.
+//
+// Build: cmake --build build --target fwui-bench-stream
+// Run:   ./build/fwui-bench-stream
+
+#include <fwui/fwui.hpp>
+#include <fmt/core.h>
+#include <chrono>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace fwui;
+using clk = std::chrono::steady_clock;
+
+// Stand-in data sources: each widget waits this long before it can render
+static const std::vector<int> kDelaysMs = {40, 80, 120, 160, 200};
+
+// Discards output, remembering when the first byte was flushed
+class TimingSink : public std::streambuf {
+public:
+    clk::time_point first_flush{};
+    size_t          bytes = 0;
+
+protected:
+    std::streamsize xsputn(const char*, std::streamsize n) override {
+        bytes += static_cast<size_t>(n);
+        return n;
+    }
+    int overflow(int c) override {
+        bytes++;
+        return c;
+    }
+    int sync() override {
+        if (first_flush == clk::time_point{} && bytes > 0) first_flush = clk::now();
+        return 0;
+    }
+};
+
+static Element widget_view(const nlohmann::json& data) {
+    auto name = data["name"].get<std::string>();
+    Elements items;
+    for (int i = 0; i < 20; ++i) items.push_back(li(fmt::format("{} item {}", name, i)));
+    return section({h2(name), ul(items)});
+}
+
+static Element shell(Elements widgets) {
+    Elements body{header({nav({a("Home", "/"), a("Reports", "/reports")})}), h1("Dashboard")};
+    for (auto& w : widgets) body.push_back(std::move(w));
+    body.push_back(footer({p("fwui")}));
+    return document("Dashboard", {}, std::move(body));
+}
+
+struct Timing {
+    double ttfb_ms;
+    double total_ms;
+};
+
+template <typename Fn>
+static Timing measure(Fn&& render) {
+    TimingSink sink;
+    std::ostream out(&sink);
+    auto t0 = clk::now();
+    render(out);
+    out.flush();
+    auto t1 = clk::now();
+    return {std::chrono::duration<double, std::milli>(sink.first_flush - t0).count(),
+            std::chrono::duration<double, std::milli>(t1 - t0).count()};
+}
+
+int main() {
+    fmt::print("================================================================\n");
+    fmt::print("FWUI Streaming Benchmark ({} widgets, {}..{} ms each)\n", kDelaysMs.size(),
+               kDelaysMs.front(), kDelaysMs.back());
+    fmt::print("================================================================\n\n");
+
+    Registry reg;
+    for (size_t i = 0; i < kDelaysMs.size(); ++i) {
+        int delay = kDelaysMs[i];
+        reg.RegisterComponent(fmt::format("widget{}", i), [delay](const nlohmann::json& data) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(delay));
+            return widget_view(data);
+        });
+    }
+    auto data_for = [](size_t i) { return nlohmann::json{{"name", fmt::format("Widget {}", i)}}; };
+
+    fmt::print("{:<28} {:>10} {:>10}\n", "Mode", "TTFB ms", "total ms");
+    fmt::print("{:-<50}\n", "");
+
+    auto report = [](const char* mode, Timing t) {
+        fmt::print("{:<28} {:>10.1f} {:>10.1f}\n", mode, t.ttfb_ms, t.total_ms);
+    };
+
+    // Build the whole tree, components one after another, then render
+    report("sequential, RenderTo", measure([&](std::ostream& out) {
+        Elements widgets;
+        for (size_t i = 0; i < kDelaysMs.size(); ++i)
+            widgets.push_back(reg.CreateComponent(fmt::format("widget{}", i), data_for(i)));
+        HtmlRenderer().RenderTo(shell(std::move(widgets)), out);
+    }));
+
+    // Components concurrently, but the page still waits for the slowest
+    report("WhenAll, RenderTo", measure([&](std::ostream& out) {
+        std::vector<Task<Element>> tasks;
+        for (size_t i = 0; i < kDelaysMs.size(); ++i)
+            tasks.push_back(reg.CreateComponentAsync(fmt::format("widget{}", i), data_for(i)));
+        HtmlRenderer().RenderTo(shell(SyncWait(WhenAll(std::move(tasks)))), out);
+    }));
+
+    // Shell first, each widget as it completes
+    report("slots, RenderStream", measure([&](std::ostream& out) {
+        Elements widgets;
+        for (size_t i = 0; i < kDelaysMs.size(); ++i)
+            widgets.push_back(reg.SlotComponent(fmt::format("widget{}", i), data_for(i),
+                                                p("Loading...")));
+        HtmlRenderer().RenderStream(shell(std::move(widgets)), out);
+    }));
+
+    return 0;
+}
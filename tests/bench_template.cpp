@@ -0,0 +1,89 @@
+// Template benchmark — TemplateEngine (inja) vs the native bytecode VM on a
+// loop-heavy page, plus compile and bytecode load times.
+//
+// Build: cmake --build build --target fwui-bench-template
+// Run:   ./build/fwui-bench-template
+
+#include <fwui/fwui.hpp>
+#include <fmt/core.h>
+#include <chrono>
+#include <string>
+
+using namespace fwui;
+using clk = std::chrono::high_resolution_clock;
+
+static constexpr int kItems   = 200;
+static constexpr int kRenders = 2000;
+
+static const char* kTemplate = R"(<html><head><title>{{ site.name }} | {{ title }}</title></head>
+<body>
+<nav>{% for link in nav %}<a href="{{ link.href }}"{% if link.href == current %} class="active"{% endif %}>{{ link.label }}</a>{% endfor %}</nav>
+<h1>{{ upper(title) }}</h1>
+<table>
+{% for item in items -%}
+<tr class="{% if loop.index % 2 == 0 %}even{% else %}odd{% endif %}">
+  <td>{{ loop.index1 }}</td><td>{{ item.name }}</td><td>{{ item.price * item.qty }}</td>
+  <td>{% for tag in item.tags %}{{ tag }}{% if not loop.is_last %}, {% endif %}{% endfor %}</td>
+</tr>
+{% endfor -%}
+</table>
+<p>{{ length(items) }} items</p>
+</body></html>)";
+
+template <typename Fn>
+static double us_per_op(int n, Fn&& fn) {
+    auto t0 = clk::now();
+    for (int i = 0; i < n; ++i) fn();
+    auto t1 = clk::now();
+    return std::chrono::duration<double, std::micro>(t1 - t0).count() / n;
+}
+
+int main() {
+    nlohmann::json data = {
+        {"site", {{"name", "fwui"}}},
+        {"title", "Inventory"},
+        {"current", "/items"},
+        {"nav", nlohmann::json::array()},
+        {"items", nlohmann::json::array()}};
+    for (const char* href : {"/", "/items", "/about"}) {
+        data["nav"].push_back({{"href", href}, {"label", std::string(href + 1)}});
+    }
+    for (int i = 0; i < kItems; ++i) {
+        data["items"].push_back({{"name", fmt::format("item-{}", i)},
+                                 {"price", 1.5 + i},
+                                 {"qty", i % 7},
+                                 {"tags", {"new", "sale", fmt::format("t{}", i % 5)}}});
+    }
+
+    fmt::print("================================================================\n");
+    fmt::print("FWUI Template Benchmark ({} rows, {} renders)\n", kItems, kRenders);
+    fmt::print("================================================================\n\n");
+
+    TemplateEngine engine;
+    auto program = TemplateProgram::Compile(kTemplate);
+    auto bytes   = program.Serialize();
+
+    std::string a = engine.RenderString(kTemplate, data);
+    std::string b = program.Render(data);
+    fmt::print("Output: {} bytes (engine) / {} bytes (vm), {}\n\n",
+               a.size(), b.size(), a == b ? "identical" : "DIFFERENT");
+
+    double compile = us_per_op(200, [&] { program = TemplateProgram::Compile(kTemplate); });
+    double load    = us_per_op(200, [&] { program = TemplateProgram::Deserialize(bytes); });
+    fmt::print("Compile:     {:8.1f} us\n", compile);
+    fmt::print("Deserialize: {:8.1f} us ({} bytes of bytecode)\n\n", load, bytes.size());
+
+    // The engine caches the parsed template, so both sides only render
+    double engine_us = us_per_op(kRenders, [&] { a = engine.RenderString(kTemplate, data); });
+
+    fmt::memory_buffer buf;
+    double vm_us = us_per_op(kRenders, [&] {
+        buf.clear();
+        program.RenderTo(buf, data);
+    });
+
+    fmt::print("TemplateEngine::RenderString: {:8.1f} us/render\n", engine_us);
+    fmt::print("TemplateProgram::RenderTo:    {:8.1f} us/render ({:.1f}x)\n",
+               vm_us, engine_us / vm_us);
+    return 0;
+}
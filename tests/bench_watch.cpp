@@ -0,0 +1,119 @@
+// FileWatcher benchmark — change latency and idle CPU, inotify vs polling.
+//
+// Build: cmake --build build --target fwui-bench-watch
+// Run:   ./build/fwui-bench-watch
+
+#include <fwui/fwui.hpp>
+#include <fmt/core.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace fwui;
+using clk = std::chrono::steady_clock;
+namespace fs = std::filesystem;
+
+// Content tree the watcher idles over: kDirs directories of kFiles pages
+static constexpr int kDirs   = 200;
+static constexpr int kFiles  = 50;
+static constexpr int kWrites = 20;
+
+static fs::path make_tree() {
+    auto root = fs::temp_directory_path() / "fwui_bench_watch";
+    fs::remove_all(root);
+    for (int d = 0; d < kDirs; ++d) {
+        auto dir = root / fmt::format("section{}", d);
+        fs::create_directories(dir);
+        for (int f = 0; f < kFiles; ++f) {
+            std::ofstream(dir / fmt::format("page{}.html", f)) << "<p>page</p>";
+        }
+    }
+    return root;
+}
+
+struct Result {
+    double median_ms;
+    double max_ms;
+    double idle_cpu;  // percent of one core
+};
+
+static Result measure(const fs::path& root, FileWatcher::Backend backend) {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::string expected;
+    clk::time_point seen;
+
+    FileWatcher::Config config;
+    config.directories = {root.string()};
+    config.backend     = backend;
+    config.debounce    = std::chrono::milliseconds(0);  // detection latency alone
+    FileWatcher watcher(config);
+    watcher.OnChange([&](const std::vector<std::string>& changed) {
+        auto now = clk::now();
+        std::lock_guard lock(mutex);
+        if (std::find(changed.begin(), changed.end(), expected) != changed.end()) {
+            seen = now;
+            cv.notify_all();
+        }
+    });
+    watcher.Start();
+
+    // Process CPU time while nothing changes, after the initial scan
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    auto cpu0  = std::clock();
+    auto wall0 = clk::now();
+    std::this_thread::sleep_for(std::chrono::seconds(2));
+    double cpu_s  = double(std::clock() - cpu0) / CLOCKS_PER_SEC;
+    double wall_s = std::chrono::duration<double>(clk::now() - wall0).count();
+
+    std::vector<double> latencies;
+    for (int i = 0; i < kWrites; ++i) {
+        auto path = root / fmt::format("section{}", i % kDirs) / "page0.html";
+        {
+            std::lock_guard lock(mutex);
+            expected = path.string();
+            seen = {};
+        }
+        auto t0 = clk::now();
+        std::ofstream(path, std::ios::trunc) << "<p>edit " << i << "</p>";
+
+        std::unique_lock lock(mutex);
+        bool ok = cv.wait_for(lock, std::chrono::seconds(5), [&] { return seen != clk::time_point{}; });
+        auto end = ok ? seen : clk::now();  // missed: count the timeout
+        latencies.push_back(std::chrono::duration<double, std::milli>(end - t0).count());
+        lock.unlock();
+        // Vary the phase against the polling period
+        std::this_thread::sleep_for(std::chrono::milliseconds(20 + (i * 97) % 500));
+    }
+    watcher.Stop();
+
+    std::sort(latencies.begin(), latencies.end());
+    return {latencies[latencies.size() / 2], latencies.back(), 100.0 * cpu_s / wall_s};
+}
+
+int main() {
+    fmt::print("================================================================\n");
+    fmt::print("FWUI FileWatcher Benchmark ({} files, {} edits)\n", kDirs * kFiles, kWrites);
+    fmt::print("================================================================\n\n");
+
+    auto root = make_tree();
+
+    fmt::print("{:<12} {:>14} {:>12} {:>12}\n", "Backend", "median ms", "max ms", "idle CPU %");
+    fmt::print("{:-<52}\n", "");
+    auto report = [&](const char* name, FileWatcher::Backend backend) {
+        auto r = measure(root, backend);
+        fmt::print("{:<12} {:>14.2f} {:>12.2f} {:>12.2f}\n", name, r.median_ms, r.max_ms, r.idle_cpu);
+    };
+    report("inotify", FileWatcher::Backend::Inotify);
+    report("polling", FileWatcher::Backend::Polling);
+
+    fs::remove_all(root);
+    return 0;
+}
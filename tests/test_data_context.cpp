@@ -0,0 +1,144 @@
+#include <catch2/catch_test_macros.hpp>
+#include <fwui/fwui.hpp>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+
+using namespace fwui;
+using json = nlohmann::json;
+
+TEST_CASE("DataContext layers") {
+    auto global = std::make_shared<const json>(json{
+        {"site", {{"name", "fwui"}, {"lang", "en"}}},
+        {"nav", {"home", "docs"}},
+        {"footer", "global"}});
+    DataContext ctx = DataContext(global).With(json{
+        {"site", {{"lang", "ru"}}},
+        {"footer", nullptr},
+        {"title", "About"}});
+
+    SECTION("higher layers win") {
+        REQUIRE(*ctx.Find("title") == "About");
+        REQUIRE(*ctx.Find("/site/lang"_json_pointer) == "ru");
+        REQUIRE(*ctx.Find("/site/name"_json_pointer) == "fwui");
+        REQUIRE(*ctx.Find("/nav/1"_json_pointer) == "docs");
+    }
+
+    SECTION("null deletes, missing keys fall through") {
+        REQUIRE(ctx.Find("footer") == nullptr);
+        REQUIRE_FALSE(ctx.Contains("missing"));
+        REQUIRE(ctx.Find("/nav/5"_json_pointer) == nullptr);
+    }
+
+    SECTION("lookups do not copy the layers") {
+        REQUIRE(ctx.Find("nav") == &(*global)["nav"]);
+    }
+
+    SECTION("a non-object shadows the layers below") {
+        auto shadowed = ctx.With(json{{"site", "plain"}});
+        REQUIRE(shadowed.Find("/site/name"_json_pointer) == nullptr);
+        REQUIRE(*shadowed.Find("site") == "plain");
+    }
+
+    SECTION("Flatten merges like merge_patch") {
+        json expected = *global;
+        expected.merge_patch({{"site", {{"lang", "ru"}}}, {"footer", nullptr}, {"title", "About"}});
+        REQUIRE(*ctx.Flatten() == expected);
+        REQUIRE(ctx.Depth() == 2);
+    }
+
+    SECTION("Flatten shares a single non-empty layer") {
+        REQUIRE(DataContext(global).Flatten() == global);
+        REQUIRE(DataContext(global).With(json::object()).With(json()).Flatten() == global);
+        REQUIRE(DataContext().Flatten()->empty());
+    }
+}
+
+TEST_CASE("JsonFile") {
+    namespace fs = std::filesystem;
+    auto path = fs::temp_directory_path() / "fwui_json_file.json";
+    std::ofstream(path, std::ios::trunc) << R"({"n": 1})";
+
+    JsonFile file(path);
+    auto first = file.Get();
+    REQUIRE(first);
+    REQUIRE((*first)["n"] == 1);
+
+    SECTION("unchanged file is parsed once") {
+        REQUIRE(file.Get() == first);
+    }
+
+    SECTION("changed file is parsed again") {
+        std::ofstream(path, std::ios::trunc) << R"({"n": 22})";
+        fs::last_write_time(path, fs::last_write_time(path) + std::chrono::seconds(1));
+        auto second = file.Get();
+        REQUIRE(second != first);
+        REQUIRE((*second)["n"] == 22);
+    }
+
+    SECTION("invalid or missing file yields nullptr") {
+        std::ofstream(path, std::ios::trunc) << "{ broken";
+        fs::last_write_time(path, fs::last_write_time(path) + std::chrono::seconds(1));
+        REQUIRE(file.Get() == nullptr);
+        fs::remove(path);
+        REQUIRE(file.Get() == nullptr);
+    }
+
+    fs::remove(path);
+}
+
+TEST_CASE("DataSources") {
+    namespace fs = std::filesystem;
+    auto dir = fs::temp_directory_path() / "fwui_data_sources";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    std::ofstream(dir / "site.json") << R"({"name": "fwui"})";
+    std::ofstream(dir / "catalog.json") << R"([{"id": 1, "tags": ["a", "b"]}, {"id": 2, "tags": []}])";
+    std::ofstream(dir / "notes.txt") << "ignored";
+
+    DataSources sources;
+    sources.Scan(dir);
+
+    SECTION("Scan registers names without parsing") {
+        REQUIRE(sources.Names() == std::vector<std::string>{"catalog", "site"});
+        REQUIRE(sources.Loaded() == 0);
+        REQUIRE((*sources.Get("site"))["name"] == "fwui");
+        REQUIRE(sources.Loaded() == 1);
+        REQUIRE(sources.Get("site") == sources.Get("site"));
+        REQUIRE(sources.Get("missing") == nullptr);
+    }
+
+    SECTION("Scan follows added and deleted files") {
+        sources.Get("catalog");
+        fs::remove(dir / "site.json");
+        std::ofstream(dir / "team.json") << "[]";
+        sources.Scan(dir);
+        REQUIRE(sources.Names() == std::vector<std::string>{"catalog", "team"});
+        REQUIRE(sources.Loaded() == 1);  // catalog stays parsed
+    }
+
+    SECTION("Add and Remove") {
+        sources.Add("extra", dir / "catalog.json");
+        REQUIRE(sources.Has("extra"));
+        REQUIRE(sources.Get("extra")->size() == 2);
+        sources.Remove("extra");
+        REQUIRE_FALSE(sources.Has("extra"));
+    }
+
+    SECTION("large files parse compactly to the same value") {
+        DataSources::Options opts;
+        opts.compact_bytes = 1;
+        DataSources compact(opts);
+        compact.Scan(dir);
+        auto value = compact.Get("catalog");
+        REQUIRE(*value == *sources.Get("catalog"));
+        REQUIRE(value->get_ref<const nlohmann::json::array_t&>().capacity() == 2);
+
+        std::ofstream(dir / "broken.json") << R"({"a": [1, 2)";
+        compact.Scan(dir);
+        REQUIRE(compact.Get("broken") == nullptr);
+    }
+
+    fs::remove_all(dir);
+}
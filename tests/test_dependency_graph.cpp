@@ -0,0 +1,44 @@
+#include <catch2/catch_test_macros.hpp>
+#include <fwui/fwui.hpp>
+
+#include <filesystem>
+
+using namespace fwui;
+namespace fs = std::filesystem;
+
+using Routes = std::vector<std::string>;
+
+TEST_CASE("DependencyGraph") {
+    auto root = fs::temp_directory_path() / "fwui_deps";
+    auto file = [&](const char* name) { return (root / name).string(); };
+
+    DependencyGraph graph;
+    graph.Set("/", {file("pages/index.html"), file("templates/nav.html"), file("data/site.json")});
+    graph.Set("/about", {file("pages/about.html"), file("templates/nav.html")});
+    graph.Set("/raw", {file("pages/raw.html"), file("data/")});
+
+    SECTION("a change affects exactly its dependents") {
+        REQUIRE(graph.Affected({file("templates/nav.html")}) == Routes{"/", "/about"});
+        REQUIRE(graph.Affected({file("pages/about.html")}) == Routes{"/about"});
+        REQUIRE(graph.Affected({file("templates/other.html")}).empty());
+    }
+
+    SECTION("directory dependencies cover the files below") {
+        REQUIRE(graph.Affected({file("data/site.json")}) == Routes{"/", "/raw"});
+        REQUIRE(graph.Affected({file("data/new/deep.json")}) == Routes{"/raw"});
+    }
+
+    SECTION("paths are normalized") {
+        REQUIRE(graph.Affected({file("templates/../pages/./about.html")}) == Routes{"/about"});
+        REQUIRE(graph.Dependents(file("data")) == Routes{"/raw"});
+    }
+
+    SECTION("Set replaces and Remove drops a page") {
+        graph.Set("/about", {file("pages/about.html")});
+        REQUIRE(graph.Affected({file("templates/nav.html")}) == Routes{"/"});
+        graph.Remove("/");
+        REQUIRE(graph.Dependents(file("templates/nav.html")).empty());
+        REQUIRE(graph.Pages() == Routes{"/about", "/raw"});
+        REQUIRE(graph.Dependencies("/about") == Routes{DependencyGraph::Normalize(file("pages/about.html"))});
+    }
+}
@@ -1,6 +1,9 @@
 #include <catch2/catch_test_macros.hpp>
 #include <fwui/fwui.hpp>
 
+#include <filesystem>
+#include <fstream>
+
 using namespace fwui;
 
 TEST_CASE("Text elements") {
@@ -221,3 +224,143 @@ TEST_CASE("Data elements") {
         REQUIRE(el->Tag() == "output");
     }
 }
+
+TEST_CASE("File-backed elements") {
+    auto path = std::filesystem::temp_directory_path() / "fwui_test_style.css";
+    {
+        std::ofstream f(path);
+        f << "nav > a { color: red; }";
+    }
+    FileCache::Global().Invalidate(path);
+
+    SECTION("content is inlined verbatim") {
+        auto html = HtmlRenderer::RenderToString(style_file(path));
+        REQUIRE(html == "<style>nav > a { color: red; }</style>");
+    }
+
+    SECTION("nodes share one cached buffer") {
+        auto before = FileCache::Global().GetStats();
+        auto a = style_file(path);
+        auto b = script_file(path);
+        REQUIRE(a->TextView().data() == b->TextView().data());
+        auto after = FileCache::Global().GetStats();
+        REQUIRE(after.misses == before.misses + 1);
+        REQUIRE(after.hits == before.hits + 1);
+    }
+
+    SECTION("changed file is reloaded") {
+        REQUIRE(style_file(path)->TextContent() == "nav > a { color: red; }");
+        {
+            std::ofstream f(path);
+            f << "body { margin: 0; }";
+        }
+        REQUIRE(style_file(path)->TextContent() == "body { margin: 0; }");
+    }
+
+    SECTION("large files are memory-mapped") {
+        FileCache::Options opts;
+        opts.mmap_threshold = 1;
+        FileCache cache(opts);
+        auto content = cache.Get(path);
+        REQUIRE(content != nullptr);
+        REQUIRE(content->View() == "nav > a { color: red; }");
+#if defined(__unix__) || defined(__APPLE__)
+        REQUIRE(content->Mapped());
+#endif
+    }
+
+    SECTION("missing file yields empty element") {
+        auto el = html_file(path.string() + ".missing");
+        REQUIRE(el->TextView().empty());
+    }
+
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Lazy elements") {
+    int calls = 0;
+    auto thunk = [&calls] {
+        ++calls;
+        return div({h2("Chart")});
+    };
+
+    SECTION("renders its result without a wrapper") {
+        auto el = section({lazy(thunk)});
+        REQUIRE(calls == 0);
+        REQUIRE(HtmlRenderer::RenderToString(el) ==
+                "<section><div><h2>Chart</h2></div></section>");
+        REQUIRE(calls == 1);
+    }
+
+    SECTION("cached ancestor never runs the thunk") {
+        auto el = section({lazy(thunk)});
+        HtmlRenderer::RenderToString(el);
+        HtmlRenderer::RenderToString(el);
+        REQUIRE(calls == 1);
+    }
+
+    SECTION("memoized by key across trees") {
+        clear_lazy();
+        auto a = HtmlRenderer::RenderToString(div({lazy("chart:v1", thunk)}));
+        auto b = HtmlRenderer::RenderToString(div({lazy("chart:v1", thunk)}));
+        REQUIRE(a == b);
+        REQUIRE(calls == 1);
+
+        invalidate_lazy("chart:v1");
+        HtmlRenderer::RenderToString(div({lazy("chart:v1", thunk)}));
+        REQUIRE(calls == 2);
+    }
+
+    SECTION("JSON resolves the subtree") {
+        auto j = lazy(thunk)->ToJSON();
+        REQUIRE(j["children"][0]["tag"] == "div");
+    }
+}
+
+TEST_CASE("Streamed rows") {
+    std::vector<int> ids = {1, 2, 3};
+    auto row = [](int id) { return tr({td(std::to_string(id))}); };
+
+    auto eager_table = [&] {
+        Elements rows;
+        for (int id : ids) rows.push_back(row(id));
+        return table({tbody(rows)});
+    };
+    auto eager = HtmlRenderer::RenderToString(eager_table());
+
+    SECTION("matches the eager version") {
+        auto streamed = table({tbody({for_each_row(ids, row)})});
+        REQUIRE(HtmlRenderer::RenderToString(streamed) == eager);
+    }
+
+    SECTION("matches in pretty mode") {
+        HtmlRenderer::Options opts;
+        opts.pretty = true;
+        HtmlRenderer renderer(opts);
+        auto expected = renderer.Render(eager_table());
+        REQUIRE(renderer.Render(table({tbody({for_each_row(ids, row)})})) == expected);
+    }
+
+    SECTION("generator is reopened on every render") {
+        int opened = 0;
+        auto el = ul({for_each_row([&opened]() -> RowGenerator {
+            ++opened;
+            return [n = 0]() mutable -> Element {
+                return n < 2 ? li(std::to_string(n++)) : nullptr;
+            };
+        })});
+        auto first = HtmlRenderer::RenderToString(el);
+        auto second = HtmlRenderer::RenderToString(el);
+        REQUIRE(first == "<ul><li>0</li><li>1</li></ul>");
+        REQUIRE(second == first);
+        REQUIRE(opened == 2);
+        REQUIRE(el->HtmlCache().empty());
+    }
+
+    SECTION("null rows are skipped") {
+        auto el = ul({for_each_row(ids, [](int id) -> Element {
+            return id == 2 ? nullptr : li(std::to_string(id));
+        })});
+        REQUIRE(HtmlRenderer::RenderToString(el) == "<ul><li>1</li><li>3</li></ul>");
+    }
+}
@@ -0,0 +1,240 @@
+#include <catch2/catch_test_macros.hpp>
+#include <fwui/fwui.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+using namespace fwui;
+namespace fs = std::filesystem;
+using namespace std::chrono_literals;
+
+namespace {
+
+// Collects reported paths from the watcher thread
+struct Changes {
+    std::mutex               mutex;
+    std::condition_variable  cv;
+    std::vector<std::string> paths;
+
+    void Add(const std::vector<std::string>& changed) {
+        std::lock_guard lock(mutex);
+        paths.insert(paths.end(), changed.begin(), changed.end());
+        cv.notify_all();
+    }
+
+    // Waits until `path` was reported
+    bool Wait(const fs::path& path) {
+        std::unique_lock lock(mutex);
+        return cv.wait_for(lock, 5s, [&] {
+            return std::find(paths.begin(), paths.end(), path.string()) != paths.end();
+        });
+    }
+
+    void Clear() {
+        std::lock_guard lock(mutex);
+        paths.clear();
+    }
+};
+
+// Rewrites `path` with a later mtime than the watcher has seen, so polling
+// notices it even within the filesystem's timestamp granularity
+void rewrite(const fs::path& path, const std::string& content) {
+    auto before = fs::last_write_time(path);
+    std::ofstream(path, std::ios::trunc) << content;
+    fs::last_write_time(path, before + 1s);
+}
+
+// Thread the executor runs coroutines on
+Task<std::thread::id> pool_thread(Executor& executor) {
+    co_await executor.Schedule();
+    co_return std::this_thread::get_id();
+}
+
+void watch_pages(FileWatcher::Backend backend) {
+    auto root = fs::temp_directory_path() / "fwui_file_watcher";
+    fs::remove_all(root);
+    fs::create_directories(root / "pages");
+    std::ofstream(root / "pages/index.html") << "v1";
+
+    FileWatcher::Config config;
+    config.directories = {(root / "pages").string()};
+    config.interval    = 20ms;
+    config.backend     = backend;
+    Changes changes;
+    FileWatcher watcher(config);
+    watcher.OnChange([&](const std::vector<std::string>& changed) { changes.Add(changed); });
+    watcher.Start();
+#ifdef __linux__
+    REQUIRE(watcher.ActiveBackend() == backend);
+#endif
+
+    SECTION("modified, created and deleted files") {
+        rewrite(root / "pages/index.html", "v2");
+        REQUIRE(changes.Wait(root / "pages/index.html"));
+
+        std::ofstream(root / "pages/about.html") << "new";
+        REQUIRE(changes.Wait(root / "pages/about.html"));
+
+        changes.Clear();
+        fs::remove(root / "pages/index.html");
+        REQUIRE(changes.Wait(root / "pages/index.html"));
+    }
+
+    SECTION("directories created and removed at runtime") {
+        fs::create_directories(root / "pages/blog/2024");
+        std::ofstream(root / "pages/blog/2024/post.html") << "post";
+        REQUIRE(changes.Wait(root / "pages/blog/2024/post.html"));
+
+        changes.Clear();
+        rewrite(root / "pages/blog/2024/post.html", "edited");
+        REQUIRE(changes.Wait(root / "pages/blog/2024/post.html"));
+
+        changes.Clear();
+        fs::remove_all(root / "pages/blog");
+        REQUIRE(changes.Wait(root / "pages/blog/2024/post.html"));
+    }
+
+    SECTION("other extensions are ignored") {
+        std::ofstream(root / "pages/notes.txt") << "ignored";
+        std::ofstream(root / "pages/marker.html") << "seen";
+        REQUIRE(changes.Wait(root / "pages/marker.html"));
+        std::lock_guard lock(changes.mutex);
+        REQUIRE(std::find(changes.paths.begin(), changes.paths.end(),
+                          (root / "pages/notes.txt").string()) == changes.paths.end());
+    }
+
+    watcher.Stop();
+    fs::remove_all(root);
+}
+
+} // namespace
+
+TEST_CASE("FileWatcher inotify backend") {
+    watch_pages(FileWatcher::Backend::Inotify);
+}
+
+TEST_CASE("FileWatcher polling backend") {
+    watch_pages(FileWatcher::Backend::Polling);
+}
+
+TEST_CASE("FileWatcher coalesces bursts") {
+    using Change = FileWatcher::Change;
+    auto root = fs::temp_directory_path() / "fwui_file_watcher_burst";
+    fs::remove_all(root);
+    fs::create_directories(root);
+    std::ofstream(root / "kept.html") << "v1";
+    std::ofstream(root / "replaced.html") << "v1";
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<std::vector<FileWatcher::Event>> batches;
+    std::vector<std::string> paths;
+    std::thread::id callback_thread;
+
+    Executor executor(1);
+    FileWatcher::Config config;
+    config.directories = {root.string()};
+    config.interval    = 20ms;
+    config.debounce    = 300ms;
+    config.executor    = &executor;
+    FileWatcher watcher(config);
+    watcher.OnEvents([&](const std::vector<FileWatcher::Event>& events) {
+        std::lock_guard lock(mutex);
+        batches.push_back(events);
+        callback_thread = std::this_thread::get_id();
+        cv.notify_all();
+    });
+    watcher.OnChange([&](const std::vector<std::string>& changed) {
+        std::lock_guard lock(mutex);
+        paths = changed;
+    });
+    watcher.Start();
+
+    // One burst: a new file written twice, a temp file that comes and goes,
+    // a file deleted and written again, a plain edit
+    std::ofstream(root / "added.html") << "a";
+    rewrite(root / "added.html", "ab");
+    std::ofstream(root / "temp.html") << "t";
+    fs::remove(root / "temp.html");
+    fs::remove(root / "replaced.html");
+    std::ofstream(root / "replaced.html") << "v2";
+    rewrite(root / "kept.html", "v2");
+
+    std::unique_lock lock(mutex);
+    REQUIRE(cv.wait_for(lock, 5s, [&] { return !batches.empty(); }));
+    lock.unlock();
+    std::this_thread::sleep_for(400ms);  // nothing else arrives
+    lock.lock();
+
+    REQUIRE(batches.size() == 1);
+    const auto& events = batches.front();
+    REQUIRE(events.size() == 3);
+    REQUIRE(events[0].path == (root / "added.html").string());
+    REQUIRE(events[0].change == Change::Created);
+    REQUIRE(events[1].path == (root / "kept.html").string());
+    REQUIRE(events[1].change == Change::Modified);
+    REQUIRE(events[2].path == (root / "replaced.html").string());
+    REQUIRE(events[2].change == Change::Modified);
+    REQUIRE(paths.size() == 3);
+    REQUIRE(callback_thread == SyncWait(pool_thread(executor)));
+    lock.unlock();
+
+    watcher.Stop();
+    fs::remove_all(root);
+}
+
+TEST_CASE("FileWatcher Stop") {
+    auto root = fs::temp_directory_path() / "fwui_file_watcher_stop";
+    fs::remove_all(root);
+    fs::create_directories(root);
+    std::ofstream(root / "index.html") << "v1";
+
+    FileWatcher::Config config;
+    config.directories = {root.string()};
+    config.interval    = 20ms;
+    config.backend     = FileWatcher::Backend::Polling;
+
+    SECTION("reports changes still waiting out the debounce") {
+        config.debounce = 10s;
+        Changes changes;
+        FileWatcher watcher(config);
+        watcher.OnChange([&](const std::vector<std::string>& changed) { changes.Add(changed); });
+        watcher.Start();
+        rewrite(root / "index.html", "v2");
+        std::this_thread::sleep_for(200ms);  // detected, not yet due
+        {
+            std::lock_guard lock(changes.mutex);
+            REQUIRE(changes.paths.empty());
+        }
+        watcher.Stop();
+        REQUIRE(changes.paths == std::vector<std::string>{(root / "index.html").string()});
+    }
+
+    SECTION("may be called from a callback") {
+        Executor executor(1);
+        config.debounce = 0ms;
+        Changes changes;
+        auto stop_inside = [&](bool with_executor) {
+            config.executor = with_executor ? &executor : nullptr;
+            FileWatcher inner(config);
+            inner.OnChange([&](const std::vector<std::string>& changed) {
+                inner.Stop();
+                changes.Add(changed);
+            });
+            inner.Start();
+            rewrite(root / "index.html", with_executor ? "v3" : "v2");
+            REQUIRE(changes.Wait(root / "index.html"));
+            REQUIRE_FALSE(inner.Running());
+            changes.Clear();
+        };
+        stop_inside(false);
+        stop_inside(true);
+    }
+
+    fs::remove_all(root);
+}
@@ -19,6 +19,20 @@ TEST_CASE("Node with text content") {
     REQUIRE(node->TextContent() == "Hello");
 }
 
+TEST_CASE("Node with shared text") {
+    auto first  = std::make_shared<const std::string>("alpha");
+    auto second = std::make_shared<const std::string>("omega");
+    auto node = std::make_shared<Node>("p");
+    node->SetSharedText(first, *first);
+    REQUIRE(node->TextContent() == "alpha");
+    // Same length, different bytes
+    node->SetSharedText(second, *second);
+    REQUIRE(node->TextContent() == "omega");
+    REQUIRE(node->TextView().data() == second->data());
+    node->SetTextContent("plain");
+    REQUIRE(node->TextView() == "plain");
+}
+
 TEST_CASE("Node SetTag") {
     auto node = std::make_shared<Node>("div");
     node->SetTag("span");
@@ -137,6 +151,44 @@ TEST_CASE("Node styles") {
     }
 }
 
+TEST_CASE("Node styles are interned") {
+    auto a = std::make_shared<Node>("div");
+    auto b = std::make_shared<Node>("div");
+    a->SetStyle("font-weight", "bold")->SetStyle("color", "#333");
+    b->SetStyle("color", "#333")->SetStyle("font-weight", "bold");
+
+    SECTION("identical styles share one block") {
+        REQUIRE(a->SharedStyles() != nullptr);
+        REQUIRE(a->SharedStyles() == b->SharedStyles());
+        REQUIRE(&a->StyleString() == &b->StyleString());
+    }
+
+    SECTION("mutation copies instead of touching the shared block") {
+        b->SetStyle("color", "red");
+        REQUIRE(a->GetStyle("color") == "#333");
+        REQUIRE(b->GetStyle("color") == "red");
+        REQUIRE(a->SharedStyles() != b->SharedStyles());
+    }
+
+    SECTION("removing the last style drops the block") {
+        a->RemoveStyle("color");
+        a->RemoveStyle("font-weight");
+        REQUIRE(a->SharedStyles() == nullptr);
+        REQUIRE(a->StyleString().empty());
+    }
+
+    SECTION("pre-rendered attribute is escaped") {
+        auto c = std::make_shared<Node>("div");
+        c->SetStyle("font-family", "\"Inter\"");
+        REQUIRE(c->SharedStyles()->Attribute() ==
+                " style=\"font-family: &quot;Inter&quot;;\"");
+    }
+
+    SECTION("clone shares the block") {
+        REQUIRE(a->Clone()->SharedStyles() == a->SharedStyles());
+    }
+}
+
 TEST_CASE("Node children") {
     auto parent = std::make_shared<Node>("div");
     auto child1 = std::make_shared<Node>("p", "First");
@@ -1,12 +1,29 @@
 #include <catch2/catch_test_macros.hpp>
 #include <fwui/fwui.hpp>
 
+#include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <thread>
 #include <vector>
 
 using namespace fwui;
 
+namespace {
+
+struct CardProps {
+    std::string title;
+    int         count = 0;
+};
+NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(CardProps, title, count)
+
+// No JSON conversion
+struct RowProps {
+    const std::vector<std::string>* cells = nullptr;
+};
+
+} // namespace
+
 TEST_CASE("Registry page operations") {
     Registry reg;
 
@@ -79,6 +96,20 @@ TEST_CASE("Registry component operations") {
     }
 }
 
+TEST_CASE("Registry lazy component") {
+    Registry reg;
+    int calls = 0;
+    reg.RegisterComponent("chart", [&calls](const nlohmann::json& data) {
+        ++calls;
+        return div({h2(data.value("title", ""))});
+    });
+
+    auto el = reg.LazyComponent("chart", {{"title", "Sales"}});
+    REQUIRE(calls == 0);
+    REQUIRE(HtmlRenderer::RenderToString(el) == "<div><h2>Sales</h2></div>");
+    REQUIRE(calls == 1);
+}
+
 TEST_CASE("Registry page receives data") {
     Registry reg;
     reg.RegisterPage("/greet", [](const nlohmann::json& data) {
@@ -118,3 +149,555 @@ TEST_CASE("Registry concurrent access") {
     for (auto& t : threads) t.join();
     REQUIRE(reads >= 8000);
 }
+
+TEST_CASE("Registry snapshots") {
+    Registry reg;
+
+    SECTION("introspection is sorted") {
+        for (auto r : {"/c", "/a", "/b"}) reg.RegisterPage(r, [](auto) { return div({}); });
+        for (auto n : {"nav", "card", "footer"}) reg.RegisterComponent(n, [](auto) { return div({}); });
+        REQUIRE(reg.PageRoutes() == std::vector<std::string>{"/a", "/b", "/c"});
+        REQUIRE(reg.ComponentNames() == std::vector<std::string>{"card", "footer", "nav"});
+    }
+
+    SECTION("factory may modify the registry while it runs") {
+        reg.RegisterPage("/once", [&reg](auto) {
+            reg.UnregisterPage("/once");
+            reg.RegisterComponent("late", [](auto) { return span("late"); });
+            return h1("Once");
+        });
+        REQUIRE(reg.CreatePage("/once")->TextContent() == "Once");
+        REQUIRE_FALSE(reg.HasPage("/once"));
+        REQUIRE(reg.HasComponent("late"));
+    }
+}
+
+TEST_CASE("Registry route patterns") {
+    Registry reg;
+    auto echo = [](const char* name) {
+        return [name](const nlohmann::json& data) {
+            return div({h1(name), pre(data.dump())});
+        };
+    };
+    auto data_of = [](const Element& page) {
+        return nlohmann::json::parse(page->Children()[1]->TextContent());
+    };
+    auto name_of = [](const Element& page) { return page->Children()[0]->TextContent(); };
+
+    reg.RegisterPage("/projects/:id", echo("project"));
+    reg.RegisterPage("/projects/:id/tasks/:task", echo("task"));
+    reg.RegisterPage("/projects/new", echo("new"));
+    reg.RegisterPage("/docs/*path", echo("docs"));
+
+    SECTION("parameters are merged into data") {
+        auto page = reg.CreatePage("/projects/123", {{"user", "alice"}});
+        REQUIRE(name_of(page) == "project");
+        REQUIRE(data_of(page) == nlohmann::json{{"id", "123"}, {"user", "alice"}});
+
+        auto task = reg.CreatePage("/projects/7/tasks/42");
+        REQUIRE(data_of(task) == nlohmann::json{{"id", "7"}, {"task", "42"}});
+    }
+
+    SECTION("static routes keep priority") {
+        REQUIRE(name_of(reg.CreatePage("/projects/new")) == "new");
+        REQUIRE(data_of(reg.CreatePage("/projects/new")).empty());
+    }
+
+    SECTION("wildcard captures the rest of the path") {
+        auto page = reg.CreatePage("/docs/guide/install.html");
+        REQUIRE(data_of(page)["path"] == "guide/install.html");
+        REQUIRE_THROWS_AS(reg.CreatePage("/docs/"), std::runtime_error);
+    }
+
+    SECTION("unmatched paths throw") {
+        REQUIRE_THROWS_AS(reg.CreatePage("/projects"), std::runtime_error);
+        REQUIRE_THROWS_AS(reg.CreatePage("/projects//tasks/1"), std::runtime_error);
+        REQUIRE_THROWS_AS(reg.CreatePage("/projects/1/tasks"), std::runtime_error);
+    }
+
+    SECTION("patterns are registered routes") {
+        REQUIRE(reg.HasPage("/projects/:id"));
+        REQUIRE(reg.HasPage("/projects/123"));
+        REQUIRE_FALSE(reg.HasPage("/projects"));
+        REQUIRE(reg.PageRoutes() == std::vector<std::string>{"/projects/new"});
+        REQUIRE(reg.PagePatterns() == std::vector<std::string>{
+            "/docs/*path", "/projects/:id", "/projects/:id/tasks/:task"});
+        reg.UnregisterPage("/projects/:id");
+        REQUIRE_FALSE(reg.HasPage("/projects/123"));
+        REQUIRE_THROWS_AS(reg.CreatePage("/projects/123"), std::runtime_error);
+        REQUIRE(name_of(reg.CreatePage("/projects/1/tasks/2")) == "task");
+    }
+
+    SECTION("malformed and conflicting patterns are rejected") {
+        REQUIRE_THROWS_AS(reg.RegisterPage("/a/:", echo("x")), std::runtime_error);
+        REQUIRE_THROWS_AS(reg.RegisterPage("/a/*rest/b", echo("x")), std::runtime_error);
+        REQUIRE_THROWS_AS(reg.RegisterPage("/projects/:slug", echo("x")), std::runtime_error);
+        auto patterns = reg.PagePatterns();
+        REQUIRE(std::find(patterns.begin(), patterns.end(), "/projects/:slug") == patterns.end());
+    }
+}
+
+TEST_CASE("RouteTrie") {
+    RouteTrie trie;
+    trie.Insert("/a/b/c");
+    trie.Insert("/a/:x/d");
+    trie.Insert("/*rest");
+    RouteParams params;
+
+    SECTION("literal branches backtrack") {
+        REQUIRE(*trie.Match("/a/b/d", params) == "/a/:x/d");
+        REQUIRE(params == RouteParams{{"x", "b"}});
+        REQUIRE(*trie.Match("/a/b/e", params) == "/*rest");
+        REQUIRE(params == RouteParams{{"rest", "a/b/e"}});
+        REQUIRE(trie.Size() == 3);
+    }
+
+    SECTION("copies are independent") {
+        RouteTrie copy = trie;
+        copy.Erase("/*rest");
+        copy.Insert("/z/:y");
+        REQUIRE(copy.Match("/a/b/e", params) == nullptr);
+        REQUIRE(*trie.Match("/a/b/e", params) == "/*rest");
+        REQUIRE(trie.Match("/z/1", params) != nullptr);
+        REQUIRE(*trie.Match("/z/1", params) == "/*rest");
+        REQUIRE(*copy.Match("/z/1", params) == "/z/:y");
+        REQUIRE(copy.Size() == 3);
+    }
+
+    SECTION("erase prunes to empty") {
+        for (auto p : {"/a/b/c", "/a/:x/d", "/*rest"}) REQUIRE(trie.Erase(p));
+        REQUIRE_FALSE(trie.Erase("/a/b/c"));
+        REQUIRE(trie.Size() == 0);
+        REQUIRE(trie.Match("/a/b/c", params) == nullptr);
+    }
+}
+
+TEST_CASE("Registry page cache") {
+    Registry reg;
+    std::atomic<int> renders{0};
+    auto counting = [&renders](const nlohmann::json& data) {
+        ++renders;
+        if (!data.is_object()) return h1("?");
+        return h1(data.value("id", data.value("name", "?")));
+    };
+    reg.RegisterPage("/home", counting, {"content"});
+    reg.RegisterPage("/blog/:id", counting, {"blog", "content"});
+
+    SECTION("disabled cache renders every call") {
+        REQUIRE(*reg.RenderPage("/home") == "<h1>?</h1>");
+        reg.RenderPage("/home");
+        REQUIRE(renders == 2);
+        REQUIRE(reg.GetPageCache() == nullptr);
+    }
+
+    SECTION("keyed by route and data") {
+        reg.EnablePageCache();
+        auto a = reg.RenderPage("/home", {{"name", "x"}});
+        auto b = reg.RenderPage("/home", {{"name", "x"}});
+        REQUIRE(a == b);
+        REQUIRE(renders == 1);
+        REQUIRE(*reg.RenderPage("/home", {{"name", "y"}}) == "<h1>y</h1>");
+        REQUIRE(*reg.RenderPage("/blog/7") == "<h1>7</h1>");
+        REQUIRE(renders == 3);
+
+        auto stats = reg.GetPageCache()->GetStats();
+        REQUIRE(stats.hits == 1);
+        REQUIRE(stats.misses == 3);
+        REQUIRE(stats.entries == 3);
+    }
+
+    SECTION("invalidation by route, pattern, prefix and tag") {
+        reg.EnablePageCache();
+        auto cache = reg.GetPageCache();
+        auto warm = [&] {
+            for (auto r : {"/home", "/blog/1", "/blog/2"}) reg.RenderPage(r);
+        };
+        warm();
+        cache->Invalidate("/blog/1");
+        REQUIRE(cache->GetStats().entries == 2);
+        cache->Invalidate("/blog/:id");
+        REQUIRE(cache->GetStats().entries == 1);
+
+        warm();
+        cache->InvalidatePrefix("/blog/");
+        REQUIRE(cache->GetStats().entries == 1);
+
+        warm();
+        cache->InvalidateTag("blog");
+        REQUIRE(cache->GetStats().entries == 1);
+        cache->InvalidateTag("content");
+        REQUIRE(cache->GetStats().entries == 0);
+    }
+
+    SECTION("re-registering a route drops its output") {
+        reg.EnablePageCache();
+        reg.RenderPage("/home");
+        reg.RegisterPage("/home", [](auto) { return h1("New"); });
+        REQUIRE(*reg.RenderPage("/home") == "<h1>New</h1>");
+    }
+
+    SECTION("TTL and byte budget") {
+        PageCache::Options opts;
+        opts.ttl = std::chrono::milliseconds(1);
+        reg.EnablePageCache(opts);
+        reg.RenderPage("/home");
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        reg.RenderPage("/home");
+        REQUIRE(renders == 2);
+
+        opts.ttl = std::chrono::milliseconds(0);
+        opts.max_bytes = 2 * std::string("<h1>7</h1>").size();
+        reg.EnablePageCache(opts);
+        for (auto r : {"/blog/1", "/blog/2", "/blog/3"}) reg.RenderPage(r);
+        auto stats = reg.GetPageCache()->GetStats();
+        REQUIRE(stats.entries == 2);
+        REQUIRE(stats.evictions == 1);
+        reg.RenderPage("/blog/3");
+        REQUIRE(reg.GetPageCache()->GetStats().hits == 1);
+    }
+
+    SECTION("concurrent misses render once") {
+        reg.EnablePageCache();
+        std::atomic<int> slow_renders{0};
+        reg.RegisterPage("/slow", [&slow_renders](auto) {
+            ++slow_renders;
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            return h1("Slow");
+        });
+
+        std::vector<std::thread> threads;
+        std::vector<PageHtml> results(8);
+        for (int i = 0; i < 8; ++i) {
+            threads.emplace_back([&, i] { results[i] = reg.RenderPage("/slow"); });
+        }
+        for (auto& t : threads) t.join();
+        REQUIRE(slow_renders == 1);
+        for (const auto& html : results) REQUIRE(*html == "<h1>Slow</h1>");
+    }
+
+    SECTION("failed renders are not cached") {
+        reg.EnablePageCache();
+        bool fail = true;
+        reg.RegisterPage("/flaky", [&fail](auto) -> Element {
+            if (fail) throw std::runtime_error("backend down");
+            return h1("Ok");
+        });
+        REQUIRE_THROWS_AS(reg.RenderPage("/flaky"), std::runtime_error);
+        fail = false;
+        REQUIRE(*reg.RenderPage("/flaky") == "<h1>Ok</h1>");
+    }
+}
+
+TEST_CASE("Registry memoized components") {
+    Registry reg;
+    int calls = 0;
+    reg.RegisterComponent("navbar", [&calls](const nlohmann::json& data) {
+        ++calls;
+        return nav({a(data.value("label", "Home"), "/")});
+    }, Registry::Memo::ByData);
+
+    SECTION("same data returns the shared pre-rendered subtree") {
+        auto a1 = reg.CreateComponent("navbar", {{"label", "Home"}});
+        auto a2 = reg.CreateComponent("navbar", {{"label", "Home"}});
+        REQUIRE(a1 != a2);
+        REQUIRE(a1->Children()[0] == a2->Children()[0]);
+        REQUIRE(calls == 1);
+        REQUIRE_FALSE(a1->HtmlCache().empty());
+        REQUIRE(a2->HtmlCache() == a1->HtmlCache());
+
+        auto b = reg.CreateComponent("navbar", {{"label", "Start"}});
+        REQUIRE(b != a1);
+        REQUIRE(calls == 2);
+
+        auto stats = reg.GetComponentStats("navbar");
+        REQUIRE(stats.hits == 1);
+        REQUIRE(stats.misses == 2);
+        REQUIRE(stats.entries == 2);
+    }
+
+    SECTION("pages reuse the cached HTML") {
+        auto page1 = div({reg.CreateComponent("navbar", {{"label", "Home"}}), h1("One")});
+        auto page2 = div({reg.CreateComponent("navbar", {{"label", "Home"}}), h1("Two")});
+        REQUIRE(HtmlRenderer::RenderToString(page1) ==
+                "<div><nav><a href=\"/\" target=\"_self\">Home</a></nav><h1>One</h1></div>");
+        REQUIRE(HtmlRenderer::RenderToString(page2).find("<nav>") == 5);
+        REQUIRE(calls == 1);
+    }
+
+    SECTION("changing a result leaves later calls alone") {
+        auto original = HtmlRenderer::RenderToString(reg.CreateComponent("navbar", {{"label", "Home"}}));
+        auto mine = reg.CreateComponent("navbar", {{"label", "Home"}});
+        mine->AddClass("sticky");
+        mine->AppendChild(span("beta"));
+        REQUIRE(HtmlRenderer::RenderToString(mine) != original);
+
+        auto next = reg.CreateComponent("navbar", {{"label", "Home"}});
+        REQUIRE(next->ChildCount() == 1);
+        REQUIRE_FALSE(next->HasClass("sticky"));
+        REQUIRE(HtmlRenderer::RenderToString(next) == original);
+        REQUIRE(calls == 1);
+    }
+
+    SECTION("re-registering drops memoized results") {
+        reg.CreateComponent("navbar", {{"label", "Home"}});
+        reg.RegisterComponent("navbar", [&calls](auto) { ++calls; return nav({}); },
+                              Registry::Memo::ByData);
+        REQUIRE(reg.CreateComponent("navbar")->ChildCount() == 0);
+        REQUIRE(calls == 2);
+        REQUIRE(reg.GetComponentStats("navbar").entries == 1);
+    }
+
+    SECTION("unmemoized components build fresh trees") {
+        reg.RegisterComponent("card", [](auto) { return div({}); });
+        REQUIRE(reg.CreateComponent("card") != reg.CreateComponent("card"));
+        REQUIRE_THROWS_AS(reg.GetComponentStats("missing"), std::runtime_error);
+    }
+}
+
+TEST_CASE("Registry transactions") {
+    Registry reg;
+    auto page = [](const char* name) { return [name](auto) { return h1(name); }; };
+
+    SECTION("staged operations publish once, in order") {
+        reg.RegisterPage("/old", page("old"));
+        auto version = reg.Version();
+
+        Registry::Transaction tx(reg);
+        tx.UnregisterPage("/old");
+        tx.RegisterPage("/a", page("a"));
+        tx.RegisterPage("/projects/:id", page("project"));
+        tx.RegisterComponent("card", [](auto) { return div({}); });
+        tx.UnregisterPage("/a");
+        tx.RegisterPage("/a", page("a2"));
+        REQUIRE(tx.Size() == 6);
+        REQUIRE(reg.HasPage("/old"));
+        REQUIRE_FALSE(reg.HasPage("/a"));
+
+        tx.Commit();
+        REQUIRE(reg.Version() == version + 1);
+        REQUIRE(reg.PageRoutes() == std::vector<std::string>{"/a"});
+        REQUIRE(reg.PagePatterns() == std::vector<std::string>{"/projects/:id"});
+        REQUIRE(reg.CreatePage("/a")->TextContent() == "a2");
+        REQUIRE(reg.CreatePage("/projects/7")->TextContent() == "project");
+        REQUIRE(reg.HasComponent("card"));
+
+        REQUIRE(tx.Size() == 0);
+        tx.Commit();
+        REQUIRE(reg.Version() == version + 1);
+    }
+
+    SECTION("a rejected operation publishes nothing") {
+        Registry::Transaction tx(reg);
+        tx.RegisterPage("/ok", page("ok"));
+        tx.RegisterPage("/bad/:", page("bad"));
+        auto version = reg.Version();
+        REQUIRE_THROWS_AS(tx.Commit(), std::runtime_error);
+        REQUIRE(reg.Version() == version);
+        REQUIRE_FALSE(reg.HasPage("/ok"));
+    }
+
+    SECTION("committed routes drop their cached output") {
+        reg.EnablePageCache();
+        reg.RegisterPage("/a", page("a"));
+        REQUIRE(*reg.RenderPage("/a") == "<h1>a</h1>");
+
+        Registry::Transaction tx(reg);
+        tx.UnregisterPage("/a");
+        tx.RegisterPage("/a", page("b"));
+        tx.Commit();
+        REQUIRE(*reg.RenderPage("/a") == "<h1>b</h1>");
+    }
+
+    SECTION("readers never see a partial reload") {
+        constexpr int kPages = 5000;
+        std::vector<std::string> routes;
+        for (int i = 0; i < kPages; ++i) routes.push_back("/page" + std::to_string(i));
+
+        auto reload = [&] {
+            Registry::Transaction tx(reg);
+            for (const auto& route : routes) tx.UnregisterPage(route);
+            for (const auto& route : routes) tx.RegisterPage(route, page("page"));
+            tx.Commit();
+        };
+        reload();
+        auto version = reg.Version();
+
+        std::atomic<bool> stop{false};
+        std::atomic<int> lookups{0}, missing{0};
+        std::vector<std::thread> readers;
+        for (int t = 0; t < 4; ++t) {
+            readers.emplace_back([&, t] {
+                for (int i = t; !stop || i < t + kPages; i += 7) {
+                    if (!reg.HasPage(routes[i % kPages])) missing++;
+                    lookups++;
+                }
+            });
+        }
+        for (int i = 0; i < 10; ++i) reload();
+        stop = true;
+        for (auto& r : readers) r.join();
+
+        REQUIRE(lookups > 0);
+        REQUIRE(missing == 0);
+        REQUIRE(reg.Version() == version + 10);
+    }
+}
+
+TEST_CASE("Registry typed components") {
+    Registry reg;
+    const CardProps* seen = nullptr;
+    reg.RegisterComponent<CardProps>("card", [&seen](const CardProps& props) {
+        seen = &props;
+        return div({h2(props.title), span(std::to_string(props.count))});
+    });
+
+    SECTION("props are passed through without conversion") {
+        CardProps card{"Inbox", 3};
+        auto el = reg.CreateComponent<CardProps>("card", card);
+        REQUIRE(seen == &card);
+        REQUIRE(HtmlRenderer::RenderToString(el) == "<div><h2>Inbox</h2><span>3</span></div>");
+    }
+
+    SECTION("JSON callers get converted props") {
+        auto el = reg.CreateComponent("card", {{"title", "Sent"}, {"count", 7}});
+        REQUIRE(HtmlRenderer::RenderToString(el) == "<div><h2>Sent</h2><span>7</span></div>");
+        REQUIRE_THROWS_AS(reg.CreateComponent("card", {{"title", 1}}), std::runtime_error);
+    }
+
+    SECTION("props types are checked at run time") {
+        REQUIRE_THROWS_AS(reg.CreateComponent<RowProps>("card", RowProps{}), std::runtime_error);
+        REQUIRE_THROWS_AS(reg.CreateComponent<CardProps>("missing", CardProps{}),
+                          std::runtime_error);
+    }
+
+    SECTION("JSON components accept serializable props") {
+        reg.RegisterComponent("label", [](const nlohmann::json& data) {
+            return span(data["title"].get<std::string>());
+        });
+        REQUIRE(reg.CreateComponent<CardProps>("label", CardProps{"Drafts", 0})->TextContent() ==
+                "Drafts");
+        REQUIRE_THROWS_AS(reg.CreateComponent<RowProps>("label", RowProps{}), std::runtime_error);
+    }
+
+    SECTION("props without JSON conversion are typed-only") {
+        std::vector<std::string> cells{"a", "b"};
+        reg.RegisterComponent<RowProps>("row", [](const RowProps& props) {
+            Elements tds;
+            for (const auto& cell : *props.cells) tds.push_back(td(cell));
+            return tr(tds);
+        });
+        REQUIRE(reg.CreateComponent<RowProps>("row", RowProps{&cells})->ChildCount() == 2);
+        REQUIRE_THROWS_AS(reg.CreateComponent("row"), std::runtime_error);
+    }
+
+    SECTION("transactions stage typed components") {
+        Registry::Transaction tx(reg);
+        tx.RegisterComponent<CardProps>("badge", [](const CardProps& props) {
+            return span(props.title);
+        });
+        tx.Commit();
+        REQUIRE(reg.CreateComponent<CardProps>("badge", CardProps{"New", 1})->TextContent() == "New");
+    }
+}
+
+TEST_CASE("Task and Executor") {
+    auto value = [](int v) -> Task<int> { co_return v; };
+    auto fail = []() -> Task<int> {
+        throw std::runtime_error("boom");
+        co_return 0;
+    };
+
+    SECTION("SyncWait returns the result or rethrows") {
+        REQUIRE(SyncWait(value(42)) == 42);
+        REQUIRE_THROWS_AS(SyncWait(fail()), std::runtime_error);
+    }
+
+    SECTION("tasks compose") {
+        auto sum = [&]() -> Task<int> { co_return co_await value(1) + co_await value(2); };
+        REQUIRE(SyncWait(sum()) == 3);
+    }
+
+    SECTION("WhenAll keeps order and runs on the executor") {
+        Executor pool(2);
+        auto caller = std::this_thread::get_id();
+        auto where = [caller](int v) -> Task<int> {
+            co_return std::this_thread::get_id() == caller ? -1 : v;
+        };
+        std::vector<Task<int>> tasks;
+        for (int i = 0; i < 8; ++i) tasks.push_back(where(i));
+        REQUIRE(SyncWait(WhenAll(std::move(tasks), pool)) == std::vector<int>{0, 1, 2, 3, 4, 5, 6, 7});
+        REQUIRE(SyncWait(WhenAll(std::vector<Task<int>>{})).empty());
+    }
+
+    SECTION("WhenAll rethrows after every task finished") {
+        std::atomic<int> finished{0};
+        auto slow = [&finished]() -> Task<int> {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            finished++;
+            co_return 1;
+        };
+        REQUIRE_THROWS_AS(SyncWait(WhenAll(slow(), fail(), slow())), std::runtime_error);
+        REQUIRE(finished == 2);
+    }
+}
+
+TEST_CASE("Registry async pages") {
+    Registry reg;
+    std::atomic<int> running{0}, peak{0};
+    // Stand-in for a component waiting on a data source
+    reg.RegisterComponentAsync("widget", [&](nlohmann::json data) -> Task<Element> {
+        int now = ++running;
+        for (int seen = peak; now > seen && !peak.compare_exchange_weak(seen, now);) {}
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        --running;
+        co_return span(data["name"].get<std::string>());
+    });
+    reg.RegisterComponent("title", [](auto) { return h1("Dashboard"); });
+    reg.RegisterPageAsync("/dash/:user", [&reg](nlohmann::json data) -> Task<Element> {
+        std::vector<Task<Element>> parts;
+        parts.push_back(reg.CreateComponentAsync("title"));
+        for (auto name : {"a", "b", "c", "d", "e"}) {
+            parts.push_back(reg.CreateComponentAsync("widget", {{"name", name}}));
+        }
+        auto children = co_await WhenAll(std::move(parts));
+        children.push_back(p(data["user"].get<std::string>()));
+        co_return div(children);
+    });
+
+    const std::string expected =
+        "<div><h1>Dashboard</h1><span>a</span><span>b</span><span>c</span>"
+        "<span>d</span><span>e</span><p>ann</p></div>";
+
+    SECTION("components resolve concurrently") {
+        REQUIRE(HtmlRenderer::RenderToString(SyncWait(reg.CreatePageAsync("/dash/ann"))) == expected);
+        REQUIRE(peak > 1);
+    }
+
+    SECTION("synchronous callers still work") {
+        REQUIRE(HtmlRenderer::RenderToString(reg.CreatePage("/dash/ann")) == expected);
+        REQUIRE(*reg.RenderPage("/dash/ann") == expected);
+        REQUIRE(reg.CreateComponent("widget", {{"name", "x"}})->TextContent() == "x");
+        REQUIRE(SyncWait(reg.CreatePageAsync("/dash/ann")) != nullptr);
+    }
+
+    SECTION("lookup errors surface on await") {
+        REQUIRE_THROWS_AS(SyncWait(reg.CreateComponentAsync("missing")), std::runtime_error);
+        REQUIRE_THROWS_AS(SyncWait(reg.CreatePageAsync("/nope")), std::runtime_error);
+    }
+
+    SECTION("transactions stage coroutine pages") {
+        Registry::Transaction tx(reg);
+        tx.UnregisterPage("/dash/:user");
+        tx.RegisterPageAsync("/team", [&reg](nlohmann::json) -> Task<Element> {
+            auto title = co_await reg.CreateComponentAsync("title");
+            co_return div({title});
+        }, {"team"});
+        REQUIRE_FALSE(reg.HasPage("/team"));
+
+        tx.Commit();
+        REQUIRE_FALSE(reg.HasPage("/dash/ann"));
+        REQUIRE(HtmlRenderer::RenderToString(SyncWait(reg.CreatePageAsync("/team"))) ==
+                "<div><h1>Dashboard</h1></div>");
+        REQUIRE(*reg.RenderPage("/team") == "<div><h1>Dashboard</h1></div>");
+    }
+}
@@ -1,6 +1,11 @@
 #include <catch2/catch_test_macros.hpp>
 #include <fwui/fwui.hpp>
 
+#include <future>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
 using namespace fwui;
 
 TEST_CASE("HtmlRenderer simple elements") {
@@ -134,6 +139,235 @@ TEST_CASE("HtmlRenderer null element") {
     REQUIRE(html.empty());
 }
 
+TEST_CASE("HtmlRenderer RenderTo") {
+    SECTION("matches Render") {
+        auto el = div({h1("Title"), paragraph("a < b")});
+        std::ostringstream out;
+        HtmlRenderer().RenderTo(el, out);
+        REQUIRE(out.str() == HtmlRenderer::RenderToString(el));
+    }
+
+    SECTION("large streams are flushed in chunks with identical output") {
+        constexpr int kRows = 20000;
+        auto el = ul({for_each_row([]() -> RowGenerator {
+            return [n = 0]() mutable -> Element {
+                return n < kRows ? li("row " + std::to_string(n++)) : nullptr;
+            };
+        })});
+        std::ostringstream out;
+        HtmlRenderer().RenderTo(el, out);
+        REQUIRE(out.str() == HtmlRenderer::RenderToString(el));
+        REQUIRE(out.str().size() > 64 * 1024);
+    }
+}
+
+TEST_CASE("HtmlRenderer raw_sink") {
+    int writes = 0;
+    auto el = div({h1("T"), raw_sink([&](std::ostream& out) {
+        writes++;
+        out << "<b>" << writes << "</b>";
+    })});
+
+    SECTION("written into the output in place, on every render") {
+        REQUIRE(HtmlRenderer::RenderToString(el) == "<div><h1>T</h1><b>1</b></div>");
+        REQUIRE(HtmlRenderer::RenderToString(el) == "<div><h1>T</h1><b>2</b></div>");
+        REQUIRE(el->HtmlCache().empty());
+    }
+
+    SECTION("other consumers see a raw node") {
+        auto j = el->ToJSON();
+        REQUIRE(j["children"][1]["children"][0]["text"] == "<b>1</b>");
+        REQUIRE(j["children"][1]["children"][0]["raw"] == true);
+    }
+
+    SECTION("RenderTo passes large output through in chunks") {
+        std::ostringstream out;
+        size_t sent_while_writing = 0;
+        auto big = raw_sink([&](std::ostream& sink) {
+            std::string chunk(16 * 1024, 'x');
+            for (int i = 0; i < 10; ++i) sink << chunk;
+            sent_while_writing = out.str().size();
+        });
+        HtmlRenderer().RenderTo(div({big}), out);
+        REQUIRE(sent_while_writing > 0);
+        REQUIRE(out.str() == HtmlRenderer::RenderToString(div({big})));
+    }
+}
+
+// Records what had been written at every flush
+class FlushLog : public std::stringbuf {
+public:
+    std::vector<std::string> flushes;
+    std::function<void()>    on_flush;
+
+protected:
+    int sync() override {
+        flushes.push_back(str());
+        if (on_flush) on_flush();
+        return 0;
+    }
+};
+
+TEST_CASE("HtmlRenderer RenderStream") {
+    Executor pool(2);
+    auto ready = [](std::string text) {
+        return [text]() -> Task<Element> { co_return span(text); };
+    };
+
+    SECTION("Render waits for slots in place") {
+        auto el = div({slot(ready("a"), p("...")), slot(ready("b"))});
+        REQUIRE(HtmlRenderer::RenderToString(el) == "<div><span>a</span><span>b</span></div>");
+    }
+
+    SECTION("shell and fast slots go out before slow slots complete") {
+        std::promise<void> fast_sent;
+        auto gate = fast_sent.get_future().share();
+        auto slow = [gate]() -> Task<Element> {
+            gate.wait();
+            co_return span("slow");
+        };
+        auto page = document("T", {}, {h1("Head"), slot(slow, p("loading")), slot(ready("fast"))});
+
+        FlushLog log;
+        // Flush 1 is the shell, flush 2 the fast slot
+        log.on_flush = [&] {
+            if (log.flushes.size() == 2) fast_sent.set_value();
+        };
+        std::ostream out(&log);
+        HtmlRenderer().RenderStream(page, out, pool);
+
+        const auto& shell = log.flushes.front();
+        REQUIRE(shell.find("<h1>Head</h1><fwui-slot id=\"fwui-slot-0\" style=\"display: contents\">"
+                           "<p>loading</p></fwui-slot><fwui-slot id=\"fwui-slot-1\"") !=
+                std::string::npos);
+        REQUIRE(shell.find("function fwuiSwap") != std::string::npos);
+        REQUIRE(shell.find("<template") == std::string::npos);
+        REQUIRE(shell.find("</body>") == std::string::npos);
+
+        auto html = log.str();
+        auto fast = html.find("<template id=\"fwui-fill-1\"><span>fast</span></template>"
+                              "<script>fwuiSwap(1)</script>");
+        auto slow_fill = html.find("<template id=\"fwui-fill-0\"><span>slow</span></template>");
+        REQUIRE(fast != std::string::npos);
+        REQUIRE(slow_fill > fast);
+        REQUIRE(html.ends_with("</body></html>"));
+    }
+
+    SECTION("failed slots keep the fallback and rethrow at the end") {
+        auto broken = []() -> Task<Element> {
+            throw std::runtime_error("backend down");
+            co_return nullptr;
+        };
+        auto page = document("T", {}, {slot(broken, p("unavailable")), slot(ready("ok"))});
+        std::ostringstream out;
+        REQUIRE_THROWS_AS(HtmlRenderer().RenderStream(page, out, pool), std::runtime_error);
+        REQUIRE(out.str().find("<p>unavailable</p>") != std::string::npos);
+        REQUIRE(out.str().find("<template id=\"fwui-fill-0\"") == std::string::npos);
+        REQUIRE(out.str().find("<span>ok</span>") != std::string::npos);
+        REQUIRE(out.str().ends_with("</body></html>"));
+    }
+
+    SECTION("registry components stream as slots") {
+        Registry reg;
+        reg.RegisterComponent("feed", [](const nlohmann::json& data) {
+            return ul({li(data["first"].get<std::string>())});
+        });
+        auto page = div({reg.SlotComponent("feed", {{"first", "hello"}}, p("..."))});
+        std::ostringstream out;
+        HtmlRenderer().RenderStream(page, out, pool);
+        REQUIRE(out.str().find("<template id=\"fwui-fill-0\"><ul><li>hello</li></ul></template>") !=
+                std::string::npos);
+    }
+
+    SECTION("pages without slots render as RenderTo") {
+        auto el = div({h1("Plain")});
+        std::ostringstream out;
+        HtmlRenderer().RenderStream(el, out, pool);
+        REQUIRE(out.str() == "<div><h1>Plain</h1></div>");
+    }
+}
+
+TEST_CASE("SvgSpritePass") {
+    const std::string icon =
+        "<path d=\"M12 2L2 7l10 5 10-5-10-5zM2 17l10 5 10-5M2 12l10 5 10-5\"/>";
+    auto row = [&](int i) {
+        return tr({td(std::to_string(i)), td({svg(icon, {{"viewBox", "0 0 24 24"}})})});
+    };
+    auto page = [&](int rows) {
+        Elements trs;
+        for (int i = 0; i < rows; ++i) trs.push_back(row(i));
+        return document("Products", {}, {table({tbody(trs)})});
+    };
+
+    SECTION("repeated payloads become one symbol") {
+        auto doc = page(10);
+        auto report = SvgSpritePass().Apply(doc);
+        REQUIRE(report.svgs == 10);
+        REQUIRE(report.symbols == 1);
+        REQUIRE(report.replaced == 10);
+        REQUIRE(report.BytesSaved() > 0);
+
+        auto html = HtmlRenderer::RenderToString(doc);
+        size_t symbol = html.find("<symbol id=\"fwui-svg-");
+        REQUIRE(symbol != std::string::npos);
+        REQUIRE(html.find(icon) == html.rfind(icon));
+        REQUIRE(html.find("<svg viewBox=\"0 0 24 24\"><use href=\"#fwui-svg-") != std::string::npos);
+        // Sprite is the first thing in <body>
+        REQUIRE(html.find("<body><svg style=") != std::string::npos);
+    }
+
+    SECTION("report matches the rendered size") {
+        auto before = HtmlRenderer::RenderToString(page(10)).size();
+        auto doc = page(10);
+        auto report = SvgSpritePass().Apply(doc);
+        auto after = HtmlRenderer::RenderToString(doc).size();
+        REQUIRE(static_cast<ptrdiff_t>(before - after) == report.BytesSaved());
+    }
+
+    SECTION("single occurrences stay inline") {
+        auto doc = page(1);
+        auto report = SvgSpritePass().Apply(doc);
+        REQUIRE(report.symbols == 0);
+        REQUIRE(HtmlRenderer::RenderToString(doc).find("<symbol") == std::string::npos);
+    }
+
+    SECTION("cached tree is re-rendered") {
+        auto doc = page(5);
+        auto original = HtmlRenderer::RenderToString(doc);
+        SvgSpritePass().Apply(doc);
+        REQUIRE(HtmlRenderer::RenderToString(doc) != original);
+    }
+
+    SECTION("second pass is a no-op") {
+        auto doc = page(5);
+        SvgSpritePass().Apply(doc);
+        auto html = HtmlRenderer::RenderToString(doc);
+        auto report = SvgSpritePass().Apply(doc);
+        REQUIRE(report.symbols == 0);
+        REQUIRE(HtmlRenderer::RenderToString(doc) == html);
+    }
+
+    SECTION("shared subtrees are copied, not rewritten") {
+        Registry registry;
+        registry.RegisterComponent("toolbar", [&](const nlohmann::json&) {
+            Elements icons;
+            for (int i = 0; i < 5; ++i) icons.push_back(svg(icon));
+            return div(icons);
+        }, Registry::Memo::ByData);
+        auto toolbar = HtmlRenderer::RenderToString(registry.CreateComponent("toolbar"));
+
+        auto with_pass = document("A", {}, {registry.CreateComponent("toolbar")});
+        REQUIRE(SvgSpritePass().Apply(with_pass).replaced == 5);
+        REQUIRE(HtmlRenderer::RenderToString(with_pass).find("<use href=") != std::string::npos);
+
+        auto without = document("B", {}, {registry.CreateComponent("toolbar")});
+        auto html = HtmlRenderer::RenderToString(without);
+        REQUIRE(html.find("<use href=") == std::string::npos);
+        REQUIRE(html.find(toolbar) != std::string::npos);
+        REQUIRE(HtmlRenderer::RenderToString(registry.CreateComponent("toolbar")) == toolbar);
+    }
+}
+
 TEST_CASE("JsonRenderer") {
     SECTION("compact") {
         JsonRenderer renderer;
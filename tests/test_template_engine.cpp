@@ -1,5 +1,14 @@
 #include <catch2/catch_test_macros.hpp>
 #include <fwui/template_engine.hpp>
+#include <fwui/elements.hpp>
+#include <fwui/registry.hpp>
+
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <vector>
 
 using namespace fwui;
 
@@ -131,3 +140,166 @@ TEST_CASE("TemplateEngine HTML generation") {
         REQUIRE(result == "<ul><li>Home</li><li>About</li><li>Contact</li></ul>");
     }
 }
+
+TEST_CASE("TemplateEngine compiled cache") {
+    namespace fs = std::filesystem;
+    auto dir = fs::temp_directory_path() / "fwui_template_cache";
+    fs::create_directories(dir / "partials");
+    auto write = [](const fs::path& path, const std::string& text) {
+        std::ofstream(path, std::ios::trunc) << text;
+    };
+    TemplateEngine::SetTemplateDirectory((dir / "partials").string());
+
+    SECTION("string templates are parsed once") {
+        auto before = TemplateEngine::GetCacheStats();
+        REQUIRE(TemplateEngine::Render("Hi {{ name }}", {{"name", "A"}}) == "Hi A");
+        REQUIRE(TemplateEngine::Render("Hi {{ name }}", {{"name", "B"}}) == "Hi B");
+        auto after = TemplateEngine::GetCacheStats();
+        REQUIRE(after.misses == before.misses + 1);
+        REQUIRE(after.hits == before.hits + 1);
+    }
+
+    SECTION("files are re-parsed when they change") {
+        auto page = (dir / "page.html").string();
+        write(page, "version 1");
+        REQUIRE(TemplateEngine::RenderFile(page, {}) == "version 1");
+        auto before = TemplateEngine::GetCacheStats();
+        REQUIRE(TemplateEngine::RenderFile(page, {}) == "version 1");
+        REQUIRE(TemplateEngine::GetCacheStats().hits == before.hits + 1);
+
+        write(page, "version two");
+        REQUIRE(TemplateEngine::RenderFile(page, {}) == "version two");
+        REQUIRE(TemplateEngine::GetCacheStats().misses == before.misses + 1);
+        REQUIRE_THROWS_AS(TemplateEngine::RenderFile((dir / "missing.html").string(), {}),
+                          std::runtime_error);
+    }
+
+    SECTION("invalidating a partial drops the templates that include it") {
+        write(dir / "partials" / "header.html", "<h1>Old</h1>");
+        auto page = (dir / "with_header.html").string();
+        write(page, "{% include \"header.html\" %}");
+        REQUIRE(TemplateEngine::RenderFile(page, {}) == "<h1>Old</h1>");
+
+        write(dir / "partials" / "header.html", "<h1>New</h1>");
+        TemplateEngine::Invalidate("header.html");
+        REQUIRE(TemplateEngine::GetCacheStats().entries == 0);
+        REQUIRE(TemplateEngine::RenderFile(page, {}) == "<h1>New</h1>");
+
+        TemplateEngine::Clear();
+        REQUIRE(TemplateEngine::GetCacheStats().entries == 0);
+    }
+
+    TemplateEngine::SetTemplateDirectory("");
+    fs::remove_all(dir);
+}
+
+TEST_CASE("TemplateEngine instances") {
+    namespace fs = std::filesystem;
+    auto root = fs::temp_directory_path() / "fwui_template_instances";
+    for (auto site : {"a", "b"}) {
+        fs::create_directories(root / site);
+        std::ofstream(root / site / "brand.html", std::ios::trunc) << "site " << site;
+    }
+    TemplateEngine a((root / "a").string());
+    TemplateEngine b((root / "b").string());
+
+    SECTION("each instance resolves includes in its own directory") {
+        const std::string page = "{% include \"brand.html\" %}";
+        REQUIRE(a.RenderString(page, {}) == "site a");
+        REQUIRE(b.RenderString(page, {}) == "site b");
+        REQUIRE(a.Directory() == (root / "a").string());
+    }
+
+    SECTION("RenderStringTo and RenderPathTo write to a stream") {
+        std::ostringstream out;
+        a.RenderStringTo(out, "[{{ n }}]", {{"n", 1}});
+        a.RenderPathTo(out, "brand.html", {});
+        REQUIRE(out.str() == "[1]site a");
+        REQUIRE(a.RenderString("[{{ n }}]", {{"n", 1}}) == "[1]");
+    }
+
+    SECTION("callbacks are per instance") {
+        a.AddCallback("twice", 1, [](TemplateEngine::Arguments& args) {
+            return args.at(0)->get<int>() * 2;
+        });
+        REQUIRE(a.RenderString("{{ twice(21) }}", {}) == "42");
+        REQUIRE_THROWS(b.RenderString("{{ twice(21) }}", {}));
+    }
+
+    SECTION("callbacks may render through the same engine") {
+        a.AddCallback("brand", 0, [&a](TemplateEngine::Arguments&) {
+            return a.RenderPath("brand.html", {});
+        });
+        REQUIRE(a.RenderString("[{{ brand() }}]", {}) == "[site a]");
+        REQUIRE(a.RenderString("[{{ brand() }}]", {}) == "[site a]");
+    }
+
+    SECTION("included partials stay compiled until evicted") {
+        const std::string page = "{% include \"brand.html\" %}";
+        REQUIRE(a.RenderString(page, {}) == "site a");
+        std::ofstream(root / "a" / "brand.html", std::ios::trunc) << "site A2";
+        REQUIRE(a.RenderString(page, {}) == "site a");
+        a.Evict("brand.html");
+        REQUIRE(a.RenderString(page, {}) == "site A2");
+    }
+
+    SECTION("concurrent renders share the compiled template") {
+        std::vector<std::thread> threads;
+        std::atomic<int> wrong{0};
+        for (int t = 0; t < 8; ++t) {
+            threads.emplace_back([&, t] {
+                for (int i = 0; i < 200; ++i) {
+                    auto html = a.RenderString("{{ n }}-{% include \"brand.html\" %}", {{"n", t}});
+                    if (html != std::to_string(t) + "-site a") wrong++;
+                }
+            });
+        }
+        for (auto& thread : threads) thread.join();
+        REQUIRE(wrong == 0);
+        REQUIRE(a.Stats().misses == 1);
+        REQUIRE(a.Stats().hits == 8 * 200 - 1);
+    }
+
+    SECTION("the static API wraps a replaceable default instance") {
+        TemplateEngine::SetTemplateDirectory((root / "b").string());
+        auto before = TemplateEngine::Default();
+        REQUIRE(TemplateEngine::Render("{% include \"brand.html\" %}", {}) == "site b");
+        TemplateEngine::SetTemplateDirectory("");
+        REQUIRE(TemplateEngine::Default() != before);
+        REQUIRE(before->Directory() == (root / "b").string());
+    }
+
+    fs::remove_all(root);
+}
+
+TEST_CASE("TemplateEngine components") {
+    Registry registry;
+    int navbar_runs = 0;
+    registry.RegisterComponent("navbar", [&](const nlohmann::json&) {
+        navbar_runs++;
+        return nav({a("Home", "/")});
+    }, Registry::Memo::ByData);
+    registry.RegisterComponent("badge", [](const nlohmann::json& data) {
+        return span(data.value("text", ""));
+    });
+
+    TemplateEngine engine;
+    engine.BindComponents(registry);
+
+    SECTION("component() renders registry components") {
+        REQUIRE(engine.RenderString("<b>{{ component(\"badge\", {\"text\": \"new\"}) }}</b>", {}) ==
+                "<b><span>new</span></b>");
+        REQUIRE_THROWS(engine.RenderString("{{ component(\"missing\") }}", {}));
+    }
+
+    SECTION("memoized components are built once across pages") {
+        const std::string page_a = "{{ component(\"navbar\") }}<h1>A</h1>";
+        const std::string page_b = "{{ component(\"navbar\") }}<h1>B</h1>";
+        auto html = engine.RenderString(page_a, {});
+        REQUIRE(html.find("<nav>") == 0);
+        REQUIRE(engine.RenderString(page_b, {}).find("<nav>") == 0);
+        REQUIRE(engine.RenderString(page_a, {}) == html);
+        REQUIRE(navbar_runs == 1);
+        REQUIRE(registry.GetComponentStats("navbar").hits == 2);
+    }
+}
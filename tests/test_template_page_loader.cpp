@@ -0,0 +1,215 @@
+#include <catch2/catch_test_macros.hpp>
+#include <fwui/fwui.hpp>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+
+using namespace fwui;
+namespace fs = std::filesystem;
+
+using Routes = std::vector<std::string>;
+
+TEST_CASE("TemplatePageLoader dependencies") {
+    auto root = fs::temp_directory_path() / "fwui_loader_deps";
+    fs::remove_all(root);
+    for (auto dir : {"pages", "templates", "data"}) fs::create_directories(root / dir);
+    std::ofstream(root / "templates/nav.html") << "<nav>{{ site_name }}</nav>";
+    std::ofstream(root / "pages/index.html")
+        << "{% include \"nav.html\" %}{% for p in projects %}{{ p }}{% endfor %}";
+    std::ofstream(root / "pages/about.html") << "<h1>{{ about.title }}</h1>";
+    std::ofstream(root / "pages/odd.html") << "{% macro m() %}{% endmacro %}";  // not VM-compilable
+    std::ofstream(root / "data/site.json") << R"({"site_name": "fwui"})";
+    std::ofstream(root / "data/projects.json") << R"(["a", "b"])";
+    std::ofstream(root / "data/about.json") << R"({"title": "About"})";
+
+    auto path = [&](const char* name) { return (root / name).string(); };
+    Registry registry;
+    TemplatePageLoader loader({.pages_dir     = path("pages"),
+                               .data_dir      = path("data"),
+                               .templates_dir = path("templates")});
+    loader.LoadPages(registry);
+    const auto& deps = loader.Dependencies();
+
+    SECTION("includes and data files are tracked per page") {
+        REQUIRE(deps.Size() == 3);
+        REQUIRE(deps.Affected({path("templates/nav.html")}) == Routes{"/", "/odd"});
+        REQUIRE(deps.Affected({path("data/projects.json")}) == Routes{"/", "/odd"});
+        REQUIRE(deps.Affected({path("data/about.json")}) == Routes{"/about", "/odd"});
+        REQUIRE(deps.Affected({path("data/site.json")}) == Routes{"/", "/about", "/odd"});
+        REQUIRE(deps.Affected({path("pages/about.html")}) == Routes{"/about"});
+    }
+
+    SECTION("Invalidate drops cached pages of the affected routes") {
+        registry.EnablePageCache();
+        registry.RenderPage("/");
+        registry.RenderPage("/about");
+        REQUIRE(registry.GetPageCache()->GetStats().entries == 2);
+        REQUIRE(loader.Invalidate(registry, {path("data/projects.json")}) == Routes{"/", "/odd"});
+        REQUIRE(registry.GetPageCache()->GetStats().entries == 1);
+    }
+
+    SECTION("ReloadPages rebuilds the graph") {
+        fs::remove(root / "pages/odd.html");
+        loader.ReloadPages(registry);
+        REQUIRE(deps.Pages() == Routes{"/", "/about"});
+    }
+
+    fs::remove_all(root);
+}
+
+TEST_CASE("TemplatePageLoader incremental reload") {
+    auto root = fs::temp_directory_path() / "fwui_loader_reload";
+    fs::remove_all(root);
+    for (auto dir : {"pages/blog", "templates", "data"}) fs::create_directories(root / dir);
+    std::ofstream(root / "templates/nav.html") << "<nav></nav>";
+    std::ofstream(root / "pages/index.html") << "{% include \"nav.html\" %}home";
+    std::ofstream(root / "pages/about.html") << "{{ team }}";
+    std::ofstream(root / "pages/blog/first.html") << "first";
+    std::ofstream(root / "pages/blog/second.html") << "second";
+    std::ofstream(root / "data/team.json") << R"(["amy"])";
+
+    auto path = [&](const char* name) { return (root / name).string(); };
+    auto touch = [&](const char* name, const char* content) {
+        std::ofstream(root / name, std::ios::trunc) << content;
+        fs::last_write_time(root / name, fs::last_write_time(root / name) + std::chrono::seconds(1));
+    };
+
+    Registry registry;
+    TemplatePageLoader loader({.pages_dir     = path("pages"),
+                               .data_dir      = path("data"),
+                               .templates_dir = path("templates"),
+                               .bytecode      = true});
+    REQUIRE(loader.LoadPages(registry).size() == 4);
+    auto version = registry.Version();
+
+    SECTION("a modified page re-registers only its route") {
+        touch("pages/blog/first.html", "first v2");
+        REQUIRE(loader.ReloadPages(registry, {path("pages/blog/first.html")}) == Routes{"/blog/first"});
+        REQUIRE(registry.Version() == version + 1);
+        REQUIRE(HtmlRenderer().Render(registry.CreatePage("/blog/first")) == "first v2");
+    }
+
+    SECTION("added and deleted pages") {
+        touch("pages/contact.html", "contact");
+        fs::remove(root / "pages/about.html");
+        REQUIRE(loader.ReloadPages(registry, {path("pages/contact.html"), path("pages/about.html")}) ==
+                Routes{"/about", "/contact"});
+        REQUIRE(registry.HasPage("/contact"));
+        REQUIRE_FALSE(registry.HasPage("/about"));
+        REQUIRE(loader.Dependencies().Pages() == Routes{"/", "/blog/first", "/blog/second", "/contact"});
+    }
+
+    SECTION("a removed directory drops its pages") {
+        fs::remove_all(root / "pages/blog");
+        REQUIRE(loader.ReloadPages(registry, {path("pages/blog")}) == Routes{"/blog/first", "/blog/second"});
+        REQUIRE(registry.PageRoutes() == Routes{"/", "/about"});
+    }
+
+    SECTION("partials and data reach their dependents") {
+        touch("templates/nav.html", "<nav>v2</nav>");
+        REQUIRE(loader.ReloadPages(registry, {path("templates/nav.html")}) == Routes{"/"});
+        REQUIRE(HtmlRenderer().Render(registry.CreatePage("/")) == "<nav>v2</nav>home");
+
+        touch("data/team.json", R"(["amy","bob"])");
+        REQUIRE(loader.ReloadPages(registry, {path("data/team.json")}) == Routes{"/about"});
+        REQUIRE(HtmlRenderer().Render(registry.CreatePage("/about")) == R"(["amy","bob"])");
+    }
+
+    SECTION("unrelated files change nothing") {
+        REQUIRE(loader.ReloadPages(registry, {path("static/app.css")}).empty());
+        REQUIRE(registry.Version() == version);
+    }
+
+    fs::remove_all(root);
+}
+
+TEST_CASE("TemplatePageLoader reads data files lazily") {
+    auto root = fs::temp_directory_path() / "fwui_loader_lazy";
+    fs::remove_all(root);
+    for (auto dir : {"pages", "data"}) fs::create_directories(root / dir);
+    std::ofstream(root / "pages/index.html") << "{{ name }}: {{ length(team) }}";
+    std::ofstream(root / "pages/about.html") << "{{ name }}";
+    std::ofstream(root / "data/site.json") << R"({"name": "fwui"})";
+    std::ofstream(root / "data/team.json") << R"(["amy", "bob"])";
+    std::ofstream(root / "data/catalog.json") << R"([1, 2, 3])";
+
+    auto path = [&](const char* name) { return (root / name).string(); };
+    Registry registry;
+    TemplatePageLoader loader({.pages_dir     = path("pages"),
+                               .data_dir      = path("data"),
+                               .templates_dir = path("templates"),
+                               .bytecode      = true});
+    loader.LoadPages(registry);
+    const auto& data = loader.Data();
+    REQUIRE(data->Names() == Routes{"catalog", "site", "team"});
+    REQUIRE(data->Loaded() == 0);
+
+    REQUIRE(HtmlRenderer().Render(registry.CreatePage("/about")) == "fwui");
+    REQUIRE(data->Loaded() == 1);  // site.json only
+    REQUIRE(HtmlRenderer().Render(registry.CreatePage("/")) == "fwui: 2");
+    REQUIRE(data->Loaded() == 2);  // catalog.json is never read
+
+    fs::remove_all(root);
+}
+
+TEST_CASE("TemplatePageLoader parallel discovery and preload") {
+    auto root = fs::temp_directory_path() / "fwui_loader_parallel";
+    fs::remove_all(root);
+    for (auto dir : {"pages/docs/guide", "pages/blog", "pages/empty", "data"}) {
+        fs::create_directories(root / dir);
+    }
+    for (auto page : {"pages/index.html", "pages/docs/index.html", "pages/docs/guide/start.html",
+                      "pages/blog/one.html", "pages/blog/two.html"}) {
+        std::ofstream(root / page) << "<p>{{ name }}</p>";
+    }
+    std::ofstream(root / "pages/blog/notes.txt") << "ignored";
+    std::ofstream(root / "data/site.json") << R"({"name": "fwui"})";
+
+    auto path = [&](const char* name) { return (root / name).string(); };
+    Executor executor(2);
+    TemplatePageConfig config{.pages_dir     = path("pages"),
+                              .data_dir      = path("data"),
+                              .templates_dir = path("templates"),
+                              .preload       = true,
+                              .executor      = &executor};
+    TemplatePageLoader loader(config);
+
+    SECTION("ScanPages walks every directory and sorts by path") {
+        auto pages = loader.ScanPages();
+        Routes routes, files;
+        for (const auto& page : pages) {
+            routes.push_back(page.route);
+            files.push_back(page.path);
+        }
+        REQUIRE(routes == Routes{"/blog/one", "/blog/two", "/docs/guide/start", "/docs", "/"});
+        REQUIRE(files.front() == DependencyGraph::Normalize(path("pages/blog/one.html")));
+    }
+
+    SECTION("preloaded pages render without parsing") {
+        Registry registry;
+        REQUIRE(loader.LoadPages(registry).size() == 5);
+        auto stats = loader.Engine()->Stats();
+        REQUIRE(stats.entries == 5);
+        REQUIRE(stats.misses == 5);
+
+        registry.RenderPage("/docs/guide/start");
+        REQUIRE(loader.Engine()->Stats().misses == 5);
+
+        const auto& timings = loader.Timings();
+        REQUIRE(timings.pages == 5);
+        REQUIRE(timings.threads == 2);
+        REQUIRE(timings.total_ms >= timings.compile_ms + timings.preload_ms);
+    }
+
+    SECTION("bytecode pages are compiled instead of preloaded") {
+        Registry registry;
+        config.bytecode = true;
+        TemplatePageLoader native(config);
+        native.LoadPages(registry);
+        REQUIRE(native.Engine()->Stats().entries == 0);
+        REQUIRE(*registry.RenderPage("/blog/two") == "<p>fwui</p>");
+    }
+
+    fs::remove_all(root);
+}
@@ -0,0 +1,205 @@
+#include <catch2/catch_test_macros.hpp>
+#include <fwui/fwui.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+using namespace fwui;
+using json = nlohmann::json;
+
+static std::string run(const std::string& source, const json& data = json::object()) {
+    return TemplateProgram::Compile(source).Render(data);
+}
+
+TEST_CASE("TemplateProgram expressions") {
+    json data = {{"name", "World"}, {"n", 7}, {"price", 2.5}, {"user", {{"role", "admin"}}},
+                 {"tags", {"a", "b", "c"}}, {"empty", ""}, {"nothing", nullptr}};
+
+    SECTION("variables and nested paths") {
+        REQUIRE(run("Hello {{ name }}!", data) == "Hello World!");
+        REQUIRE(run("{{ user.role }} {{ tags.1 }}", data) == "admin b");
+        REQUIRE(run("[{{ nothing }}] {{ price }} {{ tags }}", data) == "[] 2.5 [\"a\",\"b\",\"c\"]");
+    }
+
+    SECTION("operators") {
+        REQUIRE(run("{{ n + 1 }} {{ n - 10 }} {{ n * 2 }} {{ n / 2 }} {{ n % 4 }} {{ 2 ^ 10 }}", data) ==
+                "8 -3 14 3.5 3 1024");
+        REQUIRE(run("{{ name + \"!\" }}", data) == "World!");
+        REQUIRE(run("{{ n > 5 and n < 10 }} {{ not (n == 7) }} {{ \"b\" in tags }}", data) ==
+                "true false true");
+        REQUIRE(run("{{ nothing or n }}", data) == "true");
+    }
+
+    SECTION("functions and filters") {
+        REQUIRE(run("{{ upper(name) }} {{ name | lower }} {{ length(tags) }}", data) == "WORLD world 3");
+        REQUIRE(run("{{ join(tags, \", \") }} | {{ tags | join(\"-\") }}", data) == "a, b, c | a-b-c");
+        REQUIRE(run("{{ default(missing, \"none\") }} {{ missing.deep | default(n) }}", data) == "none 7");
+        REQUIRE(run("{{ exists(\"user.role\") }} {{ existsIn(user, \"x\") }}", data) == "true false");
+        REQUIRE(run("{{ first(tags) }}{{ last(tags) }} {{ round(3.14159, 2) }} {{ range(3) }}", data) ==
+                "ac 3.14 [0,1,2]");
+        REQUIRE(run("{{ first(range(3)) }} {{ length([1, 2]) }} {{ {\"k\": n} }}", data) == "0 2 {\"k\":7}");
+    }
+
+    SECTION("truthiness follows inja") {
+        REQUIRE(run("{% if empty %}y{% else %}n{% endif %}", data) == "y");  // non-null value
+        REQUIRE(run("{% if nothing %}y{% else %}n{% endif %}", data) == "n");
+        REQUIRE(run("{% if tags %}y{% endif %}{% if 0 %}z{% endif %}", data) == "y");
+    }
+
+    SECTION("DataNames lists the top-level names read") {
+        auto names = TemplateProgram::Compile(
+            "{% set x = n %}{{ user.role }}{% for t in tags %}{{ t }}{{ x }}{% endfor %}"
+            "{% if exists(\"site.name\") %}{{ loop_free | default(\"\") }}{% endif %}").DataNames();
+        REQUIRE(names == std::vector<std::string>{"loop_free", "n", "site", "tags", "user"});
+        REQUIRE_FALSE(TemplateProgram::Compile("{{ exists(name) }}").DataNames());
+    }
+
+    SECTION("missing variables throw") {
+        REQUIRE_THROWS_AS(run("{{ missing }}", data), std::runtime_error);
+        REQUIRE_THROWS_AS(run("{{ unknown_fn(1) }}", data), std::runtime_error);
+    }
+}
+
+TEST_CASE("TemplateProgram statements") {
+    json data = {{"items", {{{"name", "a"}, {"tags", {"x", "y"}}}, {{"name", "b"}, {"tags", json::array()}}}},
+                 {"prices", {{"apple", 1}, {"pear", 2}}},
+                 {"level", 2}};
+
+    SECTION("if / else if / else") {
+        auto program = TemplateProgram::Compile(
+            "{% if level == 1 %}one{% else if level == 2 %}two{% else %}many{% endif %}");
+        REQUIRE(program.Render({{"level", 1}}) == "one");
+        REQUIRE(program.Render({{"level", 2}}) == "two");
+        REQUIRE(program.Render({{"level", 5}}) == "many");
+    }
+
+    SECTION("loops with loop variables") {
+        REQUIRE(run("{% for item in items %}{{ loop.index1 }}:{{ item.name }}"
+                    "{% if not loop.is_last %}, {% endif %}{% endfor %}", data) == "1:a, 2:b");
+        REQUIRE(run("{% for item in items %}{% for t in item.tags %}"
+                    "{{ loop.parent.index }}{{ t }}{{ loop.index }} {% endfor %}{% endfor %}", data) ==
+                "0x0 0y1 ");
+        REQUIRE(run("{% for k, v in prices %}{{ k }}={{ v }};{% endfor %}", data) == "apple=1;pear=2;");
+        REQUIRE(run("{% for x in items.1.tags %}never{% endfor %}done", data) == "done");
+        REQUIRE_THROWS(run("{% for x in prices %}{% endfor %}", data));
+    }
+
+    SECTION("set") {
+        REQUIRE(run("{% set total = level * 10 %}{{ total }}/{{ level }}", data) == "20/2");
+        REQUIRE(run("{% for item in items %}{% set last = item.name %}{% endfor %}{{ last }}", data) == "b");
+    }
+
+    SECTION("whitespace control, comments and raw") {
+        REQUIRE(run("<ul>\n  {%- for item in items %}\n  <li>{{ item.name }}</li>\n  {%- endfor %}\n</ul>",
+                    data) == "<ul>\n  <li>a</li>\n  <li>b</li>\n</ul>");
+        REQUIRE(run("a {# note #}b {%- if true -%}   c{% endif %}") == "a bc");
+        REQUIRE(run("{% raw %}{{ not parsed }}{% endraw %}") == "{{ not parsed }}");
+    }
+
+    SECTION("syntax errors name the line") {
+        std::string message;
+        try {
+            TemplateProgram::Compile("line 1\n{% if x %}\nno end");
+        } catch (const std::runtime_error& e) {
+            message = e.what();
+        }
+        REQUIRE(message.find("line 3") != std::string::npos);
+        REQUIRE_THROWS(TemplateProgram::Compile("{% macro m() %}{% endmacro %}"));
+        REQUIRE_THROWS(TemplateProgram::Compile("{{ a +}}"));
+    }
+}
+
+TEST_CASE("TemplateProgram escaping and callbacks") {
+    json data = {{"html", "<b>\"hi\" & 'bye'</b>"}};
+
+    SECTION("output is raw unless autoescape is on") {
+        REQUIRE(run("{{ html }}", data) == "<b>\"hi\" & 'bye'</b>");
+        REQUIRE(run("{{ escape(html) }}", data) == "&lt;b&gt;&quot;hi&quot; &amp; &#39;bye&#39;&lt;/b&gt;");
+
+        TemplateProgram::Options opts;
+        opts.autoescape = true;
+        auto program = TemplateProgram::Compile("{{ html }}|{{ html | safe }}|{{ \"<i>\" }}", opts);
+        REQUIRE(program.Render(data) ==
+                "&lt;b&gt;&quot;hi&quot; &amp; &#39;bye&#39;&lt;/b&gt;|<b>\"hi\" & 'bye'</b>|&lt;i&gt;");
+    }
+
+    SECTION("unknown functions call the supplied callbacks") {
+        TemplateEngine::Functions functions;
+        functions["greet"] = [](TemplateEngine::Arguments& args) {
+            return "hi " + args.at(0)->get<std::string>();
+        };
+        auto program = TemplateProgram::Compile("{{ greet(\"bob\") }} {{ \"amy\" | greet }}");
+        REQUIRE(program.Render(data, &functions) == "hi bob hi amy");
+        REQUIRE_THROWS(program.Render(data));
+    }
+
+    SECTION("engine callbacks include bound components") {
+        Registry registry;
+        int runs = 0;
+        registry.RegisterComponent("footer", [&](const json& d) {
+            runs++;
+            return footer({text(d.is_object() ? d.value("note", "") : "fwui")});
+        }, Registry::Memo::ByData);
+        TemplateEngine engine;
+        engine.BindComponents(registry);
+
+        TemplateProgram::Options opts;
+        opts.autoescape = true;
+        auto program = TemplateProgram::Compile("{{ component(\"footer\") | safe }}", opts);
+        for (int i = 0; i < 3; ++i) {
+            REQUIRE(program.Render(data, engine.Callbacks().get()) == "<footer>fwui</footer>");
+        }
+        REQUIRE(runs == 1);
+        REQUIRE(TemplateProgram::Compile("{{ component(\"footer\", {\"note\": \"x\"}) }}")
+                    .Render(data, engine.Callbacks().get()) == "<footer>x</footer>");
+    }
+}
+
+TEST_CASE("TemplateProgram includes and serialization") {
+    namespace fs = std::filesystem;
+    auto dir = fs::temp_directory_path() / "fwui_template_vm";
+    fs::create_directories(dir);
+    std::ofstream(dir / "item.html", std::ios::trunc) << "<li>{{ loop.index1 }}. {{ item }}</li>";
+    std::ofstream(dir / "page.html", std::ios::trunc)
+        << "<h1>{{ title }}</h1><ul>{% for item in items %}{% include \"item.html\" %}{% endfor %}</ul>";
+    std::ofstream(dir / "loop.html", std::ios::trunc) << "{% include \"loop.html\" %}";
+
+    TemplateProgram::Options opts;
+    opts.template_dir = dir.string();
+    json data = {{"title", "List"}, {"items", {"x", "y"}}};
+    const std::string expected = "<h1>List</h1><ul><li>1. x</li><li>2. y</li></ul>";
+
+    SECTION("includes are inlined and see loop variables") {
+        auto program = TemplateProgram::CompileFile("page.html", opts);
+        REQUIRE(program.Render(data) == expected);
+        REQUIRE(program.Includes() == std::vector<std::string>{(dir / "item.html").string()});
+        REQUIRE_THROWS(TemplateProgram::CompileFile("loop.html", opts));
+    }
+
+    SECTION("serialized programs render the same") {
+        auto bytes = TemplateProgram::CompileFile("page.html", opts).Serialize();
+        fs::remove(dir / "item.html");  // nothing is read at load time
+        auto loaded = TemplateProgram::Deserialize(bytes);
+        REQUIRE(loaded.Render(data) == expected);
+        REQUIRE(loaded.Serialize() == bytes);
+    }
+
+    SECTION("corrupted bytecode is rejected") {
+        auto bytes = TemplateProgram::CompileFile("page.html", opts).Serialize();
+        REQUIRE_THROWS(TemplateProgram::Deserialize(bytes.substr(0, bytes.size() - 1)));
+        REQUIRE_THROWS(TemplateProgram::Deserialize("FWTC"));
+        auto bad = bytes;
+        bad[20] = static_cast<char>(0xFF);  // first opcode
+        REQUIRE_THROWS(TemplateProgram::Deserialize(bad));
+    }
+
+    SECTION("RenderTo streams into an ostream") {
+        std::ostringstream out;
+        TemplateProgram::CompileFile("page.html", opts).RenderTo(out, data);
+        REQUIRE(out.str() == expected);
+    }
+
+    fs::remove_all(dir);
+}